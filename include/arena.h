@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// For solvers that make lots of little nodes and throw them all away at the end (day07's directory tree, day20's list)
+// Arena:   a monotonic bump allocator. Nodes sit one after another in big blocks, freeing one does nothing,
+//          everything goes at once with the arena (or release()), which runs the destructors make() needs, newest first
+//          It's a std::pmr::memory_resource too, so std::pmr containers can keep their nodes in it
+// Pool<T>: a free list of T sized slots taken from its own arena, for nodes that come and go (day17's rocks)
+//          destroy() puts a slot back for the next make()
+namespace mem
+{
+    class Arena : public std::pmr::memory_resource
+    {
+    public:
+        // blockSize for the first block, each one after is twice the last up to maxBlockSize
+        explicit Arena(size_t blockSize = 4096, std::pmr::memory_resource *upstream = std::pmr::get_default_resource()) :
+            m_nextBlockSize{ std::max(blockSize, sizeof(Block) + alignof(std::max_align_t)) },
+            m_upstream{ upstream }
+        {
+        }
+
+        ~Arena() override { release(); }
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        static constexpr size_t maxBlockSize{ 1 << 20 };
+
+        template<typename T, typename... Args>
+        T* make(Args&&... args)
+        {
+            if constexpr (std::is_trivially_destructible_v<T>)
+            {
+                return ::new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            }
+            else
+            {
+                // Only put on the list once it's constructed, so nothing's destroyed that never was if the constructor throws
+                void *cleanup{ allocate(sizeof(Cleanup), alignof(Cleanup)) };
+                T *object{ ::new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...) };
+                m_cleanups = ::new (cleanup) Cleanup{ [](void *p) { static_cast<T*>(p)->~T(); }, object, m_cleanups };
+                return object;
+            }
+        }
+
+        // Destroys everything from make() and gives the blocks back, the arena can be used again after
+        void release()
+        {
+            for (Cleanup *cleanup{ m_cleanups }; cleanup; cleanup = cleanup->next)
+            {
+                cleanup->destroy(cleanup->object);
+            }
+            m_cleanups = nullptr;
+
+            while (m_blocks)
+            {
+                Block *next{ m_blocks->next };
+                m_upstream->deallocate(m_blocks, m_blocks->size, alignof(std::max_align_t));
+                m_blocks = next;
+            }
+            m_current = nullptr;
+            m_end = nullptr;
+            m_used = 0;
+        }
+
+        // Bytes handed out since the last release, not counting any padding for alignment
+        size_t used() const { return m_used; }
+
+    private:
+        struct Block
+        {
+            Block *next;
+            size_t size;
+        };
+
+        struct Cleanup
+        {
+            void (*destroy)(void*);
+            void *object;
+            Cleanup *next;
+        };
+
+        std::byte *m_current{ nullptr };
+        std::byte *m_end{ nullptr };
+        Block *m_blocks{ nullptr };
+        Cleanup *m_cleanups{ nullptr };
+        size_t m_nextBlockSize;
+        size_t m_used{ 0 };
+        std::pmr::memory_resource *m_upstream;
+
+        void* do_allocate(size_t bytes, size_t alignment) override
+        {
+            void *p{ m_current };
+            size_t space{ static_cast<size_t>(m_end - m_current) };
+            if (!p || !std::align(alignment, bytes, p, space))
+            {
+                newBlock(bytes + alignment);
+                p = m_current;
+                space = static_cast<size_t>(m_end - m_current);
+                std::align(alignment, bytes, p, space);
+            }
+
+            m_current = static_cast<std::byte*>(p) + bytes;
+            m_used += bytes;
+            return p;
+        }
+
+        // Nothing until release()
+        void do_deallocate(void*, size_t, size_t) override {}
+
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+        // At least bytes free in it, anything left in the last block's wasted
+        void newBlock(size_t bytes)
+        {
+            const size_t size{ std::max(m_nextBlockSize, sizeof(Block) + bytes) };
+            Block *block{ ::new (m_upstream->allocate(size, alignof(std::max_align_t))) Block{ m_blocks, size } };
+            m_blocks = block;
+            m_current = reinterpret_cast<std::byte*>(block + 1);
+            m_end = reinterpret_cast<std::byte*>(block) + size;
+            m_nextBlockSize = std::min(m_nextBlockSize * 2, std::max(maxBlockSize, m_nextBlockSize));
+        }
+    };
+
+    // What's still alive when the pool goes isn't destroyed, just freed with the rest, so only for trivially destructible Ts
+    template<typename T>
+    class Pool
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "Pool doesn't destroy what's left at the end, use Arena::make for T with a destructor");
+
+    public:
+        // blockSize in Ts
+        explicit Pool(size_t blockSize = 256) : m_arena{ blockSize * slotSize } {}
+
+        template<typename... Args>
+        T* make(Args&&... args)
+        {
+            void *slot{ m_free };
+            if (m_free)
+            {
+                m_free = m_free->next;
+            }
+            else
+            {
+                slot = m_arena.allocate(slotSize, slotAlign);
+            }
+
+            ++m_live;
+            return ::new (slot) T(std::forward<Args>(args)...);
+        }
+
+        void destroy(T *object)
+        {
+            object->~T();
+            m_free = ::new (static_cast<void*>(object)) FreeSlot{ m_free };
+            --m_live;
+        }
+
+        // Made and not destroyed yet
+        size_t live() const { return m_live; }
+
+    private:
+        struct FreeSlot
+        {
+            FreeSlot *next;
+        };
+
+        static constexpr size_t slotSize{ std::max(sizeof(T), sizeof(FreeSlot)) };
+        static constexpr size_t slotAlign{ std::max(alignof(T), alignof(FreeSlot)) };
+
+        Arena m_arena;
+        FreeSlot *m_free{ nullptr };
+        size_t m_live{ 0 };
+    };
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+#include "timer.h"
+
+namespace benchmark
+{
+    // Summary of repeated timings, all in seconds
+    struct Stats
+    {
+        size_t count{ 0 };
+        double min{ 0.0 };
+        double median{ 0.0 };
+        double p95{ 0.0 };
+        double mean{ 0.0 };
+        double stddev{ 0.0 }; // Sample standard deviation
+
+        static Stats from(std::vector<double> samples)
+        {
+            Stats stats;
+            stats.count = samples.size();
+            if (samples.empty())
+                return stats;
+
+            std::sort(samples.begin(), samples.end());
+
+            const size_t n{ samples.size() };
+            stats.min = samples.front();
+            stats.median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2.0;
+            // Nearest rank
+            stats.p95 = samples[static_cast<size_t>(std::ceil(0.95 * static_cast<double>(n))) - 1];
+            stats.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(n);
+
+            if (n > 1)
+            {
+                double squares{ 0.0 };
+                for (double sample : samples)
+                {
+                    squares += (sample - stats.mean) * (sample - stats.mean);
+                }
+                stats.stddev = std::sqrt(squares / static_cast<double>(n - 1));
+            }
+            return stats;
+        }
+    };
+
+    // Time fnc repetitions times after warmups untimed calls
+    template<typename Fnc>
+    std::vector<double> repeat(Fnc &&fnc, int repetitions, int warmups = 1)
+    {
+        for (int i{ 0 }; i < warmups; ++i)
+        {
+            fnc();
+        }
+
+        std::vector<double> samples;
+        samples.reserve(static_cast<size_t>(repetitions));
+        for (int i{ 0 }; i < repetitions; ++i)
+        {
+            Timer timer;
+            fnc();
+            samples.push_back(timer.elapsed());
+        }
+        return samples;
+    }
+};
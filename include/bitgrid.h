@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// A grid of bits, each row packed into uint64_t words (bit x of a row is bit x % 64 of word x / 64)
+// For occupancy that's tested and set a cell at a time like a set of coords would be,
+// or worked on a whole row (or grid) at once: shifts, and / or / and not, counts and iterating the set bits
+// Bits past the width are always kept 0, so counts and comparisons can go a word at a time
+class BitGrid
+{
+public:
+    using word_t = std::uint64_t;
+    static constexpr int wordBits{ 64 };
+
+    BitGrid() = default;
+
+    BitGrid(int width, int height) :
+        m_width{ width }, m_height{ height },
+        m_words{ static_cast<size_t>((width + wordBits - 1) / wordBits) },
+        m_bits(m_words * static_cast<size_t>(height), 0)
+    {
+    }
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    size_t wordsPerRow() const { return m_words; }
+
+    bool inBounds(int x, int y) const { return x >= 0 && y >= 0 && x < m_width && y < m_height; }
+
+    bool test(int x, int y) const { return (word(x, y) >> (x % wordBits)) & 1; }
+    void set(int x, int y) { word(x, y) |= bit(x); }
+    void reset(int x, int y) { word(x, y) &= ~bit(x); }
+
+    // Empty rows added to the end, or taken off it
+    void resize(int height)
+    {
+        m_height = height;
+        m_bits.resize(m_words * static_cast<size_t>(height), 0);
+    }
+
+    void clear() { std::fill(m_bits.begin(), m_bits.end(), 0); }
+
+    std::span<word_t> row(int y) { return { m_bits.data() + static_cast<size_t>(y) * m_words, m_words }; }
+    std::span<const word_t> row(int y) const { return { m_bits.data() + static_cast<size_t>(y) * m_words, m_words }; }
+
+    size_t count() const { return count(m_bits); }
+    size_t count(int y) const { return count(row(y)); }
+
+    bool any(int y) const
+    {
+        const auto words{ row(y) };
+        return std::any_of(words.begin(), words.end(), [](word_t w) { return w != 0; });
+    }
+
+    // fnc(x) for each set bit in row y, lowest x first
+    template<typename Fnc>
+    void forEachSet(int y, Fnc &&fnc) const
+    {
+        const auto words{ row(y) };
+        for (size_t i{ 0 }; i < words.size(); ++i)
+        {
+            for (word_t w{ words[i] }; w; w &= w - 1)
+            {
+                fnc(static_cast<int>(i) * wordBits + std::countr_zero(w));
+            }
+        }
+    }
+
+    // fnc(x, y) for every set bit
+    template<typename Fnc>
+    void forEachSet(Fnc &&fnc) const
+    {
+        for (int y{ 0 }; y < m_height; ++y)
+        {
+            forEachSet(y, [&fnc, y](int x) { fnc(x, y); });
+        }
+    }
+
+    // The same size grids only
+    BitGrid& operator|=(const BitGrid &rhs) { return combine(rhs, [](word_t a, word_t b) { return a | b; }); }
+    BitGrid& operator&=(const BitGrid &rhs) { return combine(rhs, [](word_t a, word_t b) { return a & b; }); }
+    BitGrid& andNot(const BitGrid &rhs) { return combine(rhs, [](word_t a, word_t b) { return a & ~b; }); }
+
+    friend bool operator==(const BitGrid &lhs, const BitGrid &rhs) { return lhs.m_width == rhs.m_width && lhs.m_bits == rhs.m_bits; }
+
+    // Or in src with every bit moved dx along its row (to higher x when positive) and dy rows (to higher y), what goes off the edge is lost
+    void orShifted(const BitGrid &src, int dx, int dy)
+    {
+        forShiftedRows(*this, src, dx, dy, [](std::span<word_t> out, std::span<const word_t> in)
+            {
+                for (size_t i{ 0 }; i < out.size(); ++i) out[i] |= in[i];
+            });
+    }
+
+    // How many bits are set in both this and src shifted by dx, dy
+    size_t countAndShifted(const BitGrid &src, int dx, int dy) const
+    {
+        size_t total{ 0 };
+        forShiftedRows(*this, src, dx, dy, [&total](std::span<const word_t> out, std::span<const word_t> in)
+            {
+                for (size_t i{ 0 }; i < out.size(); ++i) total += static_cast<size_t>(std::popcount(out[i] & in[i]));
+            });
+        return total;
+    }
+
+    // Every set bit carried on dx along its row and dy rows at a time for as long as it can go, stopped by blocked bits and the edges
+    // A flood fill in one direction, a row (of words) at a time: with dy the rows are gone through in the direction
+    // things move so each row's done after the one it's fed from, along a row it's shift and or until nothing changes
+    void spread(int dx, int dy, const BitGrid &blocked)
+    {
+        std::vector<word_t> shifted(m_words);
+        const auto step{ [&](std::span<word_t> out, std::span<const word_t> in, std::span<const word_t> walls)
+            {
+                shiftRow(in, dx, shifted);
+                shifted.back() &= tailMask();
+                bool bChanged{ false };
+                for (size_t i{ 0 }; i < m_words; ++i)
+                {
+                    const word_t grown{ out[i] | (shifted[i] & ~walls[i]) };
+                    bChanged |= grown != out[i];
+                    out[i] = grown;
+                }
+                return bChanged;
+            } };
+
+        if (!dy)
+        {
+            for (int y{ 0 }; y < m_height; ++y)
+            {
+                while (step(row(y), row(y), blocked.row(y)));
+            }
+        }
+        else if (dy > 0)
+        {
+            for (int y{ dy }; y < m_height; ++y)
+            {
+                step(row(y), row(y - dy), blocked.row(y));
+            }
+        }
+        else
+        {
+            for (int y{ m_height - 1 + dy }; y >= 0; --y)
+            {
+                step(row(y), row(y - dy), blocked.row(y));
+            }
+        }
+    }
+
+    // out = in shifted n bits to higher x (lower when n's negative), for rows of the same number of words
+    static void shiftRow(std::span<const word_t> in, int n, std::span<word_t> out)
+    {
+        const auto words{ static_cast<std::ptrdiff_t>(in.size()) };
+        const std::ptrdiff_t wordShift{ (n < 0 ? -n : n) / wordBits };
+        const int bitShift{ (n < 0 ? -n : n) % wordBits };
+
+        for (std::ptrdiff_t i{ 0 }; i < words; ++i)
+        {
+            // Where the bits for word i come from, and the word below / above that for what crosses the boundary
+            const std::ptrdiff_t from{ n >= 0 ? i - wordShift : i + wordShift };
+            const std::ptrdiff_t carry{ n >= 0 ? from - 1 : from + 1 };
+            const word_t main{ from >= 0 && from < words ? in[static_cast<size_t>(from)] : 0 };
+            const word_t spill{ bitShift && carry >= 0 && carry < words ? in[static_cast<size_t>(carry)] : 0 };
+
+            if (n >= 0)
+                out[static_cast<size_t>(i)] = main << bitShift | (bitShift ? spill >> (wordBits - bitShift) : 0);
+            else
+                out[static_cast<size_t>(i)] = main >> bitShift | (bitShift ? spill << (wordBits - bitShift) : 0);
+        }
+    }
+
+private:
+    int m_width{ 0 };
+    int m_height{ 0 };
+    size_t m_words{ 0 };
+    std::vector<word_t> m_bits;
+
+    static word_t bit(int x) { return word_t{ 1 } << (x % wordBits); }
+    word_t& word(int x, int y) { return m_bits[static_cast<size_t>(y) * m_words + static_cast<size_t>(x / wordBits)]; }
+    const word_t& word(int x, int y) const { return m_bits[static_cast<size_t>(y) * m_words + static_cast<size_t>(x / wordBits)]; }
+
+    static size_t count(std::span<const word_t> words)
+    {
+        size_t total{ 0 };
+        for (const word_t w : words)
+        {
+            total += static_cast<size_t>(std::popcount(w));
+        }
+        return total;
+    }
+
+    // The bits past the width in the last word of a row
+    word_t tailMask() const { return m_width % wordBits ? (word_t{ 1 } << (m_width % wordBits)) - 1 : ~word_t{ 0 }; }
+
+    template<typename Op>
+    BitGrid& combine(const BitGrid &rhs, Op op)
+    {
+        for (size_t i{ 0 }; i < m_bits.size(); ++i)
+        {
+            m_bits[i] = op(m_bits[i], rhs.m_bits[i]);
+        }
+        return *this;
+    }
+
+    // fnc(row of grid, src's row dy before it shifted by dx) for every row that has one, grid's this or a const this
+    template<typename Self, typename Fnc>
+    static void forShiftedRows(Self &grid, const BitGrid &src, int dx, int dy, Fnc &&fnc)
+    {
+        std::vector<word_t> shifted(grid.m_words);
+        for (int y{ std::max(0, dy) }; y < std::min(grid.m_height, src.m_height + dy); ++y)
+        {
+            if (dx)
+            {
+                shiftRow(src.row(y - dy), dx, shifted);
+                shifted.back() &= grid.tailMask();
+                fnc(grid.row(y), std::span<const word_t>{ shifted });
+            }
+            else
+            {
+                fnc(grid.row(y), src.row(y - dy));
+            }
+        }
+    }
+};
@@ -7,14 +7,25 @@
 // Debug macros - DOUT, DLN can be toggled on or off, DERR prints in RED text!
 # define DERR(x) std::cerr << "\033[31m" << x << "\033[0m";
 	
+// Release builds (-DNDEBUG, or -DAOC_DEBUG=0 to choose) compile DOUT, DP and DL out completely, -d does nothing then
+// if constexpr still type checks what they'd print, so a release build can't break the debug one
+#ifndef AOC_DEBUG
+# ifdef NDEBUG
+#  define AOC_DEBUG 0
+# else
+#  define AOC_DEBUG 1
+# endif
+#endif
+
 namespace debug
 {
-	bool bPrintEnabled{ true }; // Toggle DOUT when needed
+	inline bool bPrintEnabled{ true }; // Toggle DOUT when needed
+	inline constexpr bool bCompiledIn{ AOC_DEBUG != 0 };
 }
 
-# define DOUT if(flags::isSet(flags::Flag::debug)) std::cout
-# define DP(x) if (flags::isSet(flags::Flag::debug) && debug::bPrintEnabled) { std::cout << x; }
-# define DL(x) if (flags::isSet(flags::Flag::debug) && debug::bPrintEnabled) { std::cout << x << '\n'; }
+# define DOUT if constexpr (debug::bCompiledIn) if (flags::isSet(flags::Flag::debug)) std::cout
+# define DP(x) if constexpr (debug::bCompiledIn) { if (flags::isSet(flags::Flag::debug) && debug::bPrintEnabled) { std::cout << x; } }
+# define DL(x) if constexpr (debug::bCompiledIn) { if (flags::isSet(flags::Flag::debug) && debug::bPrintEnabled) { std::cout << x << '\n'; } }
 
 # define DTOGGLE debug::bPrintEnabled = !debug::bPrintEnabled;
 # define DENABLE debug::bPrintEnabled = true;
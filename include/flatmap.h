@@ -0,0 +1,448 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+# include <immintrin.h>
+#endif
+
+#include "vector2d.h" // vec::mix
+
+// Open addressing hash map and set for the hot lookups, SwissTable style:
+// every slot has a control byte, empty, deleted, or 7 bits of the key's hash when it's full
+// A lookup checks 16 control bytes at once (SSE2 when the compiler targets it, a plain loop elsewise)
+// and only compares keys where those 7 bits match, so a miss hardly ever touches a key at all
+// Slots are one flat vector, no node per entry like std::map / std::unordered_map
+// Keys and values need to be default constructible, and the order things come out in is whatever the hashes make it
+// The hash is mixed again on the way in, so std::hash<int> (which does nothing on libstdc++) is fine to use
+namespace flat
+{
+    namespace detail
+    {
+        using ctrl_t = std::int8_t;
+        inline constexpr ctrl_t ctrlEmpty{ -128 };
+        inline constexpr ctrl_t ctrlDeleted{ -2 };
+        inline constexpr size_t groupSize{ 16 };
+
+        // A bit for each of a group's control bytes that's what was asked for
+        class Group
+        {
+        public:
+            explicit Group(const ctrl_t *ctrl)
+#if defined(__SSE2__)
+                : m_ctrl{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl)) } {}
+#else
+                : m_ctrl{ ctrl } {}
+#endif
+
+            std::uint32_t match(ctrl_t h2) const
+            {
+#if defined(__SSE2__)
+                return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), m_ctrl)));
+#else
+                return matchIf([h2](ctrl_t ctrl) { return ctrl == h2; });
+#endif
+            }
+
+            std::uint32_t matchEmpty() const
+            {
+#if defined(__SSE2__)
+                return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(ctrlEmpty), m_ctrl)));
+#else
+                return matchIf([](ctrl_t ctrl) { return ctrl == ctrlEmpty; });
+#endif
+            }
+
+            // Empty or deleted, the only negative ones, so it's just the top bits
+            std::uint32_t matchFree() const
+            {
+#if defined(__SSE2__)
+                return static_cast<std::uint32_t>(_mm_movemask_epi8(m_ctrl));
+#else
+                return matchIf([](ctrl_t ctrl) { return ctrl < 0; });
+#endif
+            }
+
+        private:
+#if defined(__SSE2__)
+            __m128i m_ctrl;
+#else
+            const ctrl_t *m_ctrl;
+
+            template<typename Pred>
+            std::uint32_t matchIf(Pred pred) const
+            {
+                std::uint32_t mask{ 0 };
+                for (size_t i{ 0 }; i < groupSize; ++i)
+                {
+                    mask |= static_cast<std::uint32_t>(pred(m_ctrl[i])) << i;
+                }
+                return mask;
+            }
+#endif
+        };
+
+        // Everything that's the same for the map and the set, KeyOf gets the key from a slot
+        template<typename Key, typename Slot, typename KeyOf, typename Hash, typename Eq>
+        class Table
+        {
+        public:
+            using key_type = Key;
+            using value_type = Slot;
+            using size_type = size_t;
+
+            template<bool bConst>
+            class Iterator
+            {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = Slot;
+                using difference_type = std::ptrdiff_t;
+                using pointer = std::conditional_t<bConst, const Slot*, Slot*>;
+                using reference = std::conditional_t<bConst, const Slot&, Slot&>;
+                using table_t = std::conditional_t<bConst, const Table, Table>;
+
+                Iterator() = default;
+                Iterator(table_t *table, size_t index) : m_table{ table }, m_index{ index } { skipFree(); }
+
+                // iterator to const_iterator
+                operator Iterator<true>() const { return { m_table, m_index }; }
+
+                reference operator*() const { return m_table->m_slots[m_index]; }
+                pointer operator->() const { return &m_table->m_slots[m_index]; }
+
+                Iterator& operator++()
+                {
+                    ++m_index;
+                    skipFree();
+                    return *this;
+                }
+
+                Iterator operator++(int)
+                {
+                    Iterator was{ *this };
+                    ++*this;
+                    return was;
+                }
+
+                friend bool operator==(const Iterator &lhs, const Iterator &rhs) { return lhs.m_index == rhs.m_index; }
+
+            private:
+                friend class Table;
+
+                table_t *m_table{ nullptr };
+                size_t m_index{ 0 };
+
+                void skipFree()
+                {
+                    while (m_index < m_table->m_slots.size() && m_table->m_ctrl[m_index] < 0)
+                    {
+                        ++m_index;
+                    }
+                }
+            };
+
+            using iterator = Iterator<false>;
+            using const_iterator = Iterator<true>;
+
+            Table() = default;
+
+            explicit Table(size_t count) { reserve(count); }
+
+            iterator begin() { return { this, 0 }; }
+            iterator end() { return { this, m_slots.size() }; }
+            const_iterator begin() const { return { this, 0 }; }
+            const_iterator end() const { return { this, m_slots.size() }; }
+
+            size_t size() const { return m_size; }
+            bool empty() const { return !m_size; }
+            size_t capacity() const { return m_slots.size(); }
+
+            void clear()
+            {
+                std::fill(m_ctrl.begin(), m_ctrl.end(), ctrlEmpty);
+                std::fill(m_slots.begin(), m_slots.end(), Slot{});
+                m_size = 0;
+                m_growthLeft = maxLoad(m_slots.size());
+            }
+
+            // Room for count without growing
+            void reserve(size_t count)
+            {
+                if (count > maxLoad(m_slots.size()))
+                {
+                    rehash(capacityFor(count));
+                }
+            }
+
+            iterator find(const Key &key) { return { this, findIndex(key) }; }
+            const_iterator find(const Key &key) const { return { this, findIndex(key) }; }
+
+            bool contains(const Key &key) const { return findIndex(key) != m_slots.size(); }
+            size_t count(const Key &key) const { return contains(key); }
+
+            // How many were erased, 0 or 1
+            size_t erase(const Key &key)
+            {
+                const size_t index{ findIndex(key) };
+                if (index == m_slots.size())
+                    return 0;
+
+                eraseAt(index);
+                return 1;
+            }
+
+            iterator erase(const_iterator it)
+            {
+                eraseAt(it.m_index);
+                return { this, it.m_index + 1 };
+            }
+
+        protected:
+            // The slot for key, made with makeSlot() if it isn't there yet (true if it was made)
+            template<typename MakeSlot>
+            std::pair<iterator, bool> findOrInsert(const Key &key, MakeSlot &&makeSlot)
+            {
+                const size_t hash{ hashOf(key) };
+                if (const size_t index{ findIndex(key, hash) }; index != m_slots.size())
+                {
+                    return { { this, index }, false };
+                }
+
+                if (m_slots.empty())
+                {
+                    rehash(capacityFor(1));
+                }
+
+                size_t index{ freeIndex(hash) };
+                // Reusing a deleted slot doesn't use up any room, an empty one does
+                if (!m_growthLeft && m_ctrl[index] == ctrlEmpty)
+                {
+                    rehash(capacityFor(m_size + 1));
+                    index = freeIndex(hash);
+                }
+
+                m_growthLeft -= m_ctrl[index] == ctrlEmpty;
+                m_ctrl[index] = h2(hash);
+                m_slots[index] = makeSlot();
+                ++m_size;
+                return { { this, index }, true };
+            }
+
+        private:
+            std::vector<ctrl_t> m_ctrl;
+            std::vector<Slot> m_slots;
+            size_t m_size{ 0 };
+            size_t m_growthLeft{ 0 };
+
+            [[no_unique_address]] Hash m_hash{};
+            [[no_unique_address]] Eq m_eq{};
+            [[no_unique_address]] KeyOf m_keyOf{};
+
+            // 7/8 full before growing
+            static size_t maxLoad(size_t capacity) { return capacity - capacity / 8; }
+
+            static size_t capacityFor(size_t count)
+            {
+                return std::bit_ceil(std::max(groupSize, (count * 8 + 6) / 7));
+            }
+
+            size_t hashOf(const Key &key) const { return vec::mix(static_cast<std::uint64_t>(m_hash(key))); }
+            static ctrl_t h2(size_t hash) { return static_cast<ctrl_t>(hash & 0x7F); }
+            size_t groups() const { return m_slots.size() / groupSize; }
+
+            static constexpr size_t probeOn{ static_cast<size_t>(-1) };
+
+            // Whole groups at a time, jumping 1, 2, 3... groups on from the one the hash starts at
+            // (which visits every group when there's a power of 2 of them) until fnc(first slot, group) says anything but probeOn
+            template<typename Fnc>
+            size_t probe(size_t hash, Fnc &&fnc) const
+            {
+                const size_t mask{ groups() - 1 };
+                size_t group{ (hash >> 7) & mask };
+                for (size_t step{ 1 }; ; ++step)
+                {
+                    const size_t first{ group * groupSize };
+                    if (const size_t found{ fnc(first, Group{ m_ctrl.data() + first }) }; found != probeOn)
+                    {
+                        return found;
+                    }
+                    group = (group + step) & mask;
+                }
+            }
+
+            size_t findIndex(const Key &key) const { return findIndex(key, hashOf(key)); }
+
+            // The key's slot, or size() if it's not there
+            size_t findIndex(const Key &key, size_t hash) const
+            {
+                if (m_slots.empty())
+                    return 0;
+
+                const ctrl_t tag{ h2(hash) };
+                return probe(hash, [&](size_t first, const Group &group)
+                    {
+                        for (std::uint32_t match{ group.match(tag) }; match; match &= match - 1)
+                        {
+                            const size_t index{ first + static_cast<size_t>(std::countr_zero(match)) };
+                            if (m_eq(m_keyOf(m_slots[index]), key))
+                                return index;
+                        }
+                        // It would have gone in an empty slot if there was one, so it's not anywhere further on
+                        return group.matchEmpty() ? m_slots.size() : probeOn;
+                    });
+            }
+
+            // First empty or deleted slot along hash's probe, there's always one since the table's never full
+            size_t freeIndex(size_t hash) const
+            {
+                return probe(hash, [](size_t first, const Group &group)
+                    {
+                        const std::uint32_t free{ group.matchFree() };
+                        return free ? first + static_cast<size_t>(std::countr_zero(free)) : probeOn;
+                    });
+            }
+
+            void eraseAt(size_t index)
+            {
+                // If the group's got an empty slot no probe ever went past it, so this one can go back to empty rather than deleted
+                const size_t first{ index - index % groupSize };
+                const bool bEmptyNearby{ Group{ m_ctrl.data() + first }.matchEmpty() != 0 };
+                m_ctrl[index] = bEmptyNearby ? ctrlEmpty : ctrlDeleted;
+                m_growthLeft += bEmptyNearby;
+                m_slots[index] = Slot{};
+                --m_size;
+            }
+
+            void rehash(size_t capacity)
+            {
+                std::vector<ctrl_t> oldCtrl(capacity, ctrlEmpty);
+                std::vector<Slot> oldSlots(capacity);
+                oldCtrl.swap(m_ctrl);
+                oldSlots.swap(m_slots);
+                m_growthLeft = maxLoad(capacity) - m_size;
+
+                for (size_t i{ 0 }; i < oldSlots.size(); ++i)
+                {
+                    if (oldCtrl[i] >= 0)
+                    {
+                        const size_t hash{ hashOf(m_keyOf(oldSlots[i])) };
+                        const size_t index{ freeIndex(hash) };
+                        m_ctrl[index] = h2(hash);
+                        m_slots[index] = std::move(oldSlots[i]);
+                    }
+                }
+            }
+        };
+
+        struct PairKey
+        {
+            template<typename Pair>
+            const auto& operator()(const Pair &pair) const { return pair.first; }
+        };
+
+        struct SelfKey
+        {
+            template<typename Key>
+            const Key& operator()(const Key &key) const { return key; }
+        };
+    };
+
+    // std::hash doesn't do pairs
+    struct PairHash
+    {
+        template<typename A, typename B>
+        size_t operator()(const std::pair<A, B> &pair) const
+        {
+            return vec::mix(static_cast<std::uint64_t>(std::hash<A>{}(pair.first))) ^ std::hash<B>{}(pair.second);
+        }
+    };
+
+    // The key's mutable through an iterator (the set's too), but changing it loses the entry
+    template<typename Key, typename Value, typename Hash = std::hash<Key>, typename Eq = std::equal_to<Key>>
+    class Map : public detail::Table<Key, std::pair<Key, Value>, detail::PairKey, Hash, Eq>
+    {
+        using base_t = detail::Table<Key, std::pair<Key, Value>, detail::PairKey, Hash, Eq>;
+
+    public:
+        using mapped_type = Value;
+        using typename base_t::iterator;
+        using base_t::base_t;
+
+        Map(std::initializer_list<std::pair<Key, Value>> pairs)
+        {
+            this->reserve(pairs.size());
+            for (const auto &pair : pairs)
+            {
+                insert(pair);
+            }
+        }
+
+        Value& operator[](const Key &key)
+        {
+            return this->findOrInsert(key, [&key]() { return std::pair<Key, Value>{ key, Value{} }; }).first->second;
+        }
+
+        Value& at(const Key &key)
+        {
+            const auto found{ this->find(key) };
+            if (found == this->end())
+                throw std::out_of_range{ "flat::Map::at: key not found" };
+            return found->second;
+        }
+
+        const Value& at(const Key &key) const
+        {
+            const auto found{ this->find(key) };
+            if (found == this->end())
+                throw std::out_of_range{ "flat::Map::at: key not found" };
+            return found->second;
+        }
+
+        // Doesn't replace what's already there, same as std::map
+        std::pair<iterator, bool> insert(const std::pair<Key, Value> &pair)
+        {
+            return this->findOrInsert(pair.first, [&pair]() { return pair; });
+        }
+
+        template<typename... Args>
+        std::pair<iterator, bool> try_emplace(const Key &key, Args&&... args)
+        {
+            return this->findOrInsert(key, [&]() { return std::pair<Key, Value>{ key, Value(std::forward<Args>(args)...) }; });
+        }
+    };
+
+    template<typename Key, typename Hash = std::hash<Key>, typename Eq = std::equal_to<Key>>
+    class Set : public detail::Table<Key, Key, detail::SelfKey, Hash, Eq>
+    {
+        using base_t = detail::Table<Key, Key, detail::SelfKey, Hash, Eq>;
+
+    public:
+        using typename base_t::iterator;
+        using base_t::base_t;
+
+        Set(std::initializer_list<Key> keys)
+        {
+            this->reserve(keys.size());
+            for (const auto &key : keys)
+            {
+                insert(key);
+            }
+        }
+
+        std::pair<iterator, bool> insert(const Key &key)
+        {
+            return this->findOrInsert(key, [&key]() { return key; });
+        }
+    };
+};
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "image.h"
+#include "utils.h" // Allows enabling with --frames
+
+// Recording a simulation one frame per step, e.g. day17 with --frames raw
+// The day draws on a canvas as it goes, every --frame-every n steps the canvas is copied into a small ring of frames
+// that a background thread writes out, so nothing's allocated per frame and the simulation only waits when the whole ring is queued
+// bmp: images/dayxx/name_000001.bmp etc, frames with nothing changed are skipped
+// raw: images/dayxx/name.frames, each frame only has the rows that changed since the one before:
+//      "AOCFRAME", uint32 width, uint32 height, then per frame uint32 step, uint32 rows,
+//      and per row uint32 y then width * 3 bytes of BGR (all little endian, y counting from the canvas's row 0)
+namespace frames
+{
+    class Sink
+    {
+    public:
+        static constexpr size_t ringSize{ 4 };
+
+        // bTopDown for BMPs with canvas row 0 at the top (y counting down the screen), row 0 is the bottom otherwise
+        Sink(const std::string &name, int width, int height, bool bTopDown = false) :
+            m_canvas{ width, height },
+            m_previous{ width, height },
+            m_format{ run::current().options.frameFormat },
+            m_every{ run::current().options.frameEvery },
+            m_bTopDown{ bTopDown },
+            m_path{ utils::imagePath(name) }
+        {
+            if (m_format == options::FrameFormat::raw)
+            {
+                m_raw.open(std::filesystem::path{ m_path }.concat(".frames"), std::ios::binary);
+                if (!m_raw)
+                {
+                    std::cerr << "frames.h could not open " << m_path.string() << ".frames for writing\n";
+                }
+                m_raw.write("AOCFRAME", 8);
+                put32(static_cast<std::uint32_t>(width));
+                put32(static_cast<std::uint32_t>(height));
+            }
+
+            m_ring.reserve(ringSize);
+            for (size_t i{ 0 }; i < ringSize; ++i)
+            {
+                m_ring.push_back({ Image8{ width, height }, 0 });
+            }
+            m_thread = std::thread{ &Sink::work, this };
+        }
+
+        // Writes out everything queued before returning
+        ~Sink()
+        {
+            {
+                std::lock_guard lock{ m_mutex };
+                m_bStopping = true;
+            }
+            m_queued.notify_one();
+            m_thread.join();
+        }
+
+        Sink(const Sink&) = delete;
+        Sink& operator=(const Sink&) = delete;
+
+        // Draw on this between frames, it's kept as it is from one to the next
+        Image8& canvas() { return m_canvas; }
+
+        // One simulation step done, queue the canvas if it's one we're recording
+        void frame()
+        {
+            if (m_step++ % m_every == 0)
+            {
+                queue();
+            }
+        }
+
+        // Same, with draw(canvas) only called for the steps that are recorded (for redrawing everything each time)
+        template<typename Draw>
+        void frame(Draw &&draw)
+        {
+            if (m_step++ % m_every == 0)
+            {
+                draw(m_canvas);
+                queue();
+            }
+        }
+
+    private:
+        struct Frame
+        {
+            Image8 image;
+            std::uint64_t step;
+        };
+
+        Image8 m_canvas;
+        Image8 m_previous; // Only touched by the writer thread, what the last frame written looked like
+        options::FrameFormat m_format;
+        unsigned m_every;
+        bool m_bTopDown;
+        std::filesystem::path m_path;
+        std::ofstream m_raw;
+        std::uint64_t m_step{ 0 };
+        std::uint64_t m_written{ 0 }; // Frames actually written, for the bmp names
+
+        std::vector<Frame> m_ring;
+        std::mutex m_mutex;
+        std::condition_variable m_queued;
+        std::condition_variable m_freed;
+        std::uint64_t m_pushed{ 0 };
+        std::uint64_t m_popped{ 0 };
+        bool m_bStopping{ false };
+        std::thread m_thread;
+
+        void queue()
+        {
+            Frame* frame;
+            {
+                std::unique_lock lock{ m_mutex };
+                m_freed.wait(lock, [this]() { return m_pushed - m_popped < ringSize; });
+                frame = &m_ring[m_pushed % ringSize];
+            }
+
+            // Ours until it's pushed, the writer only reads the ones before it
+            std::copy(m_canvas.pixels().begin(), m_canvas.pixels().end(), &frame->image.pixel(0, 0));
+            frame->step = m_step - 1;
+
+            {
+                std::lock_guard lock{ m_mutex };
+                ++m_pushed;
+            }
+            m_queued.notify_one();
+        }
+
+        void work()
+        {
+            while (true)
+            {
+                const Frame* frame;
+                {
+                    std::unique_lock lock{ m_mutex };
+                    m_queued.wait(lock, [this]() { return m_popped < m_pushed || m_bStopping; });
+                    if (m_popped == m_pushed)
+                        return;
+                    frame = &m_ring[m_popped % ringSize];
+                }
+
+                write(*frame);
+
+                {
+                    std::lock_guard lock{ m_mutex };
+                    ++m_popped;
+                }
+                m_freed.notify_one();
+            }
+        }
+
+        bool rowChanged(const Image8 &image, int y) const
+        {
+            const auto row{ image.row(y) };
+            const auto previous{ m_previous.row(y) };
+            return !std::equal(row.begin(), row.end(), previous.begin(),
+                [](const Rgb8 &a, const Rgb8 &b) { return a.r == b.r && a.g == b.g && a.b == b.b; });
+        }
+
+        void write(const Frame &frame)
+        {
+            const Image8 &image{ frame.image };
+
+            std::vector<int> changed;
+            for (int y{ 0 }; y < image.height(); ++y)
+            {
+                // The first frame is compared with all black too, which is what m_previous starts as
+                if (rowChanged(image, y))
+                {
+                    changed.push_back(y);
+                }
+            }
+
+            if (m_format == options::FrameFormat::raw)
+            {
+                put32(static_cast<std::uint32_t>(frame.step));
+                put32(static_cast<std::uint32_t>(changed.size()));
+                for (int y : changed)
+                {
+                    put32(static_cast<std::uint32_t>(y));
+                    const auto row{ image.row(y) };
+                    m_raw.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size() * sizeof(Rgb8)));
+                }
+            }
+            else if (!changed.empty() || !m_written)
+            {
+                char number[16];
+                std::snprintf(number, sizeof(number), "_%06llu.bmp", static_cast<unsigned long long>(++m_written));
+                BmpWriter bmp{ std::filesystem::path{ m_path }.concat(number).string(), image.width(), image.height(), m_bTopDown };
+                bmp.writeRows(image.pixels());
+            }
+
+            for (int y : changed)
+            {
+                const auto row{ image.row(y) };
+                std::copy(row.begin(), row.end(), m_previous.row(y).begin());
+            }
+        }
+
+        void put32(std::uint32_t value)
+        {
+            const char bytes[4]{ static_cast<char>(value), static_cast<char>(value >> 8), static_cast<char>(value >> 16), static_cast<char>(value >> 24) };
+            m_raw.write(bytes, 4);
+        }
+    };
+
+    // A Sink if --frames is set, so a day can do if (sink) sink->frame()
+    inline std::unique_ptr<Sink> record(const std::string &name, int width, int height, bool bTopDown = false)
+    {
+        if (!flags::isSet(flags::Flag::frames))
+            return nullptr;
+
+        return std::make_unique<Sink>(name, width, height, bTopDown);
+    }
+};
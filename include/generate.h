@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Made up inputs bigger (or smaller) than the real ones, for seeing how the solvers scale
+// Each day has a Generate::input that writes one in the same format as its puzzle input, scale 1 being about puzzle sized
+// -x 100 runs a day on one 100 times the size, --seed picks a different one
+// They're written to src/dayxx/generated/x100_s2022 the first time they're needed (delete it to regenerate)
+namespace generate
+{
+    // Same numbers from the same seed whatever the standard library, which std::uniform_int_distribution doesn't promise
+    class Random
+    {
+    public:
+        explicit Random(std::uint64_t seed) : m_engine{ seed } {}
+
+        std::uint64_t next() { return m_engine(); }
+
+        // Inclusive, the modulo bias is far too small to matter here
+        template<typename T>
+        T range(T lo, T hi)
+        {
+            static_assert(std::is_integral_v<T>);
+            return static_cast<T>(static_cast<long long>(lo) + static_cast<long long>(m_engine() % static_cast<std::uint64_t>(static_cast<long long>(hi) - lo + 1)));
+        }
+
+        size_t index(size_t size) { return static_cast<size_t>(m_engine() % size); }
+
+        bool chance(double probability)
+        {
+            return static_cast<double>(m_engine() >> 11) * 0x1.0p-53 < probability;
+        }
+
+        char pick(std::string_view chars) { return chars[index(chars.size())]; }
+
+        // Anything with size() and []
+        template<typename Container>
+        void shuffle(Container &items)
+        {
+            for (size_t i{ items.size() }; i > 1; --i)
+            {
+                std::swap(items[i - 1], items[index(i)]);
+            }
+        }
+
+    private:
+        std::mt19937_64 m_engine;
+    };
+
+    using generator_t = void (*)(std::ostream&, double scale, Random&);
+
+    // base things at scale 1, never less than min
+    inline size_t count(double base, double scale, size_t min = 1)
+    {
+        const auto scaled{ static_cast<size_t>(std::llround(base * scale)) };
+        return scaled < min ? min : scaled;
+    }
+
+    // Relative to the day's directory, like the other input names
+    inline std::string inputName(double scale, std::uint64_t seed)
+    {
+        std::ostringstream name;
+        name << "generated/x" << scale << "_s" << seed;
+        return name.str();
+    }
+
+    // Writes the input if it's not there already, returns its name for -i
+    inline std::string ensureInput(const std::filesystem::path &cppFile, int day, generator_t generator, double scale, std::uint64_t seed)
+    {
+        const std::string name{ inputName(scale, seed) };
+        const auto path{ cppFile.parent_path() / name };
+        if (std::filesystem::exists(path))
+            return name;
+
+        std::filesystem::create_directories(path.parent_path());
+
+        // Written to a temporary name first so a half finished file is never used
+        const auto partial{ std::filesystem::path{ path }.concat(".partial") };
+        {
+            std::ofstream out{ partial, std::ios::binary };
+            if (!out)
+            {
+                throw std::runtime_error{ "could not write to file " + partial.string() };
+            }
+            Random random{ seed * 0x9E3779B97F4A7C15ull + static_cast<std::uint64_t>(day) };
+            generator(out, scale, random);
+        }
+        std::filesystem::rename(partial, path);
+        return name;
+    }
+};
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "vector2d.h"
+#include "vector3d.h"
+
+// Dense grids in one block of memory, instead of vectors of vectors (of vectors)
+// With padding there's a border of extra cells all the way round, holding whatever value says "stop here",
+// so a neighbour can be looked at without checking it's in the grid first (-padding to size + padding - 1 are all fine)
+// Cells can also be walked by flat index: index(coord) + offset(direction) is the neighbour's index
+namespace grid
+{
+    // Compile time neighbourhoods, x then y (then z)
+    inline constexpr std::array<Vector2d, 4> orthogonal{ { { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 } } };
+    inline constexpr std::array<Vector2d, 8> surrounding{ { { -1, -1 }, { 0, -1 }, { 1, -1 }, { -1, 0 }, { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 } } };
+    inline constexpr std::array<Vector3d, 6> faces{ { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } } };
+
+    // Everything touching, even by a corner
+    inline constexpr std::array<Vector3d, 26> touching{ []()
+        {
+            std::array<Vector3d, 26> around{};
+            size_t i{ 0 };
+            for (int x{ -1 }; x <= 1; ++x)
+                for (int y{ -1 }; y <= 1; ++y)
+                    for (int z{ -1 }; z <= 1; ++z)
+                        if (x || y || z)
+                            around[i++] = { x, y, z };
+            return around;
+        }() };
+};
+
+// Row by row, (x, y) with x along a row
+template<typename T>
+class Grid2D
+{
+    // std::vector<bool> packs its bits so there's no span or data() for rows, use char or std::uint8_t
+    static_assert(!std::is_same_v<T, bool>, "use char or std::uint8_t for a grid of bools");
+
+public:
+    Grid2D() = default;
+
+    Grid2D(int width, int height, T value = T{}, int padding = 0, T border = T{}) :
+        m_width{ width }, m_height{ height }, m_padding{ padding },
+        m_stride{ static_cast<size_t>(width + 2 * padding) },
+        m_cells(m_stride * static_cast<size_t>(height + 2 * padding), border)
+    {
+        for (int y{ 0 }; y < height; ++y)
+        {
+            const auto cells{ row(y) };
+            std::fill(cells.begin(), cells.end(), value);
+        }
+    }
+
+    // One cell per char, lines as rows (any shorter than the longest are filled out with fill)
+    static Grid2D fromLines(std::span<const std::string_view> lines, int padding = 0, T border = T{}, T fill = T{})
+        requires std::is_same_v<T, char>
+    {
+        size_t longest{ 0 };
+        for (const auto &line : lines)
+        {
+            longest = std::max(longest, line.length());
+        }
+
+        Grid2D grid{ static_cast<int>(longest), static_cast<int>(lines.size()), fill, padding, border };
+        for (size_t y{ 0 }; y < lines.size(); ++y)
+        {
+            std::copy(lines[y].begin(), lines[y].end(), grid.row(static_cast<int>(y)).begin());
+        }
+        return grid;
+    }
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int padding() const { return m_padding; }
+
+    // Inside the grid proper, not the padding
+    bool inBounds(const Vector2d &coord) const { return coord.x >= 0 && coord.y >= 0 && coord.x < m_width && coord.y < m_height; }
+
+    T& operator[](const Vector2d &coord) { return m_cells[index(coord)]; }
+    const T& operator[](const Vector2d &coord) const { return m_cells[index(coord)]; }
+
+    T& at(int x, int y) { return m_cells[index(x, y)]; }
+    const T& at(int x, int y) const { return m_cells[index(x, y)]; }
+
+    // By flat index, for walking with offset()
+    T& operator[](size_t i) { return m_cells[i]; }
+    const T& operator[](size_t i) const { return m_cells[i]; }
+
+    size_t index(int x, int y) const { return static_cast<size_t>(y + m_padding) * m_stride + static_cast<size_t>(x + m_padding); }
+    size_t index(const Vector2d &coord) const { return index(coord.x, coord.y); }
+    Vector2d coord(size_t i) const { return { static_cast<int>(i % m_stride) - m_padding, static_cast<int>(i / m_stride) - m_padding }; }
+
+    // How far apart in flat indices two cells direction apart are
+    std::ptrdiff_t offset(const Vector2d &direction) const { return static_cast<std::ptrdiff_t>(direction.y) * static_cast<std::ptrdiff_t>(m_stride) + direction.x; }
+
+    template<size_t N>
+    std::array<std::ptrdiff_t, N> offsets(const std::array<Vector2d, N> &stencil) const
+    {
+        std::array<std::ptrdiff_t, N> flat{};
+        for (size_t i{ 0 }; i < N; ++i)
+        {
+            flat[i] = offset(stencil[i]);
+        }
+        return flat;
+    }
+
+    // Without the padding either side
+    std::span<T> row(int y) { return { m_cells.data() + index(0, y), static_cast<size_t>(m_width) }; }
+    std::span<const T> row(int y) const { return { m_cells.data() + index(0, y), static_cast<size_t>(m_width) }; }
+
+    // fnc(cell, coord) for every cell that isn't padding
+    template<typename Fnc>
+    void forEach(Fnc &&fnc)
+    {
+        for (int y{ 0 }; y < m_height; ++y)
+        {
+            T* cell{ &at(0, y) };
+            for (int x{ 0 }; x < m_width; ++x, ++cell)
+            {
+                fnc(*cell, Vector2d{ x, y });
+            }
+        }
+    }
+
+private:
+    int m_width{ 0 };
+    int m_height{ 0 };
+    int m_padding{ 0 };
+    size_t m_stride{ 0 };
+    std::vector<T> m_cells;
+};
+
+// Slab by slab, [x][y][z] like a vector of vectors of vectors would be, so z is the one that's contiguous
+template<typename T>
+class Grid3D
+{
+    static_assert(!std::is_same_v<T, bool>, "use char or std::uint8_t for a grid of bools");
+
+public:
+    Grid3D() = default;
+
+    Grid3D(const Vector3d &size, T value = T{}, int padding = 0, T border = T{}) :
+        m_size{ size }, m_padding{ padding },
+        m_padded{ size + 2 * padding },
+        m_cells(static_cast<size_t>(m_padded.x) * static_cast<size_t>(m_padded.y) * static_cast<size_t>(m_padded.z), border)
+    {
+        for (int x{ 0 }; x < size.x; ++x)
+        {
+            for (int y{ 0 }; y < size.y; ++y)
+            {
+                const auto cells{ line(x, y) };
+                std::fill(cells.begin(), cells.end(), value);
+            }
+        }
+    }
+
+    const Vector3d& size() const { return m_size; }
+    int padding() const { return m_padding; }
+
+    bool inBounds(const Vector3d &coord) const
+    {
+        return coord.x >= 0 && coord.y >= 0 && coord.z >= 0 && coord.x < m_size.x && coord.y < m_size.y && coord.z < m_size.z;
+    }
+
+    T& operator[](const Vector3d &coord) { return m_cells[index(coord)]; }
+    const T& operator[](const Vector3d &coord) const { return m_cells[index(coord)]; }
+
+    T& operator[](size_t i) { return m_cells[i]; }
+    const T& operator[](size_t i) const { return m_cells[i]; }
+
+    size_t index(const Vector3d &coord) const
+    {
+        return (static_cast<size_t>(coord.x + m_padding) * static_cast<size_t>(m_padded.y) + static_cast<size_t>(coord.y + m_padding)) * static_cast<size_t>(m_padded.z)
+            + static_cast<size_t>(coord.z + m_padding);
+    }
+
+    Vector3d coord(size_t i) const
+    {
+        const auto z{ static_cast<int>(i % static_cast<size_t>(m_padded.z)) };
+        i /= static_cast<size_t>(m_padded.z);
+        const auto y{ static_cast<int>(i % static_cast<size_t>(m_padded.y)) };
+        const auto x{ static_cast<int>(i / static_cast<size_t>(m_padded.y)) };
+        return Vector3d{ x, y, z } - Vector3d{ m_padding };
+    }
+
+    std::ptrdiff_t offset(const Vector3d &direction) const
+    {
+        return (static_cast<std::ptrdiff_t>(direction.x) * m_padded.y + direction.y) * m_padded.z + direction.z;
+    }
+
+    template<size_t N>
+    std::array<std::ptrdiff_t, N> offsets(const std::array<Vector3d, N> &stencil) const
+    {
+        std::array<std::ptrdiff_t, N> flat{};
+        for (size_t i{ 0 }; i < N; ++i)
+        {
+            flat[i] = offset(stencil[i]);
+        }
+        return flat;
+    }
+
+    // The z cells at x, y without the padding either end
+    std::span<T> line(int x, int y) { return { m_cells.data() + index({ x, y, 0 }), static_cast<size_t>(m_size.z) }; }
+    std::span<const T> line(int x, int y) const { return { m_cells.data() + index({ x, y, 0 }), static_cast<size_t>(m_size.z) }; }
+
+    // Everything at x, padding and all, since that's what's contiguous
+    std::span<T> slab(int x) { return { m_cells.data() + index({ x, -m_padding, -m_padding }), static_cast<size_t>(m_padded.y) * static_cast<size_t>(m_padded.z) }; }
+    std::span<const T> slab(int x) const { return { m_cells.data() + index({ x, -m_padding, -m_padding }), static_cast<size_t>(m_padded.y) * static_cast<size_t>(m_padded.z) }; }
+
+    // fnc(cell, coord) for every cell that isn't padding
+    template<typename Fnc>
+    void forEach(Fnc &&fnc)
+    {
+        for (int x{ 0 }; x < m_size.x; ++x)
+        {
+            for (int y{ 0 }; y < m_size.y; ++y)
+            {
+                T* cell{ &(*this)[Vector3d{ x, y, 0 }] };
+                for (int z{ 0 }; z < m_size.z; ++z, ++cell)
+                {
+                    fnc(*cell, Vector3d{ x, y, z });
+                }
+            }
+        }
+    }
+
+private:
+    Vector3d m_size{};
+    int m_padding{ 0 };
+    Vector3d m_padded{};
+    std::vector<T> m_cells;
+};
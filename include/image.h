@@ -1,172 +1,461 @@
-#pragma once
-
-#include <fstream>
-#include <iostream>
-#include <vector>
-
-struct Color {
-	float r, g, b;
-
-	Color();
-	Color(float r, float g, float b);
-	~Color();
-};
-
-class Image
-{
-public:
-	Image(int width, int height);
-	Image(int width, int height, const Color& bg);
-	~Image();
-
-	Color getColor(int x, int y);
-	void setColor(const Color& color, int x, int y);
-
-	void save(const char* path);
-
-private:
-	int m_width;
-	int m_height;
-
-	std::vector<Color> m_colors;
-};
-
-Color::Color() :
-	r{ 0 }, g{ 0 }, b{ 0 }
-{
-}
-
-Color::Color(float r, float g, float b) :
-	r{ r }, g{ g }, b{ b }
-{
-}
-
-Color::~Color()
-{
-}
-
-Image::Image(int width, int height) :
-	m_width{ width }, m_height{ height }, m_colors{ std::vector<Color>(static_cast<size_t>(width) * static_cast<size_t>(height)) }
-{
-
-}
-
-Image::Image(int width, int height, const Color& bg) :
-	m_width{ width }, m_height{ height }, m_colors{ std::vector<Color>(static_cast<size_t>(width) * static_cast<size_t>(height), bg)}
-{
-
-}
-
-Image::~Image()
-{
-
-}
-
-Color Image::getColor(int x, int y)
-{
-	return m_colors[static_cast<size_t>(y) * static_cast<size_t>(m_width) + static_cast<size_t>(x)];
-}
-
-void Image::setColor(const Color& color, int x, int y)
-{
-	m_colors[static_cast<size_t>(static_cast<size_t>(y) * static_cast<size_t>(m_width) + static_cast<size_t>(x))] = color;
-}
-
-void Image::save(const char* path)
-{
-	std::ofstream f;
-	f.open(path, std::ios::out | std::ios::binary);
-
-	if (!f.is_open())
-	{
-		std::cerr << "File " << path << " could not be opened for writing\n";
-		return;
-	}
-
-	unsigned char bmpPad[3] = { 0, 0, 0 };
-	const int paddingAmount = ((4 - (m_width * 3) % 4) % 4);
-
-	const int fileHeaderSize = 14;
-	const int informationHeaderSize = 40;
-	const int fileSize = fileHeaderSize + informationHeaderSize + m_width * m_height * 3 + paddingAmount * m_height;
-
-	unsigned char fileHeader[fileHeaderSize]{};
-
-	// File type
-	fileHeader[0] = 'B';
-	fileHeader[1] = 'M';
-	// File size
-	fileHeader[2] = static_cast<unsigned char>( fileSize );
-	fileHeader[3] = static_cast<unsigned char>( fileSize >> 8 );
-	fileHeader[4] = static_cast<unsigned char>( fileSize >> 16 );
-	fileHeader[5] = static_cast<unsigned char>( fileSize >> 24 );
-	// Reserved 1 (not used)
-	fileHeader[6] = 0;
-	fileHeader[7] = 0;
-	// Reserverd 2 (not used)
-	fileHeader[8] = 0;
-	fileHeader[9] = 0;
-	// Pixel data offset
-	fileHeader[10] = fileHeaderSize + informationHeaderSize;
-	fileHeader[11] = 0;
-	fileHeader[12] = 0;
-	fileHeader[13] = 0;
-
-	unsigned char informationHeader[informationHeaderSize]{};
-
-	// Header size
-	informationHeader[0] = informationHeaderSize;
-	informationHeader[1] = 0;
-	informationHeader[2] = 0;
-	informationHeader[3] = 0;
-	// Image width
-	informationHeader[4] = static_cast<unsigned char>(m_width);
-	informationHeader[5] = static_cast<unsigned char>(m_width >> 8);
-	informationHeader[6] = static_cast<unsigned char>(m_width >> 16);
-	informationHeader[7] = static_cast<unsigned char>(m_width >> 24);
-	// Image height
-	informationHeader[8] = static_cast<unsigned char>(m_height);
-	informationHeader[9] = static_cast<unsigned char>(m_height >> 8);
-	informationHeader[10] = static_cast<unsigned char>(m_height >> 16);
-	informationHeader[11] = static_cast<unsigned char>(m_height >> 24);
-	// Planes
-	informationHeader[12] = 1;
-	informationHeader[13] = 0;
-	// Bits per pixel (RGB)
-	informationHeader[14] = 24;
-	informationHeader[15] = 0;
-	// For loop zeroes the following:
-	// Compression (no compression)
-	// Image size (no compression)
-	// X pixels per meter (unspecified)
-	// Y pixels per meter (unspecified)
-	// Total colors (unspecified)
-	// Important colours (generally ignored)
-	for (size_t i{ 16 }; i < 40; ++i)
-	{
-		informationHeader[i] = 0;
-	}
-
-	f.write(reinterpret_cast<char*>(fileHeader), fileHeaderSize);
-	f.write(reinterpret_cast<char*>(informationHeader), informationHeaderSize);
-	
-	for (int y{ 0 }; y < m_height; ++y)
-	{
-		for (int x{ 0 }; x < m_width; ++x)
-		{
-			unsigned char r = static_cast<unsigned char>(getColor(x, y).r * 255.0f);
-			unsigned char g = static_cast<unsigned char>(getColor(x, y).g * 255.0f);
-			unsigned char b = static_cast<unsigned char>(getColor(x, y).b * 255.0f);
-
-			unsigned char color[] = { b, g, r };
-
-			f.write(reinterpret_cast<char*>(color), 3);
-		}
-
-		f.write(reinterpret_cast<char*>(bmpPad), paddingAmount);
-	}
-
-	f.close();
-
-	std::cout << "File: " << path << " created\n";
-}
\ No newline at end of file
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "threadpool.h"
+
+struct Color {
+	float r, g, b;
+
+	Color();
+	Color(float r, float g, float b);
+	~Color();
+};
+
+// 8 bit colour in the order BMP stores it, so a row of them is written out as it is
+struct Rgb8 {
+	std::uint8_t b, g, r;
+};
+
+static_assert(sizeof(Rgb8) == 3, "Rgb8 rows are written straight to the file");
+
+inline std::uint8_t toByte(float channel)
+{
+	return static_cast<std::uint8_t>(std::clamp(channel, 0.f, 1.f) * 255.0f);
+}
+
+inline Rgb8 toRgb8(const Color& color)
+{
+	return { toByte(color.b), toByte(color.g), toByte(color.r) };
+}
+
+inline Color toColor(const Rgb8& rgb)
+{
+	return { rgb.r / 255.0f, rgb.g / 255.0f, rgb.b / 255.0f };
+}
+
+// Writes a 24 bit BMP a row at a time, so an image never has to be in memory all at once
+// Rows are buffered up and written in blocks of about 1MB
+// Rows go bottom to top like Image::save, or top to bottom with bTopDown (for drawing as a simulation goes)
+class BmpWriter
+{
+public:
+	BmpWriter(const std::string& path, int width, int height, bool bTopDown = false);
+	~BmpWriter();
+
+	BmpWriter(const BmpWriter&) = delete;
+	BmpWriter& operator=(const BmpWriter&) = delete;
+
+	bool isOpen() const { return m_file.is_open(); }
+	int rowsLeft() const { return m_height - m_rowsWritten; }
+
+	void writeRow(std::span<const Rgb8> row);
+	void writeRow(std::span<const Color> row);
+
+	// Any number of whole rows one after another, straight to the file when there's no padding between them
+	void writeRows(std::span<const Rgb8> rows);
+
+	// Writes what's buffered and closes the file, false if anything was missing or failed
+	bool finish();
+
+	static constexpr int fileHeaderSize{ 14 };
+	static constexpr int informationHeaderSize{ 40 };
+
+	static std::array<unsigned char, fileHeaderSize + informationHeaderSize> header(int width, int height, bool bTopDown);
+
+	// Rows are padded to a multiple of 4 bytes
+	static size_t rowBytes(int width) { return (static_cast<size_t>(width) * 3 + 3) & ~size_t{ 3 }; }
+
+private:
+	static constexpr size_t blockSize{ 1 << 20 };
+
+	std::ofstream m_file;
+	std::string m_path;
+	int m_width;
+	int m_height;
+	int m_rowsWritten{ 0 };
+	std::vector<char> m_block;
+
+	void flushBlock();
+};
+
+// Pixel is Color (3 floats, the default) or Rgb8 for a quarter of the memory
+template<typename Pixel = Color>
+class BasicImage
+{
+	static_assert(std::is_same_v<Pixel, Color> || std::is_same_v<Pixel, Rgb8>);
+
+public:
+	BasicImage(int width, int height);
+	BasicImage(int width, int height, const Color& bg);
+	~BasicImage();
+
+	int width() const { return m_width; }
+	int height() const { return m_height; }
+
+	Color getColor(int x, int y) const;
+	void setColor(const Color& color, int x, int y);
+
+	void fill(const Color& color);
+
+	// shade(x, y) returns the Color of every pixel, worked out a tile at a time on threads (0 for every core)
+	// Tiles are small enough to stay in cache, and shade has to be fine with being called from several threads at once
+	template<typename Shade>
+	void render(Shade&& shade, unsigned threads = 0);
+	template<typename Shade>
+	void render(Shade&& shade, ThreadPool& pool);
+
+	static constexpr int tileSize{ 64 };
+
+	// Whatever's stored, without converting
+	Pixel& pixel(int x, int y) { return m_colors[index(x, y)]; }
+	const Pixel& pixel(int x, int y) const { return m_colors[index(x, y)]; }
+	std::span<const Pixel> pixels() const { return m_colors; }
+	std::span<Pixel> row(int y) { return { m_colors.data() + index(0, y), static_cast<size_t>(m_width) }; }
+	std::span<const Pixel> row(int y) const { return { m_colors.data() + index(0, y), static_cast<size_t>(m_width) }; }
+
+	// Big Color images are converted to bytes a band of rows at a time on threads (0 for every core)
+	void save(const char* path, unsigned threads = 0) const;
+
+private:
+	int m_width;
+	int m_height;
+
+	std::vector<Pixel> m_colors;
+
+	size_t index(int x, int y) const { return static_cast<size_t>(y) * static_cast<size_t>(m_width) + static_cast<size_t>(x); }
+
+	// Rows converted per job when saving, about 256KB of bytes out
+	int bandRows() const { return std::max(1, static_cast<int>((1 << 18) / (static_cast<size_t>(m_width) * sizeof(Rgb8) + 1))); }
+};
+
+using Image = BasicImage<Color>;
+using Image8 = BasicImage<Rgb8>;
+
+inline Color::Color() :
+	r{ 0 }, g{ 0 }, b{ 0 }
+{
+}
+
+inline Color::Color(float r, float g, float b) :
+	r{ r }, g{ g }, b{ b }
+{
+}
+
+inline Color::~Color()
+{
+}
+
+inline BmpWriter::BmpWriter(const std::string& path, int width, int height, bool bTopDown) :
+	m_path{ path }, m_width{ width }, m_height{ height }
+{
+	// The header only has room for 32 bit sizes
+	if (width <= 0 || height <= 0 || rowBytes(width) * static_cast<size_t>(height) + fileHeaderSize + informationHeaderSize > 0xFFFF'FFFFull)
+	{
+		std::cerr << "File " << path << " can't be " << width << " x " << height << '\n';
+		return;
+	}
+
+	m_file.open(path, std::ios::out | std::ios::binary);
+	if (!m_file.is_open())
+	{
+		std::cerr << "File " << path << " could not be opened for writing\n";
+		return;
+	}
+
+	const auto bmpHeader{ header(width, height, bTopDown) };
+	m_file.write(reinterpret_cast<const char*>(bmpHeader.data()), static_cast<std::streamsize>(bmpHeader.size()));
+	m_block.reserve(std::max(blockSize, rowBytes(width)));
+}
+
+inline BmpWriter::~BmpWriter()
+{
+	if (m_file.is_open())
+	{
+		finish();
+	}
+}
+
+inline std::array<unsigned char, BmpWriter::fileHeaderSize + BmpWriter::informationHeaderSize> BmpWriter::header(int width, int height, bool bTopDown)
+{
+	std::array<unsigned char, fileHeaderSize + informationHeaderSize> bytes{};
+
+	const auto put32{ [&bytes](size_t at, std::uint32_t value)
+		{
+			for (size_t i{ 0 }; i < 4; ++i)
+			{
+				bytes[at + i] = static_cast<unsigned char>(value >> (8 * i));
+			}
+		} };
+
+	const auto fileSize{ static_cast<std::uint32_t>(bytes.size() + rowBytes(width) * static_cast<size_t>(height)) };
+
+	// File type
+	bytes[0] = 'B';
+	bytes[1] = 'M';
+	put32(2, fileSize);
+	// Reserved 1 and 2 (not used) are left 0
+	// Pixel data offset
+	put32(10, fileHeaderSize + informationHeaderSize);
+
+	unsigned char* informationHeader{ bytes.data() + fileHeaderSize };
+	// Header size
+	informationHeader[0] = informationHeaderSize;
+	// Image width and height, a negative height means the first row is the top
+	put32(fileHeaderSize + 4, static_cast<std::uint32_t>(width));
+	put32(fileHeaderSize + 8, static_cast<std::uint32_t>(bTopDown ? -height : height));
+	// Planes
+	informationHeader[12] = 1;
+	// Bits per pixel (RGB)
+	informationHeader[14] = 24;
+	// The rest stay 0: no compression, image size (no compression), pixels per meter, total and important colours
+
+	return bytes;
+}
+
+inline void BmpWriter::flushBlock()
+{
+	m_file.write(m_block.data(), static_cast<std::streamsize>(m_block.size()));
+	m_block.clear();
+}
+
+inline void BmpWriter::writeRow(std::span<const Rgb8> row)
+{
+	if (!isOpen() || !rowsLeft())
+		return;
+
+	const size_t bytes{ rowBytes(m_width) };
+	if (m_block.size() + bytes > m_block.capacity())
+	{
+		flushBlock();
+	}
+
+	const size_t used{ std::min(row.size(), static_cast<size_t>(m_width)) * sizeof(Rgb8) };
+	const auto* data{ reinterpret_cast<const char*>(row.data()) };
+	m_block.insert(m_block.end(), data, data + used);
+	m_block.resize(m_block.size() + bytes - used, 0); // Padding, and black for anything short
+	++m_rowsWritten;
+}
+
+inline void BmpWriter::writeRow(std::span<const Color> row)
+{
+	if (!isOpen() || !rowsLeft())
+		return;
+
+	const size_t bytes{ rowBytes(m_width) };
+	if (m_block.size() + bytes > m_block.capacity())
+	{
+		flushBlock();
+	}
+
+	const size_t start{ m_block.size() };
+	m_block.resize(start + bytes, 0);
+	auto* pixels{ reinterpret_cast<Rgb8*>(m_block.data() + start) };
+	const size_t count{ std::min(row.size(), static_cast<size_t>(m_width)) };
+	for (size_t x{ 0 }; x < count; ++x)
+	{
+		pixels[x] = toRgb8(row[x]);
+	}
+	++m_rowsWritten;
+}
+
+inline void BmpWriter::writeRows(std::span<const Rgb8> rows)
+{
+	if (!isOpen())
+		return;
+
+	const auto width{ static_cast<size_t>(m_width) };
+	if (rowBytes(m_width) != width * sizeof(Rgb8))
+	{
+		for (size_t start{ 0 }; start + width <= rows.size(); start += width)
+		{
+			writeRow(rows.subspan(start, width));
+		}
+		return;
+	}
+
+	// No padding, so they're already exactly what goes in the file
+	const size_t count{ std::min(rows.size() / width, static_cast<size_t>(rowsLeft())) };
+	flushBlock();
+	m_file.write(reinterpret_cast<const char*>(rows.data()), static_cast<std::streamsize>(count * width * sizeof(Rgb8)));
+	m_rowsWritten += static_cast<int>(count);
+}
+
+inline bool BmpWriter::finish()
+{
+	if (!isOpen())
+		return false;
+
+	const bool bComplete{ !rowsLeft() };
+	if (!bComplete)
+	{
+		std::cerr << "File " << m_path << " was closed " << rowsLeft() << " rows short\n";
+	}
+
+	flushBlock();
+	m_file.close();
+	return bComplete && !m_file.fail();
+}
+
+template<typename Pixel>
+inline BasicImage<Pixel>::BasicImage(int width, int height) :
+	m_width{ width }, m_height{ height }, m_colors{ std::vector<Pixel>(static_cast<size_t>(width) * static_cast<size_t>(height)) }
+{
+
+}
+
+template<typename Pixel>
+inline BasicImage<Pixel>::BasicImage(int width, int height, const Color& bg) :
+	m_width{ width }, m_height{ height }, m_colors(static_cast<size_t>(width) * static_cast<size_t>(height))
+{
+	fill(bg);
+}
+
+template<typename Pixel>
+inline void BasicImage<Pixel>::fill(const Color& color)
+{
+	if constexpr (std::is_same_v<Pixel, Color>)
+		std::fill(m_colors.begin(), m_colors.end(), color);
+	else
+		std::fill(m_colors.begin(), m_colors.end(), toRgb8(color));
+}
+
+template<typename Pixel>
+inline BasicImage<Pixel>::~BasicImage()
+{
+
+}
+
+template<typename Pixel>
+inline Color BasicImage<Pixel>::getColor(int x, int y) const
+{
+	if constexpr (std::is_same_v<Pixel, Color>)
+		return m_colors[index(x, y)];
+	else
+		return toColor(m_colors[index(x, y)]);
+}
+
+template<typename Pixel>
+inline void BasicImage<Pixel>::setColor(const Color& color, int x, int y)
+{
+	if constexpr (std::is_same_v<Pixel, Color>)
+		m_colors[index(x, y)] = color;
+	else
+		m_colors[index(x, y)] = toRgb8(color);
+}
+
+template<typename Pixel>
+template<typename Shade>
+inline void BasicImage<Pixel>::render(Shade&& shade, unsigned threads)
+{
+	// Not worth starting threads for one tile
+	if (m_width <= tileSize && m_height <= tileSize)
+	{
+		for (int y{ 0 }; y < m_height; ++y)
+		{
+			for (int x{ 0 }; x < m_width; ++x)
+			{
+				setColor(shade(x, y), x, y);
+			}
+		}
+		return;
+	}
+
+	ThreadPool pool{ threads ? threads : std::thread::hardware_concurrency() };
+	render(shade, pool);
+}
+
+template<typename Pixel>
+template<typename Shade>
+inline void BasicImage<Pixel>::render(Shade&& shade, ThreadPool& pool)
+{
+	for (int top{ 0 }; top < m_height; top += tileSize)
+	{
+		for (int left{ 0 }; left < m_width; left += tileSize)
+		{
+			// Tiles never overlap, so nothing's shared between the jobs
+			pool.push([this, &shade, left, top]()
+				{
+					const int right{ std::min(left + tileSize, m_width) };
+					const int bottom{ std::min(top + tileSize, m_height) };
+					for (int y{ top }; y < bottom; ++y)
+					{
+						for (int x{ left }; x < right; ++x)
+						{
+							setColor(shade(x, y), x, y);
+						}
+					}
+				});
+		}
+	}
+	pool.wait();
+}
+
+// Row 0 ends up at the bottom, as it always has
+template<typename Pixel>
+inline void BasicImage<Pixel>::save(const char* path, unsigned threads) const
+{
+	BmpWriter writer{ path, m_width, m_height };
+	if (!writer.isOpen())
+		return;
+
+	if constexpr (std::is_same_v<Pixel, Rgb8>)
+	{
+		writer.writeRows(m_colors);
+	}
+	else if (m_height <= bandRows())
+	{
+		for (int y{ 0 }; y < m_height; ++y)
+		{
+			writer.writeRow(row(y));
+		}
+	}
+	else
+	{
+		// Each band is split between the threads, converted, then written while the next one's converted
+		ThreadPool pool{ threads ? threads : std::thread::hardware_concurrency() };
+		const int rows{ bandRows() };
+		const size_t width{ static_cast<size_t>(m_width) };
+		std::vector<Rgb8> converted[2]{ std::vector<Rgb8>(width * static_cast<size_t>(rows)), std::vector<Rgb8>(width * static_cast<size_t>(rows)) };
+
+		const auto convert{ [&](int first, std::vector<Rgb8>& out)
+			{
+				const int last{ std::min(first + rows, m_height) };
+				const int split{ std::max(1, (last - first) / static_cast<int>(pool.size())) };
+				for (int from{ first }; from < last; from += split)
+				{
+					pool.push([this, &out, first, from, to{ std::min(from + split, last) }, width]()
+						{
+							std::transform(m_colors.begin() + static_cast<std::ptrdiff_t>(index(0, from)), m_colors.begin() + static_cast<std::ptrdiff_t>(index(0, to)),
+								out.begin() + static_cast<std::ptrdiff_t>(static_cast<size_t>(from - first) * width), toRgb8);
+						});
+				}
+			} };
+
+		convert(0, converted[0]);
+		for (int band{ 0 }; band * rows < m_height; ++band)
+		{
+			pool.wait();
+			const int first{ band * rows };
+			const int count{ std::min(rows, m_height - first) };
+			if (first + rows < m_height)
+			{
+				convert(first + rows, converted[(band + 1) % 2]);
+			}
+			writer.writeRows({ converted[band % 2].data(), width * static_cast<size_t>(count) });
+		}
+	}
+
+	if (writer.finish())
+	{
+		std::cout << "File: " << path << " created\n";
+	}
+}
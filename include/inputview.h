@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+# define INPUTVIEW_MMAP
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#else
+# include <fstream>
+#endif
+
+// Read only view of a whole input file, memory mapped where we can (read into one buffer elsewise)
+// The line index is built up front so any line is a string_view into the file without copying
+// Lines don't include the '\n', and a trailing '\n' doesn't make an extra empty line (same as std::getline)
+// bIndexLines false skips the index for readers that only want data() (lineCount() is 0 then)
+class InputView
+{
+public:
+    explicit InputView(const std::string &file, bool bIndexLines = true)
+    {
+#ifdef INPUTVIEW_MMAP
+        const int fd{ ::open(file.c_str(), O_RDONLY) };
+        if (fd < 0)
+        {
+            throw std::runtime_error{ "Could not open file: " + file };
+        }
+
+        struct stat info{};
+        if (::fstat(fd, &info) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error{ "Could not stat file: " + file };
+        }
+
+        m_size = static_cast<size_t>(info.st_size);
+        if (m_size) // mmap fails on empty files, which are fine
+        {
+            void* mapped{ ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE | populateFlag, fd, 0) };
+            if (mapped == MAP_FAILED)
+            {
+                ::close(fd);
+                throw std::runtime_error{ "Could not map file: " + file };
+            }
+            ::madvise(mapped, m_size, MADV_SEQUENTIAL);
+            m_data = static_cast<const char*>(mapped);
+        }
+        ::close(fd); // The mapping stays valid
+#else
+        std::ifstream inf{ file, std::ios::binary };
+        if (!inf.good())
+        {
+            throw std::runtime_error{ "Could not open file: " + file };
+        }
+        inf.seekg(0, std::ios::end);
+        m_buffer.resize(static_cast<size_t>(inf.tellg()));
+        inf.seekg(0, std::ios::beg);
+        inf.read(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+#endif
+        if (bIndexLines)
+        {
+            indexLines();
+        }
+    }
+
+    ~InputView()
+    {
+#ifdef INPUTVIEW_MMAP
+        if (m_data)
+        {
+            ::munmap(const_cast<char*>(m_data), m_size);
+        }
+#endif
+    }
+
+    InputView(const InputView&) = delete;
+    InputView& operator=(const InputView&) = delete;
+
+    std::string_view data() const { return { m_data, m_size }; }
+    size_t size() const { return m_size; }
+
+    size_t lineCount() const { return m_lineStarts.size(); }
+
+    std::string_view line(size_t i) const
+    {
+        const size_t start{ m_lineStarts[i] };
+        // Next line's start is one past this one's '\n', the last line may not have one
+        const size_t end{ i + 1 < m_lineStarts.size() ? m_lineStarts[i + 1] - 1 : lastLineEnd() };
+        return { m_data + start, end - start };
+    }
+
+    // Offset of the first character of each line
+    const std::vector<size_t>& lineStarts() const { return m_lineStarts; }
+
+private:
+#ifdef INPUTVIEW_MMAP
+# ifdef MAP_POPULATE
+    // Fault the whole file in up front rather than a page at a time as we read it (Linux only)
+    static constexpr int populateFlag{ MAP_POPULATE };
+# else
+    static constexpr int populateFlag{ 0 };
+# endif
+#endif
+
+    const char* m_data{ nullptr };
+    size_t m_size{ 0 };
+    std::vector<size_t> m_lineStarts;
+#ifndef INPUTVIEW_MMAP
+    std::string m_buffer;
+#endif
+
+    size_t lastLineEnd() const
+    {
+        return m_size && m_data[m_size - 1] == '\n' ? m_size - 1 : m_size;
+    }
+
+    void indexLines()
+    {
+        if (!m_size)
+            return;
+
+        // Counting first is cheap next to regrowing the index for big inputs
+        m_lineStarts.reserve(static_cast<size_t>(std::count(m_data, m_data + m_size, '\n')) + 1);
+        m_lineStarts.push_back(0);
+
+        const char* pos{ m_data };
+        const char* const end{ m_data + m_size };
+        while (const void* found{ std::memchr(pos, '\n', static_cast<size_t>(end - pos)) })
+        {
+            pos = static_cast<const char*>(found) + 1;
+            if (pos == end)
+                break; // Trailing newline, no line after it
+            m_lineStarts.push_back(static_cast<size_t>(pos - m_data));
+        }
+    }
+};
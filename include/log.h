@@ -1,18 +1,247 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstddef>
 #include <filesystem>
 #include <fstream>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
 
 #include "utils.h" // Allows enabling with -l flag
 
+// Logging never writes on the thread doing the logging: each Logger formats into its own buffer,
+// full buffers go through a bounded lock free queue to one background thread that writes them out
+// When the queue's full a Logger either waits for room or drops the chunk (--log-full block / drop)
+namespace logging
+{
+    // The file a Logger writes to, shared with its chunks still in the queue so it closes after the last one's written
+    struct Sink
+    {
+        std::ofstream file;
+        std::atomic<size_t> dropped{ 0 };
+
+        ~Sink()
+        {
+            if (const size_t count{ dropped.load() })
+            {
+                file << "\n[log full, " << count << " chunks dropped]\n";
+            }
+        }
+    };
+
+    struct Chunk
+    {
+        std::shared_ptr<Sink> sink;
+        std::string text;
+    };
+
+    // Bounded multi producer queue, each cell's sequence number says whether it's ready to be pushed to or popped from
+    // (Dmitry Vyukov's bounded MPMC queue, only ever popped by the writer thread)
+    template<size_t Size>
+    class Ring
+    {
+        static_assert((Size & (Size - 1)) == 0, "Ring size must be a power of 2");
+
+    public:
+        Ring()
+        {
+            for (size_t i{ 0 }; i < Size; ++i)
+            {
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        // False if it's full
+        bool tryPush(Chunk &chunk)
+        {
+            size_t pos{ m_pushPos.load(std::memory_order_relaxed) };
+            Cell* cell;
+            while (true)
+            {
+                cell = &m_cells[pos & (Size - 1)];
+                const size_t sequence{ cell->sequence.load(std::memory_order_acquire) };
+                const auto difference{ static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos) };
+                if (difference == 0)
+                {
+                    if (m_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (difference < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = m_pushPos.load(std::memory_order_relaxed);
+                }
+            }
+
+            cell->chunk = std::move(chunk);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        // False if it's empty
+        bool tryPop(Chunk &chunk)
+        {
+            size_t pos{ m_popPos.load(std::memory_order_relaxed) };
+            Cell* cell;
+            while (true)
+            {
+                cell = &m_cells[pos & (Size - 1)];
+                const size_t sequence{ cell->sequence.load(std::memory_order_acquire) };
+                const auto difference{ static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1) };
+                if (difference == 0)
+                {
+                    if (m_popPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (difference < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = m_popPos.load(std::memory_order_relaxed);
+                }
+            }
+
+            chunk = std::move(cell->chunk);
+            cell->sequence.store(pos + Size, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            Chunk chunk;
+        };
+
+        std::array<Cell, Size> m_cells;
+        alignas(64) std::atomic<size_t> m_pushPos{ 0 };
+        alignas(64) std::atomic<size_t> m_popPos{ 0 };
+    };
+
+    // The background thread, started by the first Logger that opens a file and finishing everything queued at exit
+    class Writer
+    {
+    public:
+        static constexpr size_t chunkSize{ 64 * 1024 }; // Loggers hand their buffer over once it's this big
+        static constexpr size_t queueSize{ 256 };       // So at most 16MB waiting to be written
+
+        static Writer& instance()
+        {
+            static Writer writer;
+            return writer;
+        }
+
+        // bDrop: give up rather than wait when it's full, false if it was dropped
+        bool push(Chunk &chunk, bool bDrop)
+        {
+            while (!m_ring.tryPush(chunk))
+            {
+                if (bDrop)
+                {
+                    chunk.sink->dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                // Sleep until the writer pops something
+                const unsigned popped{ m_popped.load(std::memory_order_acquire) };
+                if (!m_ring.tryPush(chunk))
+                {
+                    m_popped.wait(popped, std::memory_order_acquire);
+                    continue;
+                }
+                break;
+            }
+
+            m_pushed.fetch_add(1, std::memory_order_release);
+            m_pushed.notify_one();
+            return true;
+        }
+
+        ~Writer()
+        {
+            m_bStopping.store(true, std::memory_order_release);
+            m_pushed.fetch_add(1, std::memory_order_release);
+            m_pushed.notify_one();
+            m_thread.join();
+        }
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+    private:
+        Ring<queueSize> m_ring;
+        std::atomic<unsigned> m_pushed{ 0 };
+        std::atomic<unsigned> m_popped{ 0 };
+        std::atomic<bool> m_bStopping{ false };
+        std::thread m_thread;
+
+        Writer() : m_thread{ &Writer::work, this } {}
+
+        void work()
+        {
+            Chunk chunk;
+            while (true)
+            {
+                const unsigned pushed{ m_pushed.load(std::memory_order_acquire) };
+
+                // Write everything that's there, then flush the last file once rather than after every chunk
+                std::shared_ptr<Sink> last;
+                while (m_ring.tryPop(chunk))
+                {
+                    m_popped.fetch_add(1, std::memory_order_release);
+                    m_popped.notify_all();
+
+                    if (last && last != chunk.sink)
+                    {
+                        last->file.flush();
+                    }
+                    chunk.sink->file.write(chunk.text.data(), static_cast<std::streamsize>(chunk.text.size()));
+                    last = std::move(chunk.sink);
+                    chunk.text = std::string{};
+                }
+                if (last)
+                {
+                    last->file.flush();
+                    last.reset();
+                }
+
+                if (m_bStopping.load(std::memory_order_acquire))
+                {
+                    // Anything pushed before the stop was seen is already written
+                    if (!m_ring.tryPop(chunk))
+                        return;
+                    chunk.sink->file.write(chunk.text.data(), static_cast<std::streamsize>(chunk.text.size()));
+                    chunk = Chunk{};
+                    continue;
+                }
+
+                m_pushed.wait(pushed, std::memory_order_acquire);
+            }
+        }
+    };
+}
+
 class Logger
 {
     std::string m_filePath;
-    std::ofstream m_logFile;
+    std::shared_ptr<logging::Sink> m_sink;
+    std::string m_buffer; // Only ever touched by the thread that owns the Logger
     bool m_bFileEnabled;
     bool m_bFileOpened; // Disable / Enable logging of particular instance
-    
+    bool m_bActive{ false }; // Enabled, opened and -l, so the hot path only checks this
+    bool m_bDropWhenFull;
+
     static std::filesystem::path defaultDirectory()
     {
         return utils::allLogsDir().append(utils::DayInfo::day());
@@ -20,7 +249,67 @@ class Logger
 
     static std::string defaultFilePath()
     {
-        return defaultDirectory().append(utils::DayInfo::day() + "_log" + (flags::t() ? "_test_" : "_") + (utils::bPuzzle2 ? "pt2" : "pt1" ));
+        return defaultDirectory().append(utils::DayInfo::day() + "_log" + (flags::t() ? "_test_" : "_") + (utils::bPuzzle2() ? "pt2" : "pt1" ));
+    }
+
+    void updateActive()
+    {
+        m_bActive = m_bFileEnabled && m_sink && flags::isSet(flags::Flag::log);
+    }
+
+    // Hand the buffer to the writer thread
+    void submit()
+    {
+        if (m_buffer.empty() || !m_sink)
+            return;
+
+        logging::Chunk chunk{ m_sink, std::move(m_buffer) };
+        logging::Writer::instance().push(chunk, m_bDropWhenFull);
+        m_buffer = std::string{};
+        m_buffer.reserve(logging::Writer::chunkSize);
+    }
+
+    template<typename T>
+    void append(const T &value)
+    {
+        if constexpr (std::is_same_v<T, char>)
+        {
+            m_buffer.push_back(value);
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+        {
+            m_buffer.push_back(value ? '1' : '0');
+        }
+        else if constexpr (std::is_integral_v<T>)
+        {
+            std::array<char, 24> digits;
+            const auto result{ std::to_chars(digits.data(), digits.data() + digits.size(), value) };
+            m_buffer.append(digits.data(), result.ptr);
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            // Same as an ostream's default formatting
+            std::array<char, 32> digits;
+            const auto result{ std::to_chars(digits.data(), digits.data() + digits.size(), value, std::chars_format::general, 6) };
+            m_buffer.append(digits.data(), result.ptr);
+        }
+        else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+        {
+            m_buffer.append(std::string_view{ value });
+        }
+        else
+        {
+            // Anything with its own operator<<
+            thread_local std::ostringstream formatter;
+            formatter.str({});
+            formatter << value;
+            m_buffer.append(formatter.view());
+        }
+
+        if (m_buffer.size() >= logging::Writer::chunkSize)
+        {
+            submit();
+        }
     }
 
 public:
@@ -29,7 +318,11 @@ public:
         return utils::allLogsDir().append(utils::DayInfo::day()).append(fileName);
     }
 
-    Logger(std::string filePath = defaultFilePath(), bool bFileEnabled = true, bool bOverwrite = false) : m_filePath{ filePath }, m_bFileEnabled{ bFileEnabled }, m_bFileOpened{ bFileEnabled }
+    Logger(std::string filePath = defaultFilePath(), bool bFileEnabled = true, bool bOverwrite = false) :
+        m_filePath{ filePath },
+        m_bFileEnabled{ bFileEnabled },
+        m_bFileOpened{ bFileEnabled },
+        m_bDropWhenFull{ run::current().options.bLogDropWhenFull }
     {
         if (!bOverwrite)
         {
@@ -49,19 +342,29 @@ public:
     Logger(bool bFileEnabled) : Logger(defaultFilePath(), bFileEnabled, false) {}
     Logger(bool bFileEnabled, bool bOverwriteEnabled) : Logger(defaultFilePath(), bFileEnabled, bOverwriteEnabled) {}
 
+    // Whatever's left goes to the writer, which finishes it off in the background
+    ~Logger()
+    {
+        submit();
+    }
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
     void log(const char* text)
     {
-        if (m_bFileEnabled && flags::isSet(flags::Flag::log))
+        if (m_bActive)
         {
-            m_logFile << text;
+            append(text);
         }
     }
 
     void ln(const char* text)
     {
-        if (m_bFileEnabled && flags::isSet(flags::Flag::log))
+        if (m_bActive)
         {
-            m_logFile << text << '\n';
+            append(text);
+            append('\n');
         }
     }
 
@@ -70,12 +373,28 @@ public:
         auto fp { std::filesystem::path(m_filePath) };
         std::filesystem::create_directories(fp.parent_path());
 
-        m_logFile = std::ofstream{ m_filePath }; 
-        if (!m_logFile)
+        // Opened here rather than on the writer thread so failing to open is reported straight away
+        auto sink{ std::make_shared<logging::Sink>() };
+        sink->file.open(m_filePath);
+        if (!sink->file)
         {
             std::cerr << "log.h could not open " << m_filePath << " for writing\n";
+            return false;
         }
-        return m_logFile.good();
+
+        submit(); // Anything for a file we opened before
+        m_sink = std::move(sink);
+        m_bFileOpened = true;
+        m_buffer.reserve(logging::Writer::chunkSize);
+        logging::Writer::instance(); // Start the writer before we need it
+        updateActive();
+        return true;
+    }
+
+    // Don't wait for the buffer to fill before sending it to be written
+    void flush()
+    {
+        submit();
     }
 
     void toggleEnabled()
@@ -86,6 +405,7 @@ public:
         {
             open();
         }
+        updateActive();
     }
 
     void setEnabled(bool enable)
@@ -96,6 +416,7 @@ public:
         {
             open();
         }
+        updateActive();
     }
 
     void enable()
@@ -105,19 +426,21 @@ public:
         {
             open();
         }
+        updateActive();
     }
 
     void disable()
     {
         m_bFileEnabled = false;
+        updateActive();
     }
 
     template<typename T>
-    Logger &operator<<(T text)
+    Logger &operator<<(const T &text)
     {
-        if (m_bFileEnabled && flags::isSet(flags::Flag::log))
+        if (m_bActive)
         {
-            m_logFile << text;
+            append(text);
         }
         return *this;
     }
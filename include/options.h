@@ -0,0 +1,338 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Command line options: -1 -t -i file -b 20 -j4 --threads=4 --format json etc
+// Each is a flag (so isSet works as before) and options with a value keep it typed in options::Values
+// Nothing here is global, parse() fills in a Parsed for whichever run::Context wants it
+namespace flags
+{
+    enum class Flag : std::uint32_t
+    {
+        none             = 0,
+        p1               = 1 << 0,  // run puzzle1
+        p2               = 1 << 1,  // run puzzle2
+        test             = 1 << 2,  // use test input
+        debug            = 1 << 3,  // enable debug macros
+        log              = 1 << 4,  // enable logging
+        save_answer      = 1 << 5,  // write puzzle answers to files
+        overwrite_answer = 1 << 6,  // overwrite puzzle answer files
+        custom_input     = 1 << 7,  // follow with input file name
+        parallel         = 1 << 8,  // runner only: run days on all cores, or -j4 for 4 threads
+        benchmark        = 1 << 9,  // runner only: follow with number of timed repetitions
+        regression       = 1 << 10, // runner only: follow with % slower than baseline that fails a benchmark
+        profile          = 1 << 11, // count cycles, instructions and cache misses in PROFILE() phases, -p1 for whole parts only
+        scale            = 1 << 12, // follow with how many times bigger to make generated inputs
+        format           = 1 << 13, // runner only: follow with text or json for the timings table
+        frames           = 1 << 14, // record simulations that support it, follow with bmp or raw
+        render           = 1 << 15, // save a picture from days that can draw one
+        stream           = 1 << 16, // parse the input on a reader thread while solving, in days that read it a line at a time
+    };
+
+    using flag_t = std::underlying_type_t<Flag>;
+
+    inline flag_t fcast(Flag f) { return static_cast<flag_t>(f); }
+    inline Flag fcast(flag_t ft) { return static_cast<Flag>(ft); }
+
+    inline Flag operator|(Flag lhs, Flag rhs) { return fcast(fcast(lhs) | fcast(rhs)); }
+    inline Flag operator&(Flag lhs, Flag rhs) { return fcast(fcast(lhs) & fcast(rhs)); }
+    inline Flag operator^(Flag lhs, Flag rhs) { return fcast(fcast(lhs) ^ fcast(rhs)); }
+    inline Flag operator~(Flag f) { return fcast(~fcast(f)); }
+
+    inline Flag& operator|=(Flag& lhs, Flag rhs) { lhs = lhs | rhs; return lhs; }
+    inline Flag& operator&=(Flag& lhs, Flag rhs) { lhs = lhs & rhs; return lhs; }
+    inline Flag& operator^=(Flag& lhs, Flag rhs) { lhs = lhs ^ rhs; return lhs; }
+}
+
+namespace options
+{
+    enum class Format
+    {
+        text,
+        json
+    };
+
+    enum class FrameFormat
+    {
+        bmp, // A numbered BMP per frame
+        raw  // One file of changed rows, see include/frames.h
+    };
+
+    // Values of the options that take one, these are the defaults when they're not given
+    struct Values
+    {
+        std::string input;               // -i, empty for input / test
+        unsigned threads{ 0 };           // -j, 0 for every core
+        int repetitions{ 0 };            // -b, 0 for no benchmark
+        double regression{ 25.0 };       // -r, % slower than the baseline that fails
+        double scale{ 1.0 };             // -x, generated input size multiplier
+        Format format{ Format::text };   // -f
+        int profileLevel{ 2 };           // -p, 1 for whole parts, 2 for the days' phases as well
+        bool bLogDropWhenFull{ false };  // --log-full drop, Loggers wait for room by default
+        std::uint64_t seed{ 2022 };      // --seed, for generated inputs
+        std::vector<double> sweep;       // --sweep 1,10,100, runner only: run each day on generated inputs of each scale
+        FrameFormat frameFormat{ FrameFormat::bmp }; // --frames
+        unsigned frameEvery{ 1 };        // --frame-every, only record every nth step
+
+        // Values of options added with add() that don't have a place above, by long name
+        std::map<std::string, std::string, std::less<>> extra;
+    };
+
+    enum class Arg
+    {
+        none,
+        required, // -b 20, -b20, --benchmark 20 or --benchmark=20
+        optional  // Only attached: -j4 or --threads=4, so -j 4 still leaves 4 as a day number
+    };
+
+    struct Option
+    {
+        char shortName;               // '\0' if there's only the long one
+        std::string_view longName;
+        flags::Flag flag;             // Set when it's given, can be none for added options
+        Arg arg{ Arg::none };
+        std::function<bool(Values&, std::string_view)> parse{}; // False if the value's no good, unset stores it in extra
+    };
+
+    // Numbers have to be the whole value and no less than min
+    template<typename T>
+    bool parseNumber(std::string_view str, T &value, T min)
+    {
+        T parsed{};
+        const auto result{ std::from_chars(str.data(), str.data() + str.length(), parsed) };
+        if (result.ec != std::errc{} || result.ptr != str.data() + str.length() || parsed < min)
+            return false;
+
+        value = parsed;
+        return true;
+    }
+
+    // Function static so options can be added before main
+    inline std::vector<Option>& all()
+    {
+        static std::vector<Option> table{
+            { '1', "pt1",        flags::Flag::p1 },
+            { '2', "pt2",        flags::Flag::p2 },
+            { 't', "test",       flags::Flag::test },
+            { 'd', "debug",      flags::Flag::debug },
+            { 'l', "log",        flags::Flag::log },
+            { 's', "save",       flags::Flag::save_answer },
+            { 'o', "overwrite",  flags::Flag::overwrite_answer },
+            { 'i', "input",      flags::Flag::custom_input, Arg::required,
+                [](Values &values, std::string_view str) { values.input = str; return !str.empty() && str[0] != '-'; } },
+            { 'j', "threads",    flags::Flag::parallel, Arg::optional,
+                [](Values &values, std::string_view str) { return parseNumber(str, values.threads, 1u); } },
+            { 'b', "benchmark",  flags::Flag::benchmark, Arg::required,
+                [](Values &values, std::string_view str) { return parseNumber(str, values.repetitions, 1); } },
+            { 'r', "regression", flags::Flag::regression, Arg::required,
+                [](Values &values, std::string_view str) { return parseNumber(str, values.regression, 0.0); } },
+            { 'p', "profile",    flags::Flag::profile, Arg::optional,
+                [](Values &values, std::string_view str) { return parseNumber(str, values.profileLevel, 1) && values.profileLevel <= 2; } },
+            { 'x', "scale",      flags::Flag::scale, Arg::required,
+                [](Values &values, std::string_view str) { return parseNumber(str, values.scale, 0.0) && values.scale > 0.0; } },
+            { 'f', "format",     flags::Flag::format, Arg::required,
+                [](Values &values, std::string_view str)
+                {
+                    if (str == "text") values.format = Format::text;
+                    else if (str == "json") values.format = Format::json;
+                    else return false;
+                    return true;
+                } },
+            { '\0', "seed",      flags::Flag::none, Arg::required,
+                [](Values &values, std::string_view str) { return parseNumber(str, values.seed, std::uint64_t{ 0 }); } },
+            { '\0', "sweep",     flags::Flag::none, Arg::required,
+                [](Values &values, std::string_view str)
+                {
+                    values.sweep.clear();
+                    while (!str.empty())
+                    {
+                        const auto comma{ str.find(',') };
+                        double scale{ 0.0 };
+                        if (!parseNumber(str.substr(0, comma), scale, 0.0) || scale <= 0.0)
+                            return false;
+                        values.sweep.push_back(scale);
+                        str = comma == std::string_view::npos ? std::string_view{} : str.substr(comma + 1);
+                    }
+                    return !values.sweep.empty();
+                } },
+            { '\0', "frames",    flags::Flag::frames, Arg::required,
+                [](Values &values, std::string_view str)
+                {
+                    if (str == "bmp") values.frameFormat = FrameFormat::bmp;
+                    else if (str == "raw") values.frameFormat = FrameFormat::raw;
+                    else return false;
+                    return true;
+                } },
+            { '\0', "render",    flags::Flag::render },
+            { '\0', "stream",    flags::Flag::stream },
+            { '\0', "frame-every", flags::Flag::none, Arg::required,
+                [](Values &values, std::string_view str) { return parseNumber(str, values.frameEvery, 1u); } },
+            { '\0', "log-full",  flags::Flag::none, Arg::required,
+                [](Values &values, std::string_view str)
+                {
+                    if (str == "block") values.bLogDropWhenFull = false;
+                    else if (str == "drop") values.bLogDropWhenFull = true;
+                    else return false;
+                    return true;
+                } },
+        };
+        return table;
+    }
+
+    // For anything that wants a knob of its own, e.g. options::add({ '\0', "depth", flags::Flag::none, options::Arg::required });
+    // then values.extra["depth"] after parsing
+    inline void add(Option option) { all().push_back(std::move(option)); }
+
+    inline const Option* find(char shortName)
+    {
+        for (const auto &option : all())
+        {
+            if (option.shortName == shortName) return &option;
+        }
+        return nullptr;
+    }
+
+    inline const Option* find(std::string_view longName)
+    {
+        for (const auto &option : all())
+        {
+            if (option.longName == longName) return &option;
+        }
+        return nullptr;
+    }
+
+    struct Parsed
+    {
+        flags::Flag flags{ flags::Flag::none };
+        Values values;
+        std::vector<std::string> positional; // Everything that isn't an option or its value (day numbers)
+    };
+
+    inline std::string describe(const Option &option)
+    {
+        std::string name{ option.longName };
+        if (option.shortName)
+        {
+            name += " (-";
+            name += option.shortName;
+            name += ')';
+        }
+        return name;
+    }
+
+    // A bad or missing value leaves the option unset with a message, same as an unknown option
+    inline void apply(Parsed &parsed, const Option &option, const std::string_view* value)
+    {
+        if (!value)
+        {
+            if (option.arg == Arg::required)
+            {
+                std::cerr << describe(option) << " is set but not followed by a value\n";
+                return;
+            }
+        }
+        else if (option.parse)
+        {
+            if (!option.parse(parsed.values, *value))
+            {
+                std::cerr << describe(option) << " can't use \"" << *value << "\"\n";
+                return;
+            }
+        }
+        else
+        {
+            parsed.values.extra[std::string{ option.longName }] = *value;
+        }
+        parsed.flags |= option.flag;
+    }
+
+    inline bool isDigit(char ch) { return ch >= '0' && ch <= '9'; }
+
+    // The next argument is a value unless it's another option (none of the values can be negative)
+    inline bool takesNext(int i, int argc, char* argv[]) { return i + 1 < argc && argv[i + 1][0] != '-'; }
+
+    inline Parsed parse(int argc, char* argv[])
+    {
+        Parsed parsed;
+
+        for (int i{ 1 }; i < argc; ++i)
+        {
+            const std::string_view arg{ argv[i] };
+
+            if (arg.length() > 2 && arg.substr(0, 2) == "--")
+            {
+                const auto equals{ arg.find('=') };
+                const std::string_view name{ arg.substr(2, equals == std::string_view::npos ? std::string_view::npos : equals - 2) };
+                const Option* option{ find(name) };
+                if (!option)
+                {
+                    std::cerr << "unknown option --" << name << '\n';
+                    continue;
+                }
+
+                if (equals != std::string_view::npos)
+                {
+                    const std::string_view value{ arg.substr(equals + 1) };
+                    apply(parsed, *option, option->arg == Arg::none ? nullptr : &value);
+                }
+                else if (option->arg == Arg::required && takesNext(i, argc, argv))
+                {
+                    const std::string_view value{ argv[++i] };
+                    apply(parsed, *option, &value);
+                }
+                else
+                {
+                    apply(parsed, *option, nullptr);
+                }
+                continue;
+            }
+
+            if (arg.length() < 2 || arg[0] != '-')
+            {
+                parsed.positional.emplace_back(arg);
+                continue;
+            }
+
+            // Bunched up short ones, -1t, -tb 20, -tb20
+            for (size_t j{ 1 }; j < arg.length(); ++j)
+            {
+                const Option* option{ find(arg[j]) };
+                if (!option)
+                {
+                    std::cerr << "unknown flag -" << arg[j] << '\n';
+                    continue;
+                }
+
+                const std::string_view rest{ arg.substr(j + 1) };
+                if (option->arg == Arg::none)
+                {
+                    apply(parsed, *option, nullptr);
+                }
+                else if (!rest.empty() && (option->arg == Arg::required || isDigit(rest[0])))
+                {
+                    apply(parsed, *option, &rest);
+                    break;
+                }
+                else if (rest.empty() && option->arg == Arg::required && takesNext(i, argc, argv))
+                {
+                    const std::string_view value{ argv[++i] };
+                    apply(parsed, *option, &value);
+                }
+                else
+                {
+                    apply(parsed, *option, nullptr);
+                }
+            }
+        }
+
+        return parsed;
+    }
+};
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+# define PROFILE_PERF_EVENTS
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+#include "timer.h"
+#include "utils.h" // Allows enabling with -p flag
+
+// Hardware counters for the phases of a solve, PROFILE("parse"); counts from there to the end of the enclosing block
+// Does nothing without the -p flag (-p1 leaves out the days' phases). Uses perf_event_open on Linux, only wall time elsewhere or if the kernel won't let us
+// Counts are per thread and a phase includes any phases nested inside it
+// Entering the same phase recursively counts the inner time twice, so keep them to the top level of a solve
+namespace profile
+{
+    enum Counter
+    {
+        cycles,
+        instructions,
+        cacheMisses,
+        branchMisses,
+        counterCount
+    };
+
+    using counts_t = std::array<std::uint64_t, counterCount>;
+
+    struct Phase
+    {
+        int calls{ 0 };
+        double seconds{ 0.0 };
+        counts_t counts{};
+        bool bCounted{ false }; // False if the hardware counters weren't available
+
+        double ipc() const
+        {
+            return counts[cycles] ? static_cast<double>(counts[instructions]) / static_cast<double>(counts[cycles]) : 0.0;
+        }
+
+        // Cache misses per 1000 instructions
+        double mpki() const
+        {
+            return counts[instructions] ? 1000.0 * static_cast<double>(counts[cacheMisses]) / static_cast<double>(counts[instructions]) : 0.0;
+        }
+    };
+
+    // Phases in the order they were first entered
+    using phases_t = std::vector<std::pair<std::string, Phase>>;
+
+    inline thread_local phases_t threadPhases;
+
+    // Hands over everything the thread has counted so far and starts again
+    inline phases_t takePhases() { return std::exchange(threadPhases, {}); }
+
+    // One group of counters per thread, opened the first time a phase starts on it and left running
+    // Phases read it at their start and end and keep the difference
+    class Counters
+    {
+    public:
+        static Counters& thread()
+        {
+            thread_local Counters counters;
+            return counters;
+        }
+
+        bool available() const { return m_leader >= 0; }
+
+        // False if the counters aren't available
+        bool read(counts_t &values) const
+        {
+#ifdef PROFILE_PERF_EVENTS
+            if (!available())
+                return false;
+
+            // PERF_FORMAT_GROUP layout: count, time enabled, time running, then a value per event in the order they were opened
+            std::array<std::uint64_t, 3 + counterCount> buffer{};
+            if (::read(m_leader, buffer.data(), sizeof(buffer)) < 0)
+                return false;
+
+            const std::uint64_t enabled{ buffer[1] };
+            const std::uint64_t running{ buffer[2] };
+            for (int counter{ 0 }; counter < counterCount; ++counter)
+            {
+                const int slot{ m_slots[ST(counter)] };
+                std::uint64_t value{ slot < 0 ? 0 : buffer[3 + ST(slot)] };
+                // The kernel multiplexes when there aren't enough hardware counters to go round, scale up to make up for it
+                if (running && running < enabled)
+                {
+                    value = static_cast<std::uint64_t>(static_cast<double>(value) * static_cast<double>(enabled) / static_cast<double>(running));
+                }
+                values[ST(counter)] = value;
+            }
+            return true;
+#else
+            (void)values;
+            return false;
+#endif
+        }
+
+        ~Counters()
+        {
+#ifdef PROFILE_PERF_EVENTS
+            for (int fd : m_fds)
+            {
+                if (fd >= 0) ::close(fd);
+            }
+#endif
+        }
+
+        Counters(const Counters&) = delete;
+        Counters& operator=(const Counters&) = delete;
+
+    private:
+        int m_leader{ -1 };
+        std::array<int, counterCount> m_fds{ -1, -1, -1, -1 };
+        std::array<int, counterCount> m_slots{ -1, -1, -1, -1 }; // Position in the group read, -1 if it didn't open
+
+        Counters()
+        {
+#ifdef PROFILE_PERF_EVENTS
+            constexpr std::array<std::uint64_t, counterCount> configs{
+                PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+            };
+
+            int opened{ 0 };
+            int firstError{ 0 };
+            for (int counter{ 0 }; counter < counterCount; ++counter)
+            {
+                perf_event_attr attr{};
+                attr.size = sizeof(attr);
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = configs[ST(counter)];
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+                // This thread on any cpu, the first one that opens leads the group
+                const int fd{ static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, m_leader, PERF_FLAG_FD_CLOEXEC)) };
+                if (fd < 0)
+                {
+                    if (!firstError) firstError = errno;
+                    continue;
+                }
+
+                if (m_leader < 0) m_leader = fd;
+                m_fds[ST(counter)] = fd;
+                m_slots[ST(counter)] = opened++;
+            }
+
+            if (!available())
+            {
+                warn(std::strerror(firstError));
+            }
+#else
+            warn("not supported on this platform");
+#endif
+        }
+
+        // Once per run, not once per thread
+        static void warn(const char* reason)
+        {
+            static std::atomic<bool> bWarned{ false };
+            if (!bWarned.exchange(true))
+            {
+                std::cerr << style::yellow << "hardware counters unavailable (" << reason << "), profiling wall time only" << style::reset << '\n';
+            }
+        }
+    };
+
+    class Scope
+    {
+    public:
+        // -p1 only counts level 1 scopes (the runner's whole parts), -p or -p2 the days' phases too
+        explicit Scope(const char* name, int level = 2) :
+            m_name{ name },
+            m_bActive{ flags::isSet(flags::Flag::profile) && run::current().options.profileLevel >= level }
+        {
+            if (!m_bActive)
+                return;
+
+            m_index = find(); // Entered order, so a phase comes before the ones nested in it
+            m_bCounted = Counters::thread().read(m_start);
+            m_timer.reset();
+        }
+
+        ~Scope()
+        {
+            if (!m_bActive || m_index >= threadPhases.size()) // Taken while we were open
+                return;
+
+            const double seconds{ m_timer.elapsed() };
+            counts_t end{};
+            const bool bCounted{ m_bCounted && Counters::thread().read(end) };
+
+            Phase &phase{ threadPhases[m_index].second };
+            ++phase.calls;
+            phase.seconds += seconds;
+            if (bCounted)
+            {
+                phase.bCounted = true;
+                for (size_t i{ 0 }; i < phase.counts.size(); ++i)
+                {
+                    phase.counts[i] += end[i] - m_start[i];
+                }
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* m_name;
+        bool m_bActive;
+        bool m_bCounted{ false };
+        size_t m_index{ 0 };
+        counts_t m_start{};
+        Timer m_timer;
+
+        size_t find() const
+        {
+            for (size_t i{ 0 }; i < threadPhases.size(); ++i)
+            {
+                if (threadPhases[i].first == m_name) return i;
+            }
+            threadPhases.emplace_back(m_name, Phase{});
+            return threadPhases.size() - 1;
+        }
+    };
+
+    inline void printCount(std::ostream &out, const Phase &phase, Counter counter, int width)
+    {
+        if (phase.bCounted)
+            out << std::setw(width) << phase.counts[counter];
+        else
+            out << std::setw(width) << "-";
+    }
+
+    // One line per phase, IPC and cache misses per 1000 instructions alongside the raw counts
+    inline void print(std::ostream &out, const phases_t &phases)
+    {
+        if (phases.empty())
+            return;
+
+        const auto flags{ out.flags() };
+        const auto precision{ out.precision() };
+
+        out << style::bold << std::setw(12) << "phase" << std::setw(7) << "calls" << std::setw(12) << "seconds"
+            << std::setw(14) << "cycles" << std::setw(14) << "instructions" << std::setw(7) << "IPC"
+            << std::setw(13) << "cache misses" << std::setw(7) << "MPKI" << std::setw(14) << "branch misses" << style::reset << '\n';
+
+        out << std::fixed;
+        for (const auto &[name, phase] : phases)
+        {
+            out << std::setw(12) << name << std::setw(7) << phase.calls << std::setprecision(6) << std::setw(12) << phase.seconds;
+            printCount(out, phase, cycles, 14);
+            printCount(out, phase, instructions, 14);
+            if (phase.bCounted)
+                out << std::setprecision(2) << std::setw(7) << phase.ipc();
+            else
+                out << std::setw(7) << "-";
+            printCount(out, phase, cacheMisses, 13);
+            if (phase.bCounted)
+                out << std::setprecision(2) << std::setw(7) << phase.mpki();
+            else
+                out << std::setw(7) << "-";
+            printCount(out, phase, branchMisses, 14);
+            out << '\n';
+        }
+
+        out.flags(flags);
+        out.precision(precision);
+    }
+};
+
+# define PROFILE_CONCAT_(a, b) a##b
+# define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+# define PROFILE(name) profile::Scope PROFILE_CONCAT(profileScope, __LINE__){ name }
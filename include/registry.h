@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "generate.h"
+#include "profile.h"
+#include "utils.h"
+
+// Every dayxx.cpp ends with AOC_MAIN(dayxx)
+// Compiled on its own that gives the usual main(), compiled with -DAOC_RUNNER it registers the day's puzzles
+// with src/runner.cpp instead, so all the days can be linked into one executable
+namespace registry
+{
+    using solve_t = void (*)(const std::string&);
+
+    struct Day
+    {
+        int number;
+        std::filesystem::path cppFile;
+        std::array<solve_t, 2> parts;
+        generate::generator_t generator;
+
+        // part is 1 or 2
+        solve_t solver(int part) const { return parts[ST(part - 1)]; }
+
+        // With -x, swaps the input for a generated one of that scale (making it first if need be)
+        void useGenerated() const
+        {
+            if (!flags::isSet(flags::Flag::scale))
+                return;
+
+            auto &options{ run::current().options };
+            options.input = generate::ensureInput(cppFile, number, generator, options.scale, options.seed);
+            flags::set(flags::Flag::custom_input);
+        }
+    };
+
+    // Function static so it exists before any of the day files' registrars run
+    inline std::map<int, Day>& days()
+    {
+        static std::map<int, Day> registered;
+        return registered;
+    }
+
+    // "day07.cpp" -> 7
+    inline int dayNumber(const std::filesystem::path &cppFile)
+    {
+        return std::stoi(cppFile.stem().string().substr(3));
+    }
+
+    struct Registrar
+    {
+        Registrar(const std::filesystem::path &cppFile, solve_t pt1, solve_t pt2, generate::generator_t generator)
+        {
+            const int number{ dayNumber(cppFile) };
+            days()[number] = Day{ number, cppFile, { pt1, pt2 }, generator };
+        }
+    };
+
+    // What each day's main() used to do
+    inline int runSingle(int argc, char* argv[], const std::filesystem::path &cppFile, solve_t pt1, solve_t pt2, generate::generator_t generator)
+    {
+        flags::set(argc, argv);
+
+        try
+        {
+            Day{ dayNumber(cppFile), cppFile, { pt1, pt2 }, generator }.useGenerated();
+            const std::string input{ utils::inputFile(cppFile) };
+
+            if (utils::doP1())
+            {
+                { profile::Scope part{ "pt1", 1 }; pt1(input); }
+                profile::print(std::cout, profile::takePhases());
+            }
+            if (utils::doP2())
+            {
+                { profile::Scope part{ "pt2", 1 }; pt2(input); }
+                profile::print(std::cout, profile::takePhases());
+            }
+        }
+        catch(const std::exception& e)
+        {
+            std::cerr << e.what() << '\n';
+        }
+
+        return 0;
+    }
+};
+
+#ifdef AOC_RUNNER
+# define AOC_MAIN(ns) static const registry::Registrar ns##Registrar{ __FILE__, ns::Puzzle1::solve, ns::Puzzle2::solve, ns::Generate::input };
+#else
+# define AOC_MAIN(ns) int main(int argc, char* argv[]) { return registry::runSingle(argc, argv, __FILE__, ns::Puzzle1::solve, ns::Puzzle2::solve, ns::Generate::input); }
+#endif
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+# include <immintrin.h>
+#endif
+
+// Fast delimiter finding and integer parsing for the input helpers
+// find() and count() use AVX2 or SSE2 when the compiler targets them (-mavx2 / x86-64 default), a plain loop elsewise
+// Tokens and Ints keep their buffers between calls, so splitting line after line doesn't allocate
+namespace scan
+{
+    // First ch in [first, last), or last
+    inline const char* find(const char* first, const char* last, char ch)
+    {
+#if defined(__AVX2__)
+        const __m256i needle{ _mm256_set1_epi8(ch) };
+        while (last - first >= 32)
+        {
+            const __m256i block{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first)) };
+            if (const auto mask{ static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle))) })
+            {
+                return first + __builtin_ctz(mask);
+            }
+            first += 32;
+        }
+#endif
+#if defined(__SSE2__)
+        const __m128i needle16{ _mm_set1_epi8(ch) };
+        while (last - first >= 16)
+        {
+            const __m128i block{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(first)) };
+            if (const auto mask{ static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle16))) })
+            {
+                return first + __builtin_ctz(mask);
+            }
+            first += 16;
+        }
+#endif
+        while (first < last && *first != ch)
+        {
+            ++first;
+        }
+        return first;
+    }
+
+    // How many ch in [first, last)
+    inline size_t count(const char* first, const char* last, char ch)
+    {
+        size_t matches{ 0 };
+#if defined(__AVX2__)
+        const __m256i needle{ _mm256_set1_epi8(ch) };
+        while (last - first >= 32)
+        {
+            const __m256i block{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first)) };
+            matches += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle)))));
+            first += 32;
+        }
+#endif
+#if defined(__SSE2__)
+        const __m128i needle16{ _mm_set1_epi8(ch) };
+        while (last - first >= 16)
+        {
+            const __m128i block{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(first)) };
+            matches += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle16)))));
+            first += 16;
+        }
+#endif
+        for (; first < last; ++first)
+        {
+            matches += *first == ch;
+        }
+        return matches;
+    }
+
+    // Start of the first match of splitOn in str from pos, or str.length()
+    inline size_t find(std::string_view str, std::string_view splitOn, size_t pos = 0)
+    {
+        const char* const begin{ str.data() };
+        const char* const end{ begin + str.length() };
+        const char* at{ begin + pos };
+
+        while (true)
+        {
+            at = find(at, end, splitOn[0]);
+            if (static_cast<size_t>(end - at) < splitOn.length())
+            {
+                return str.length();
+            }
+            if (std::memcmp(at + 1, splitOn.data() + 1, splitOn.length() - 1) == 0)
+            {
+                return static_cast<size_t>(at - begin);
+            }
+            ++at;
+        }
+    }
+
+    // Where each thread's part of data starts (and its end last), always at the start of a line
+    // One part per thread (every core if threads is 0), but none under 1MB so small inputs stay on one thread
+    inline std::vector<const char*> splitAtLines(std::string_view data, unsigned threads)
+    {
+        // Not worth starting a thread for less than this
+        constexpr size_t minChunk{ 1 << 20 };
+        const size_t chunks{ std::max<size_t>(std::min<size_t>(threads ? threads : std::thread::hardware_concurrency(), data.size() / minChunk), 1) };
+        const char* const end{ data.data() + data.size() };
+
+        std::vector<const char*> starts{ data.data() };
+        for (size_t i{ 1 }; i < chunks; ++i)
+        {
+            const char* const newline{ find(std::max(data.data() + data.size() / chunks * i, starts.back()), end, '\n') };
+            if (newline == end)
+            {
+                break;
+            }
+            starts.push_back(newline + 1);
+        }
+        starts.push_back(end);
+        return starts;
+    }
+
+    // Calls fnc with each piece of str between splitOns (not a trailing empty one, same as utils::split)
+    template<typename Fnc>
+    void forEachSplit(std::string_view str, std::string_view splitOn, Fnc &&fnc)
+    {
+        size_t start{ 0 };
+        while (start < str.length())
+        {
+            const auto match{ find(str, splitOn, start) };
+            fnc(str.substr(start, match - start));
+            start = match + splitOn.length();
+        }
+    }
+
+    // Like std::stoi: skips leading spaces and a '+', throws std::invalid_argument if there's no number
+    // Sets end to one past the number
+    template<typename T = int>
+    T toInt(std::string_view str, const char* &end)
+    {
+        const char* first{ str.data() };
+        const char* const last{ first + str.length() };
+        while (first < last && (*first == ' ' || *first == '\t'))
+        {
+            ++first;
+        }
+        if (first < last && *first == '+')
+        {
+            ++first;
+        }
+
+        T value{};
+        const auto result{ std::from_chars(first, last, value) };
+        if (result.ec != std::errc{})
+        {
+            throw std::invalid_argument{ "scan::toInt: no number in \"" + std::string{ str } + '"' };
+        }
+        end = result.ptr;
+        return value;
+    }
+
+    template<typename T = int>
+    T toInt(std::string_view str)
+    {
+        const char* end;
+        return toInt<T>(str, end);
+    }
+
+    // Reusable list of views into the string being split (they're only valid as long as it is)
+    class Tokens
+    {
+    public:
+        std::span<const std::string_view> split(std::string_view str, std::string_view splitOn)
+        {
+            m_tokens.clear();
+            forEachSplit(str, splitOn, [this](std::string_view token) { m_tokens.push_back(token); });
+            return m_tokens;
+        }
+
+    private:
+        std::vector<std::string_view> m_tokens;
+    };
+
+    // Reusable list of parsed integers
+    template<typename T = int>
+    class Ints
+    {
+    public:
+        // Every piece between splitOns must be a number
+        std::span<const T> split(std::string_view str, std::string_view splitOn)
+        {
+            m_ints.clear();
+            forEachSplit(str, splitOn, [this](std::string_view token) { m_ints.push_back(toInt<T>(token)); });
+            return m_ints;
+        }
+
+        // Every run of digits in str, whatever's between them ("x=-2, y=15" -> -2, 15)
+        // A '-' right before digits makes them negative if bSigned, so "2-4" is 2, 4 when it's false
+        std::span<const T> extract(std::string_view str, bool bSigned = true)
+        {
+            m_ints.clear();
+            const char* at{ str.data() };
+            const char* const end{ at + str.length() };
+            while (at < end)
+            {
+                const bool bDigit{ *at >= '0' && *at <= '9' };
+                const bool bNegative{ bSigned && *at == '-' && at + 1 < end && at[1] >= '0' && at[1] <= '9' };
+                if (!bDigit && !bNegative)
+                {
+                    ++at;
+                    continue;
+                }
+
+                T value{};
+                at = std::from_chars(at, end, value).ptr;
+                m_ints.push_back(value);
+            }
+            return m_ints;
+        }
+
+    private:
+        std::vector<T> m_ints;
+    };
+};
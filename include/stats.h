@@ -0,0 +1,278 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numbers>
+#include <numeric>
+#include <vector>
+
+// One pass summaries of a stream of numbers in a fixed amount of memory, however many there are
+// Each can merge() another of its kind, so a thread can keep its own and they're combined at the end
+// TopK:      the k biggest
+// TDigest:   approximate quantiles, closest at the tails (Dunning's merging t-digest)
+// Histogram: exact counts in a fixed number of buckets that get wider as bigger values turn up
+namespace stats
+{
+    // A min heap so the smallest of the k is the one a new value has to beat
+    template<typename T>
+    class TopK
+    {
+    public:
+        explicit TopK(size_t k) : m_k{ k }
+        {
+            m_heap.reserve(k);
+        }
+
+        void push(T value)
+        {
+            if (m_heap.size() < m_k)
+            {
+                m_heap.push_back(value);
+                std::push_heap(m_heap.begin(), m_heap.end(), std::greater<>{});
+            }
+            else if (m_k && value > m_heap.front())
+            {
+                std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<>{});
+                m_heap.back() = value;
+                std::push_heap(m_heap.begin(), m_heap.end(), std::greater<>{});
+            }
+        }
+
+        void merge(const TopK &other)
+        {
+            for (const T &value : other.m_heap)
+            {
+                push(value);
+            }
+        }
+
+        size_t k() const { return m_k; }
+
+        // Biggest first
+        std::vector<T> sorted() const
+        {
+            std::vector<T> values{ m_heap };
+            std::sort(values.begin(), values.end(), std::greater<>{});
+            return values;
+        }
+
+        long long sum() const
+        {
+            return std::accumulate(m_heap.begin(), m_heap.end(), 0LL);
+        }
+
+    private:
+        size_t m_k;
+        std::vector<T> m_heap;
+    };
+
+    // Values are buffered then merged into a sorted list of centroids (mean, weight), which are only allowed to get big
+    // in the middle of the distribution, so the tails stay close to exact. About compression centroids at most
+    class TDigest
+    {
+    public:
+        explicit TDigest(double compression = 100.0) : m_compression{ compression }
+        {
+            m_buffer.reserve(bufferSize());
+        }
+
+        void add(double value, double weight = 1.0)
+        {
+            m_buffer.push_back({ value, weight });
+            m_count += weight;
+            m_min = std::min(m_min, value);
+            m_max = std::max(m_max, value);
+
+            if (m_buffer.size() >= bufferSize())
+            {
+                compress();
+            }
+        }
+
+        void merge(const TDigest &other)
+        {
+            for (const auto *centroids : { &other.m_centroids, &other.m_buffer })
+            {
+                for (const auto &centroid : *centroids)
+                {
+                    add(centroid.mean, centroid.weight);
+                }
+            }
+        }
+
+        double count() const { return m_count; }
+        double min() const { return m_min; }
+        double max() const { return m_max; }
+
+        // q from 0 to 1, NaN when nothing's been added
+        double quantile(double q)
+        {
+            compress();
+            if (m_centroids.empty())
+            {
+                return std::numeric_limits<double>::quiet_NaN();
+            }
+
+            q = std::clamp(q, 0.0, 1.0);
+            const double index{ q * m_count };
+
+            // Each centroid's mean sits at the middle of its weight, between those it's a straight line
+            // Before the first and after the last it's a line to the min / max
+            double before{ 0.0 };
+            double previousMean{ m_min };
+            double previousMiddle{ 0.0 };
+            for (const auto &centroid : m_centroids)
+            {
+                const double middle{ before + centroid.weight / 2.0 };
+                if (index < middle)
+                {
+                    return interpolate(previousMean, centroid.mean, previousMiddle, middle, index);
+                }
+                before += centroid.weight;
+                previousMean = centroid.mean;
+                previousMiddle = middle;
+            }
+            return interpolate(previousMean, m_max, previousMiddle, m_count, index);
+        }
+
+    private:
+        struct Centroid
+        {
+            double mean;
+            double weight;
+        };
+
+        double m_compression;
+        std::vector<Centroid> m_centroids; // Sorted by mean
+        std::vector<Centroid> m_buffer;    // Added since the last compress()
+        double m_count{ 0.0 };
+        double m_min{ std::numeric_limits<double>::infinity() };
+        double m_max{ -std::numeric_limits<double>::infinity() };
+
+        size_t bufferSize() const { return static_cast<size_t>(m_compression) * 5; }
+
+        static double interpolate(double from, double to, double fromIndex, double toIndex, double index)
+        {
+            if (toIndex <= fromIndex)
+            {
+                return to;
+            }
+            return from + (to - from) * (index - fromIndex) / (toIndex - fromIndex);
+        }
+
+        // The k1 scale: centroids can only span 1 of k, which is steep near q = 0 and 1 so they stay small there
+        double k(double q) const
+        {
+            return m_compression / (2.0 * std::numbers::pi) * std::asin(2.0 * q - 1.0);
+        }
+
+        double q(double k) const
+        {
+            const double limit{ m_compression / 4.0 };
+            return (std::sin(std::min(k, limit) * 2.0 * std::numbers::pi / m_compression) + 1.0) / 2.0;
+        }
+
+        void compress()
+        {
+            if (m_buffer.empty())
+            {
+                return;
+            }
+
+            m_buffer.insert(m_buffer.end(), m_centroids.begin(), m_centroids.end());
+            std::sort(m_buffer.begin(), m_buffer.end(), [](const Centroid &a, const Centroid &b) { return a.mean < b.mean; });
+            m_centroids.clear();
+
+            double before{ 0.0 };
+            double qLimit{ q(k(0.0) + 1.0) };
+            Centroid current{ m_buffer.front() };
+            for (auto centroid{ m_buffer.begin() + 1 }; centroid != m_buffer.end(); ++centroid)
+            {
+                if ((before + current.weight + centroid->weight) / m_count <= qLimit)
+                {
+                    current.weight += centroid->weight;
+                    current.mean += (centroid->mean - current.mean) * centroid->weight / current.weight;
+                    continue;
+                }
+
+                m_centroids.push_back(current);
+                before += current.weight;
+                qLimit = q(k(before / m_count) + 1.0);
+                current = *centroid;
+            }
+            m_centroids.push_back(current);
+            m_buffer.clear();
+        }
+    };
+
+    // Buckets of width() from 0, the width doubles whenever a value doesn't fit in the last one (each pair of buckets merging)
+    // so the counts are exact for whatever range the values turn out to cover
+    class Histogram
+    {
+    public:
+        explicit Histogram(size_t buckets = 16) : m_counts(std::max<size_t>(buckets, 2)) {}
+
+        void add(std::uint64_t value)
+        {
+            while (value / m_width >= m_counts.size())
+            {
+                widen();
+            }
+            ++m_counts[value / m_width];
+        }
+
+        void merge(const Histogram &other)
+        {
+            Histogram widened{ other };
+            while (widened.m_width < m_width)
+            {
+                widened.widen();
+            }
+            while (m_width < widened.m_width)
+            {
+                widen();
+            }
+
+            for (size_t i{ 0 }; i < m_counts.size() && i < widened.m_counts.size(); ++i)
+            {
+                m_counts[i] += widened.m_counts[i];
+            }
+        }
+
+        size_t buckets() const { return m_counts.size(); }
+        std::uint64_t width() const { return m_width; }
+        std::uint64_t count(size_t bucket) const { return m_counts[bucket]; }
+
+        // The last bucket anything's in, or buckets() if it's empty
+        size_t lastUsed() const
+        {
+            for (size_t i{ m_counts.size() }; i-- > 0;)
+            {
+                if (m_counts[i])
+                {
+                    return i;
+                }
+            }
+            return m_counts.size();
+        }
+
+    private:
+        std::vector<std::uint64_t> m_counts;
+        std::uint64_t m_width{ 1 };
+
+        void widen()
+        {
+            for (size_t i{ 0 }; i < m_counts.size(); ++i)
+            {
+                const auto count{ m_counts[i] };
+                m_counts[i] = 0;
+                m_counts[i / 2] += count;
+            }
+            m_width *= 2;
+        }
+    };
+};
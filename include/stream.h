@@ -0,0 +1,298 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "scan.h"
+#include "utils.h"
+
+// Reading a line-per-record input a chunk at a time, so memory stays the same however big the file is
+// Records: pulls records one at a time, parse() turns each line into one (lines the same as std::getline)
+//          With --stream a reader thread reads and parses ahead while the solver works on what's been parsed already,
+//          handing over batches of records through a SpscRing. Without it the same chunks are parsed on the solver's thread
+// SpscRing: fixed slots filled in place by one thread and emptied by one other, so batches keep their capacity
+namespace stream
+{
+    // Single producer single consumer, slots are written and read where they are rather than copied in and out
+    // Either side sleeps (std::atomic wait) when there's nothing to do
+    template<typename T, size_t Size>
+    class SpscRing
+    {
+        static_assert((Size & (Size - 1)) == 0, "SpscRing size must be a power of 2");
+
+    public:
+        // Producer: the next slot to fill, waits for the consumer if they're all full
+        T& writeSlot()
+        {
+            const size_t head{ m_head.load(std::memory_order_relaxed) };
+            size_t tail{ m_tail.load(std::memory_order_acquire) };
+            while (head - tail == Size)
+            {
+                m_tail.wait(tail, std::memory_order_acquire);
+                tail = m_tail.load(std::memory_order_acquire);
+            }
+            return m_slots[head & (Size - 1)];
+        }
+
+        // Producer: hands the slot from writeSlot() over
+        void publish()
+        {
+            m_head.fetch_add(1, std::memory_order_release);
+            m_head.notify_one();
+        }
+
+        // Consumer: the oldest published slot, waits for the producer if there isn't one
+        T& readSlot()
+        {
+            const size_t tail{ m_tail.load(std::memory_order_relaxed) };
+            size_t head{ m_head.load(std::memory_order_acquire) };
+            while (head == tail)
+            {
+                m_head.wait(head, std::memory_order_acquire);
+                head = m_head.load(std::memory_order_acquire);
+            }
+            return m_slots[tail & (Size - 1)];
+        }
+
+        // Consumer: done with the slot from readSlot(), the producer can have it back
+        void release()
+        {
+            m_tail.fetch_add(1, std::memory_order_release);
+            m_tail.notify_one();
+        }
+
+    private:
+        std::array<T, Size> m_slots;
+        alignas(64) std::atomic<size_t> m_head{ 0 }; // Published
+        alignas(64) std::atomic<size_t> m_tail{ 0 }; // Released
+    };
+
+    template<typename Record, typename Parse>
+    class Records
+    {
+    public:
+        static constexpr size_t chunkSize{ 1 << 20 }; // Bytes read at a time
+        static constexpr size_t batchSize{ 4096 };    // Records handed over at a time
+        static constexpr size_t batches{ 8 };         // Slots in the ring, so at most this many batches parsed ahead
+
+        // bThreaded: parse on a reader thread, --stream by default
+        Records(const std::string &file, Parse parse, bool bThreaded = flags::isSet(flags::Flag::stream)) :
+            m_file{ file, std::ios::binary },
+            m_parse{ std::move(parse) },
+            m_bThreaded{ bThreaded }
+        {
+            // Here rather than on the reader thread so it throws where it always did
+            if (!m_file)
+            {
+                throw std::runtime_error("could not open " + file);
+            }
+
+            m_chunk.resize(chunkSize);
+            if (m_bThreaded)
+            {
+                m_reader = std::thread{ &Records::read, this };
+            }
+        }
+
+        // Stopping early is fine, the reader's told to stop and anything it's parsed already is thrown away
+        ~Records()
+        {
+            if (m_reader.joinable())
+            {
+                m_bStop.store(true, std::memory_order_relaxed);
+                if (m_bHolding && !m_bEnd)
+                {
+                    m_ring.release();
+                }
+                while (!m_bEnd)
+                {
+                    m_bEnd = m_ring.readSlot().bEnd;
+                    m_ring.release();
+                }
+                m_reader.join();
+            }
+        }
+
+        Records(const Records&) = delete;
+        Records& operator=(const Records&) = delete;
+
+        // False once every line's been read, rethrows anything parse() threw
+        bool next(Record &record)
+        {
+            while (m_index == m_current->records.size())
+            {
+                if (m_bEnd)
+                {
+                    return false;
+                }
+                nextBatch();
+            }
+
+            record = std::move(m_current->records[m_index++]);
+            return true;
+        }
+
+    private:
+        struct Batch
+        {
+            std::vector<Record> records;
+            bool bEnd{ false }; // The last one, nothing more after it
+            std::exception_ptr error;
+        };
+
+        std::ifstream m_file;
+        Parse m_parse;
+        bool m_bThreaded;
+
+        // Reader's
+        std::vector<char> m_chunk;
+        std::string_view m_available; // The part of m_chunk not parsed yet
+        std::string m_partial; // Start of a line the last chunk ended in the middle of
+        bool m_bEof{ false };
+
+        // Solver's
+        Batch m_inline;               // Without a reader thread, the one batch that's refilled each time
+        Batch *m_current{ &m_inline };
+        size_t m_index{ 0 };
+        bool m_bEnd{ false };
+        bool m_bHolding{ false };     // m_current is a ring slot that hasn't been released yet
+
+        SpscRing<Batch, batches> m_ring;
+        std::atomic<bool> m_bStop{ false };
+        std::thread m_reader;
+
+        void nextBatch()
+        {
+            m_index = 0;
+            if (!m_bThreaded)
+            {
+                fill(m_inline);
+                m_bEnd = m_inline.bEnd;
+                return;
+            }
+
+            if (m_bHolding)
+            {
+                m_ring.release();
+            }
+            m_current = &m_ring.readSlot();
+            m_bHolding = true;
+            m_bEnd = m_current->bEnd;
+
+            if (m_current->error)
+            {
+                // The reader stopped at the error, so there's nothing more to wait for
+                m_current->records.clear();
+                std::rethrow_exception(std::exchange(m_current->error, nullptr));
+            }
+        }
+
+        // Reader thread: parse into whichever slot's free until the file runs out or the solver doesn't want any more
+        void read()
+        {
+            bool bEnd{ false };
+            while (!bEnd)
+            {
+                Batch &batch{ m_ring.writeSlot() };
+                try
+                {
+                    fill(batch);
+                }
+                catch (...)
+                {
+                    batch.error = std::current_exception();
+                    batch.bEnd = true;
+                }
+                bEnd = batch.bEnd || m_bStop.load(std::memory_order_relaxed);
+                batch.bEnd = bEnd;
+                m_ring.publish();
+            }
+        }
+
+        // Up to batchSize records, reading more of the file as it's needed
+        void fill(Batch &batch)
+        {
+            batch.records.clear();
+            batch.bEnd = false;
+
+            while (batch.records.size() < batchSize)
+            {
+                if (m_available.empty() && !readChunk())
+                {
+                    batch.bEnd = true;
+                    return;
+                }
+
+                // Whole lines in what's left of the chunk
+                const char *at{ m_available.data() };
+                const char *const end{ at + m_available.size() };
+                while (batch.records.size() < batchSize)
+                {
+                    const char *newline{ scan::find(at, end, '\n') };
+                    if (newline == end)
+                    {
+                        break;
+                    }
+
+                    if (m_partial.empty())
+                    {
+                        batch.records.push_back(m_parse(std::string_view{ at, static_cast<size_t>(newline - at) }));
+                    }
+                    else
+                    {
+                        m_partial.append(at, newline);
+                        batch.records.push_back(m_parse(std::string_view{ m_partial }));
+                        m_partial.clear();
+                    }
+                    at = newline + 1;
+                }
+
+                if (batch.records.size() == batchSize)
+                {
+                    m_available = { at, static_cast<size_t>(end - at) };
+                    return;
+                }
+
+                // No '\n' in the rest, keep it for the next chunk (or it's the last line if there isn't one)
+                m_partial.append(at, end);
+                m_available = {};
+                if (m_bEof && !m_partial.empty())
+                {
+                    batch.records.push_back(m_parse(std::string_view{ m_partial }));
+                    m_partial.clear();
+                }
+            }
+        }
+
+        // False at the end of the file
+        bool readChunk()
+        {
+            if (m_bEof)
+            {
+                return false;
+            }
+
+            m_file.read(m_chunk.data(), static_cast<std::streamsize>(m_chunk.size()));
+            const auto count{ static_cast<size_t>(m_file.gcount()) };
+            m_bEof = count < m_chunk.size();
+            m_available = { m_chunk.data(), count };
+            return count || !m_partial.empty();
+        }
+    };
+
+    template<typename Parse>
+    Records(const std::string&, Parse) -> Records<std::invoke_result_t<Parse&, std::string_view>, Parse>;
+
+    template<typename Parse>
+    Records(const std::string&, Parse, bool) -> Records<std::invoke_result_t<Parse&, std::string_view>, Parse>;
+};
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work stealing pool: each worker has its own queue and takes from the front of it,
+// when that's empty it steals from the back of the others
+// Jobs shouldn't throw (catch inside the job), an escaping exception terminates
+class ThreadPool
+{
+public:
+    using job_t = std::function<void()>;
+
+    explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency())
+    {
+        const size_t count{ threads ? threads : 1 };
+        for (size_t i{ 0 }; i < count; ++i)
+        {
+            m_queues.push_back(std::make_unique<Queue>());
+        }
+        for (size_t i{ 0 }; i < count; ++i)
+        {
+            m_threads.emplace_back(&ThreadPool::work, this, i);
+        }
+    }
+
+    // Finishes everything already pushed first
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard lock{ m_mutex };
+            m_bStopping = true;
+        }
+        m_wake.notify_all();
+
+        for (auto &thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return m_threads.size(); }
+
+    // Jobs are dealt out round robin, so pushing the longest first gets them all started first
+    void push(job_t job)
+    {
+        // Counted before it's in a queue, so a worker that takes it straight away can't take the counts below 0
+        size_t next;
+        {
+            std::lock_guard lock{ m_mutex };
+            next = m_nextQueue++;
+            ++m_queued;
+            ++m_unfinished;
+        }
+
+        Queue &queue{ *m_queues[next % m_queues.size()] };
+        {
+            std::lock_guard lock{ queue.mutex };
+            queue.jobs.push_back(std::move(job));
+        }
+        m_wake.notify_one();
+    }
+
+    // Block until every pushed job has finished
+    void wait()
+    {
+        std::unique_lock lock{ m_mutex };
+        m_finished.wait(lock, [this]() { return m_unfinished == 0; });
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<job_t> jobs;
+    };
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    // Guards the counts below, workers sleep on m_wake while there's nothing queued
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_finished;
+    size_t m_nextQueue{ 0 };
+    size_t m_queued{ 0 };     // Sitting in a queue
+    size_t m_unfinished{ 0 }; // Queued or running
+    bool m_bStopping{ false };
+
+    bool tryPop(size_t self, job_t &job)
+    {
+        for (size_t i{ 0 }; i < m_queues.size(); ++i)
+        {
+            Queue &queue{ *m_queues[(self + i) % m_queues.size()] };
+            std::lock_guard lock{ queue.mutex };
+            if (queue.jobs.empty())
+                continue;
+
+            // Own queue from the front, stealing from the back
+            if (i == 0)
+            {
+                job = std::move(queue.jobs.front());
+                queue.jobs.pop_front();
+            }
+            else
+            {
+                job = std::move(queue.jobs.back());
+                queue.jobs.pop_back();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void work(size_t self)
+    {
+        while (true)
+        {
+            job_t job;
+            if (tryPop(self, job))
+            {
+                {
+                    std::lock_guard lock{ m_mutex };
+                    --m_queued;
+                }
+
+                job();
+
+                std::lock_guard lock{ m_mutex };
+                if (--m_unfinished == 0)
+                {
+                    m_finished.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock lock{ m_mutex };
+            m_wake.wait(lock, [this]() { return m_bStopping || m_queued > 0; });
+            if (m_bStopping && m_queued == 0)
+                return;
+        }
+    }
+};
@@ -3,6 +3,7 @@
 // This is chunky enough to split into (probably multiple) header & source files
 
 #include <algorithm>
+#include <cstdlib>
 #include <exception>
 #include <filesystem>
 #include <fstream>
@@ -11,10 +12,15 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <span>
 #include <sstream>
 #include <string_view>
 #include <vector>
 
+#include "inputview.h"
+#include "options.h"
+#include "scan.h"
+
 #define RELPATH(x) utils::getFilePath(__FILE__, x)
 #define FOR(n) for (int i{ 0 }; i < n; ++i)
 #define ST(i) static_cast<size_t>(i) // Speeding up these common casts
@@ -50,126 +56,83 @@ namespace style
     inline const char* unInvert    { "\033[27m" };
 };
 
-namespace flags
+namespace utils
 {
-    enum class Flag : std::uint8_t
-    {
-        none             = 0,     
-        p1               = 1 << 0,  // run puzzle1
-        p2               = 1 << 1,  // run puzzle2
-        test             = 1 << 2,  // use test input
-        debug            = 1 << 3,  // enable debug macros
-        log              = 1 << 4,  // enable logging
-        save_answer      = 1 << 5,  // write puzzle answers to files
-        overwrite_answer = 1 << 6,  // overwrite puzzle answer files
-        custom_input     = 1 << 7,  // follow with input file name
-                     //  = 1 << 7   // room for 1 more in 8 bit flag
-    };
-
+    class DayInfo;
+}
 
-    using flag_t = std::underlying_type_t<Flag>;
+// Everything a single day's run used to keep in globals
+// One of these is active per thread so the runner can solve several days at once without them overwriting each other
+namespace run
+{
+    struct Context
+    {
+        flags::Flag flags{ flags::Flag::none };
+        options::Values options;
+        bool bPuzzle2{ false }; // printAnswer checks this
+        std::unique_ptr<utils::DayInfo> dayInfo;
+        std::ostream* out{ &std::cout }; // Where answers are printed
 
-    inline flag_t fcast(Flag f) { return static_cast<flag_t>(f); }
-    inline Flag fcast(flag_t ft) { return static_cast<Flag>(ft); }
+        Context() = default;
+        Context(flags::Flag f, const options::Values &o) : flags{ f }, options{ o } {}
+        ~Context();
+    };
 
-    Flag operator|(Flag lhs, Flag rhs) { return fcast(fcast(lhs) | fcast(rhs)); }
-    Flag operator&(Flag lhs, Flag rhs) { return fcast(fcast(lhs) & fcast(rhs)); }
-    Flag operator^(Flag lhs, Flag rhs) { return fcast(fcast(lhs) ^ fcast(rhs)); }
-    Flag operator~(Flag f) { return fcast(~fcast(f)); }
+    // The thread's active context (the default one unless a Scope says otherwise)
+    Context& current();
 
-    Flag& operator|=(Flag& lhs, Flag rhs) { lhs = lhs | rhs; return lhs; }
-    Flag& operator&=(Flag& lhs, Flag rhs) { lhs = lhs & rhs; return lhs; }
-    Flag& operator^=(Flag& lhs, Flag rhs) { lhs = lhs ^ rhs; return lhs; }
+    inline std::ostream& out() { return *current().out; }
+}
 
-    Flag flags{ Flag::none };
+namespace flags
+{
+    // The active run's flags
+    inline Flag& flags() { return run::current().flags; }
 
-    // Flags are only single characters for now
-    Flag flagFromChar(char f)
+    inline Flag flagFromChar(char f)
     {
-        switch (f)
-        {
-        case '1' : return Flag::p1;
-        case '2' : return Flag::p2;
-        case 't' : return Flag::test;
-        case 'd' : return Flag::debug;
-        case 'l' : return Flag::log;
-        case 's' : return Flag::save_answer;
-        case 'o' : return Flag::overwrite_answer;
-        case 'i' : return Flag::custom_input;
-        default  : return Flag::none;
-        }
+        const auto* option{ options::find(f) };
+        return option ? option->flag : Flag::none;
     }
 
-    std::map<Flag, std::string> args;
-
-    void set(Flag f) { flags |= f; }
-    void set(char c) { flags |= flagFromChar(c); }
+    inline void set(Flag f) { flags() |= f; }
+    inline void set(char c) { flags() |= flagFromChar(c); }
 
-    void reset(Flag f) { flags &= ~f; }
-    void reset(char c) { flags &= ~flagFromChar(c); }
+    inline void reset(Flag f) { flags() &= ~f; }
+    inline void reset(char c) { flags() &= ~flagFromChar(c); }
 
-    bool isSet(Flag f) { return fcast(flags & f); }
-    bool isSet(char c) { return isSet(flagFromChar(c)); }
+    inline bool isSet(Flag f) { return fcast(flags() & f); }
+    inline bool isSet(char c) { return isSet(flagFromChar(c)); }
 
-    void setFlagArgs(Flag f, int argInd, int argc, char* argv[])
+    // Replaces the active run's flags and option values, returns the arguments that weren't options
+    inline std::vector<std::string> set(int argc, char* argv[])
     {
-        if (f == Flag::custom_input)
-        {
-            if (argInd >= argc)
-            {
-                std::cerr << "custom input flag (i) is set but no filename given\n";
-                reset(f);
-            }
-            else if (argv[argInd][0] == '-')
-            {
-                std::cerr << "custom input flag (i) is set but followed by a flag (hyphen -prefix)\n";
-                reset(f);
-            }
-            else
-            {
-                args[f] = argv[argInd];
-            }   
-        }
+        auto parsed{ options::parse(argc, argv) };
+        flags() = parsed.flags;
+        run::current().options = std::move(parsed.values);
+        return std::move(parsed.positional);
     }
 
-    void set(int argc, char* argv[])
-    {
-        for (int i{ 1 }; i < argc; ++i)
-        {
-            if (argv[i][0] == '-')
-            {
-                int j{ 0 };
-                while (argv[i][++j] != '\0')
-                {
-                    flags |= flagFromChar(argv[i][j]);
-                    setFlagArgs(flagFromChar(argv[i][j]), i + 1, argc, argv);
-                }
-            }
-        }
-    }
-
-
-
-    bool d() { return fcast(flags & Flag::debug); } // Quick debug flag check with if(flags::d())
-    bool t() { return fcast(flags & Flag::test); } // Quick debug flag check with if(flags::t())
+    inline bool d() { return fcast(flags() & Flag::debug); } // Quick debug flag check with if(flags::d())
+    inline bool t() { return fcast(flags() & Flag::test); } // Quick debug flag check with if(flags::t())
 }
 // We have file helpers
 // We also have some methods for common string & input file uses - could make two headers
 namespace utils
 {
     // By default (neither p1 or p2 flags set) we run both: if one is set, check if the other is to decide if that runs
-    bool doP1() { return flags::isSet(flags::Flag::p1) || !flags::isSet(flags::Flag::p2); }
+    inline bool doP1() { return flags::isSet(flags::Flag::p1) || !flags::isSet(flags::Flag::p2); }
     
-    // Use this var to automatically have printAnswer use puzzle2
-    bool bPuzzle2{ false };
+    // Set this to automatically have printAnswer use puzzle2
+    inline bool& bPuzzle2() { return run::current().bPuzzle2; }
     // Call doP2 before running the puzzle to have bPuzzle2 set
-    bool doP2() { bPuzzle2 = true; return flags::isSet(flags::Flag::p2) || !flags::isSet(flags::Flag::p1); }
+    inline bool doP2() { bPuzzle2() = true; return flags::isSet(flags::Flag::p2) || !flags::isSet(flags::Flag::p1); }
 
-    std::string defaultInputFile()
+    inline std::string defaultInputFile()
     {
         if (flags::isSet(flags::Flag::custom_input))
         {
-            return flags::args[flags::Flag::custom_input];
+            return run::current().options.input;
         }
         if (flags::isSet(flags::Flag::test))
         {
@@ -185,7 +148,13 @@ namespace utils
 
         static bool initialised()
         {
-            return m_singletonInstance.get(); // False while nullptr
+            return instance().get(); // False while nullptr
+        }
+
+        // Forget the current day so init() can be called again for another one (the runner does this between days)
+        static void reset()
+        {
+            instance().reset();
         }
 
         template <typename T>
@@ -193,14 +162,19 @@ namespace utils
 
         template <typename T>
         static void tryAnswer2(T answer, const std::string &flavourStart = "", const std::string &flavourEnd = "");
+
+        // Like tryAnswer for benchmark timings: false if seconds is too far over the stored baseline
+        static bool tryBaseline(double seconds, bool bPart2);
         
-        // Getters from m_singletonInstance (no checks for null here just remember to use init() first)
-        static const std::string &day() { return m_singletonInstance->m_day; } 
-        static const std::string &inputFilePath() { return m_singletonInstance->m_inputFilePath; } 
-        static const std::string &inputFileName() { return m_singletonInstance->m_inputFileName; } 
-        static const std::string &puzzleSolutionsDir() { return m_singletonInstance->m_puzzleSolutionsDir; } 
-        static const std::string &pt1SolutionFile() { return m_singletonInstance->m_pt1SolutionFile; } 
-        static const std::string &pt2SolutionFile() { return m_singletonInstance->m_pt2SolutionFile; } 
+        // Getters from the active run's instance (no checks for null here just remember to use init() first)
+        static const std::string &day() { return instance()->m_day; } 
+        static const std::string &inputFilePath() { return instance()->m_inputFilePath; } 
+        static const std::string &inputFileName() { return instance()->m_inputFileName; } 
+        static const std::string &puzzleSolutionsDir() { return instance()->m_puzzleSolutionsDir; } 
+        static const std::string &pt1SolutionFile() { return instance()->m_pt1SolutionFile; } 
+        static const std::string &pt2SolutionFile() { return instance()->m_pt2SolutionFile; } 
+        static const std::string &pt1BaselineFile() { return instance()->m_pt1BaselineFile; } 
+        static const std::string &pt2BaselineFile() { return instance()->m_pt2BaselineFile; } 
 
     private:
         const std::string m_day;
@@ -209,27 +183,30 @@ namespace utils
         const std::string m_puzzleSolutionsDir;
         const std::string m_pt1SolutionFile;
         const std::string m_pt2SolutionFile;
+        const std::string m_pt1BaselineFile;
+        const std::string m_pt2BaselineFile;
 
         DayInfo(std::filesystem::path cppFile, const std::string& input);
 
-        static std::unique_ptr<DayInfo> m_singletonInstance;
+        // One per run::Context rather than a true singleton
+        static std::unique_ptr<DayInfo>& instance();
 
         template<typename T>
         static void tryAnswer(T answer, bool bPart2 = false, const std::string &flavourStart = "", const std::string &flavourEnd = "");
         
         static void saveAnswer(const std::string &answer, bool bPart2 = false);
-    };
 
-    std::unique_ptr<DayInfo> DayInfo::m_singletonInstance = nullptr;
+        static void saveToSolutionsDir(const std::string &text, const std::string &outFilePath);
+    };
 
     // Initialise with __FILE__ macro and optional input file name
-    void init(std::filesystem::path cppFile, const std::string& input = defaultInputFile())
+    inline void init(std::filesystem::path cppFile, const std::string& input = defaultInputFile())
     {
         DayInfo::init(cppFile, input);
     }
 
     // We usually (always?) want to get the input file after init, so we can call init through this method and return input
-    const std::string& inputFile(std::filesystem::path cppFile, const std::string& input = defaultInputFile())
+    inline const std::string& inputFile(std::filesystem::path cppFile, const std::string& input = defaultInputFile())
     {
         if (!DayInfo::initialised())
             DayInfo::init(cppFile, input);
@@ -237,37 +214,57 @@ namespace utils
         return DayInfo::inputFilePath();
     }
 
-    const std::string& inputFile()
+    inline const std::string& inputFile()
     {
         return DayInfo::inputFilePath();
     }
 
-    const std::string& inputFileName()
+    inline const std::string& inputFileName()
     {
         return DayInfo::inputFileName();
     }
 
 
-    std::filesystem::path projectPath()
+    inline std::filesystem::path projectPath()
     {
         return std::filesystem::path{ __FILE__ }.parent_path().parent_path().string();
     }
 
-    std::filesystem::path allSolutionsDir()
+    inline std::filesystem::path allSolutionsDir()
     {
         return projectPath().append("solutions");
     }
 
-    std::filesystem::path allLogsDir()
+    inline std::filesystem::path allLogsDir()
     {
         return projectPath().append("logs");
     }
 
+    // Recorded frames, see frames.h
+    inline std::filesystem::path allImagesDir()
+    {
+        return projectPath().append("images");
+    }
+
+    // images/dayxx/name_pt1 or name_test_pt1 etc without an extension, making the directory if it's not there
+    inline std::filesystem::path imagePath(const std::string &name)
+    {
+        const auto dir{ allImagesDir().append(DayInfo::day()) };
+        std::filesystem::create_directories(dir);
+        return std::filesystem::path{ dir }.append(name + (flags::t() ? "_test_" : "_") + (bPuzzle2() ? "pt2" : "pt1"));
+    }
+
+    // Timings from the last runner run, used to start the slowest days first
+    inline std::filesystem::path allTimingsDir()
+    {
+        return projectPath().append("timings");
+    }
+
     // If answer is a string, it will be used for flavourStart - coerce the correct params by adding an empty flavourEnd arg ""
     template<typename T>
     void printAnswer(const std::string &flavourStart, const T answer, const std::string &flavourEnd = "")
     {
-        if (bPuzzle2)
+        if (bPuzzle2())
             DayInfo::tryAnswer2(answer, flavourStart, flavourEnd);
         else
             DayInfo::tryAnswer1(answer, flavourStart, flavourEnd);
@@ -280,129 +277,136 @@ namespace utils
     }
 
     // Blank version for dayTemplate
-    void printAnswer()
+    inline void printAnswer()
     {
     }
 
     // Gets fileDir/input by default or fileDir/test with -t cmd arg
-    const std::string getFilePath(const std::string &srcFilePath, const std::string &fileName = defaultInputFile())
+    inline const std::string getFilePath(const std::string &srcFilePath, const std::string &fileName = defaultInputFile())
     {
         return std::filesystem::path{ srcFilePath }.parent_path().append(fileName).string();
     }
 
-    void forEachLine(const std::string &file, std::function<void(std::string_view)> fnc)
+    // Lines are views into the mapped file, only valid during the call
+    inline void forEachLine(const InputView &input, std::function<void(std::string_view)> fnc)
     {
-        std::ifstream inf{ file }; 
-        if (!inf.good())
-        {
-            throw std::runtime_error{ "Could not open file: " + file };
-        }
-        while (inf)
+        for (size_t i{ 0 }; i < input.lineCount(); ++i)
         {
-            std::string line;
-            std::getline(inf, line);
-            if(!inf) break; // Was getting the last empty line without this
-            fnc(line);
+            fnc(input.line(i));
         }
     }
 
-    std::string bufferInput(const std::string &file)
+    inline void forEachLine(const std::string &file, std::function<void(std::string_view)> fnc)
+    {
+        const InputView input{ file };
+        forEachLine(input, fnc);
+    }
+
+    // One read straight into a buffer of the right size (InputView would index lines we don't need here)
+    inline std::string bufferInput(const std::string &file)
     {
-        std::ifstream inf{ file }; 
+        std::ifstream inf{ file, std::ios::binary }; 
         if (!inf.good())
         {
             throw std::runtime_error{ "Could not open file: " + file };
         }
-        
-        std::string buffer;
-        // std::stringstream ss;
 
         inf.seekg(0, std::ios::end);
-        // auto end{ inf.tellg() };
-        buffer.reserve(static_cast<unsigned int>(inf.tellg()));
+        std::string buffer(static_cast<size_t>(inf.tellg()), '\0');
         inf.seekg(0, std::ios::beg);
+        inf.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
 
-        for (char ch{ static_cast<char>(inf.get()) }; !inf.eof(); ch = static_cast<char>(inf.get()))
-        {
-            buffer.push_back(ch);
-        }
-
-        buffer.shrink_to_fit();
         return buffer;
-
     }
-    
-    std::vector<std::string> bufferLines(const std::string &file)
+
+    // A file's lines as views into it, it keeps the mapping open so they're valid for as long as it's around
+    // Anything pushed has to outlive it too (string literals, other lines)
+    class Lines
     {
-        std::ifstream inf{ file }; 
-        if (!inf.good())
+    public:
+        explicit Lines(const std::string &file) :
+            m_input{ std::make_unique<InputView>(file) }
         {
-            throw std::runtime_error{ "Could not open file: " + file };
         }
-        std::vector<std::string> buffer;
 
-        while(inf)
+        size_t size() const { return m_lines.size(); }
+        bool empty() const { return m_lines.empty(); }
+
+        std::string_view operator[](size_t i) const { return m_lines[i]; }
+
+        auto begin() { return m_lines.begin(); }
+        auto end() { return m_lines.end(); }
+        auto begin() const { return m_lines.begin(); }
+        auto end() const { return m_lines.end(); }
+
+        void reserve(size_t count) { m_lines.reserve(count); }
+        void push_back(std::string_view line) { m_lines.push_back(line); }
+
+        const InputView& input() const { return *m_input; }
+
+        operator std::span<const std::string_view>() const { return m_lines; }
+
+    private:
+        // On the heap so moving Lines doesn't move what the views point into (the buffer where there's no mmap)
+        std::unique_ptr<InputView> m_input;
+        std::vector<std::string_view> m_lines;
+    };
+
+    // Skips empty lines
+    inline Lines bufferLines(const std::string &file)
+    {
+        Lines lines{ file };
+        const InputView &input{ lines.input() };
+        lines.reserve(input.lineCount());
+
+        for (size_t i{ 0 }; i < input.lineCount(); ++i)
         {
-            std::string line;
-            std::getline(inf, line);
+            const auto line{ input.line(i) };
             if (line.length())
             {
-                buffer.push_back(line);
+                lines.push_back(line);
             }
         }
 
-        return buffer;
+        return lines;
     }
 
-    std::vector<std::string> bufferLinesIf(const std::string &file, bool (*condition)(const std::string&))
+    inline Lines bufferLinesIf(const std::string &file, bool (*condition)(std::string_view))
     {
-        std::ifstream inf{ file }; 
-        if (!inf.good())
-        {
-            throw std::runtime_error{ "Could not open file: " + file };
-        }
-        std::vector<std::string> buffer;
+        Lines lines{ file };
+        const InputView &input{ lines.input() };
 
-        while(inf)
+        for (size_t i{ 0 }; i < input.lineCount(); ++i)
         {
-            std::string line;
-            std::getline(inf, line);
+            const auto line{ input.line(i) };
             if (condition(line))
             {
-                buffer.push_back(line);
+                lines.push_back(line);
             }
         }
 
-        return buffer;
+        return lines;
     }
 
-    std::vector<std::string> bufferLinesWhile(const std::string &file, bool (*condition)(const std::string&))
+    inline Lines bufferLinesWhile(const std::string &file, bool (*condition)(std::string_view))
     {
-        std::ifstream inf{ file }; 
-        if (!inf.good())
-        {
-            throw std::runtime_error{ "Could not open file: " + file };
-        }
-        std::vector<std::string> buffer;
+        Lines lines{ file };
+        const InputView &input{ lines.input() };
 
-        while(inf)
+        for (size_t i{ 0 }; i < input.lineCount(); ++i)
         {
-            std::string line;
-            std::getline(inf, line);
-            if (condition(line))
-            {
-                buffer.push_back(line);
-            }
-            else
+            const auto line{ input.line(i) };
+            if (!condition(line))
             {
                 break;
             }
+            lines.push_back(line);
         }
 
-        return buffer;
+        return lines;
     }
 
-    std::vector<std::string> bufferLinesWhile(std::ifstream &inf, bool (*condition)(const std::string&))
+    inline std::vector<std::string> bufferLinesWhile(std::ifstream &inf, bool (*condition)(const std::string&))
     {
         if (!inf.good())
         {
@@ -428,7 +432,7 @@ namespace utils
     }
 
     // Uses an out parameter to behave like std::getline. Discards lines until a condition is met
-    void skipLinesUntil(std::ifstream &inf, std::string &line, bool (*condition) (const std::string&))
+    inline void skipLinesUntil(std::ifstream &inf, std::string &line, bool (*condition) (const std::string&))
     {
         do
         {
@@ -436,7 +440,7 @@ namespace utils
         } while (!condition(line));
     }
 
-    std::vector<std::string> getLinesUntil(std::ifstream &inf, bool (*condition) (const std::string&))
+    inline std::vector<std::string> getLinesUntil(std::ifstream &inf, bool (*condition) (const std::string&))
     {
         std::vector<std::string> block;
         do
@@ -447,7 +451,7 @@ namespace utils
         return block;
     }
 
-    std::vector<std::string> split(const std::string &str, const std::string &splitOn)
+    inline std::vector<std::string> split(std::string_view str, const std::string &splitOn)
     {
         std::vector<std::string> list;
 
@@ -457,41 +461,17 @@ namespace utils
             return list;
         }
 
-        auto begin{ str.begin() };
-        while (begin < str.end())
-        {
-            auto match{ std::search(begin, str.end(), splitOn.begin(), splitOn.end()) };
-
-            list.push_back( std::string{ begin, match } );
-            begin = match + static_cast<int>(splitOn.length());
-
-        }
+        scan::forEachSplit(str, splitOn, [&list](std::string_view token) { list.emplace_back(token); });
         return list;
     }
 
-    std::vector<std::string> split(std::string_view str, const std::string &splitOn)
+    inline std::vector<std::string> split(const std::string &str, const std::string &splitOn)
     {
-        std::vector<std::string> list;
-
-        if (splitOn.length() == 0)
-        {
-            std::cerr << ("utils::split called with empty split string\n");
-            return list;
-        }
-
-        auto begin{ str.begin() };
-        while (begin < str.end())
-        {
-            auto match{ std::search(begin, str.end(), splitOn.begin(), splitOn.end()) };
-
-            list.push_back( std::string{ begin, match } );
-            begin = match + static_cast<int>(splitOn.length());
-
-        }
-        return list;
+        return split(std::string_view{ str }, splitOn);
     }
 
-    std::vector<int> splitInts(std::string_view str, const std::string &splitOn)
+    // scan::Ints::split is the allocation free version of this
+    inline std::vector<int> splitInts(std::string_view str, const std::string &splitOn)
     {
         std::vector<int> list;
 
@@ -501,19 +481,11 @@ namespace utils
             return list;
         }
 
-        auto begin{ str.begin() };
-        while (begin < str.end())
-        {
-            auto match{ std::search(begin, str.end(), splitOn.begin(), splitOn.end()) };
-
-            list.push_back( std::stoi(std::string{ begin, match }) );
-            begin = match + static_cast<int>(splitOn.length());
-
-        }
+        scan::forEachSplit(str, splitOn, [&list](std::string_view token) { list.push_back(scan::toInt(token)); });
         return list;
     }
 
-    void doOnSplit(const std::string &str, const std::string &splitOn, std::function<void(const std::string&)>fnc)
+    inline void doOnSplit(const std::string &str, const std::string &splitOn, std::function<void(const std::string&)>fnc)
     {
         if (splitOn.length() == 0)
         {
@@ -521,20 +493,11 @@ namespace utils
             return;
         }
 
-        auto begin{ str.begin() };
-        while (begin < str.end())
-        {
-            auto match{ std::search(begin, str.end(), splitOn.begin(), splitOn.end()) };
-
-            fnc(std::string{ begin, match });
-
-            begin = match + static_cast<int>(splitOn.length());
-
-        }
+        scan::forEachSplit(str, splitOn, [&fnc](std::string_view token) { fnc(std::string{ token }); });
     }
 
     // I think string_view makes more sense
-    void doOnSplit(std::string_view str, std::string_view splitOn, std::function<void(std::string_view)>fnc)
+    inline void doOnSplit(std::string_view str, std::string_view splitOn, std::function<void(std::string_view)>fnc)
     {
         if (splitOn.length() == 0)
         {
@@ -542,26 +505,7 @@ namespace utils
             return;
         }
 
-        // auto begin{ str.begin() };
-        // while (begin < str.end())
-        // {
-        //     auto match{ std::search(begin, str.end(), splitOn.begin(), splitOn.end()) };
-
-        //     fnc(std::string_view{ begin, match });
-
-        //     std::string_view{ begin,  };
-        //     begin = match + static_cast<int>(splitOn.length());
-
-        // }
-        
-        size_t start{ 0 };
-        while (start < str.length())
-        {
-            auto match{ std::min(str.find(splitOn, start), str.length()) };
-            fnc(std::string_view{ str.data() + start, match - start });
-            start = match + splitOn.length();
-        }
-
+        scan::forEachSplit(str, splitOn, fnc);
     }
 };
 
@@ -588,10 +532,10 @@ void utils::DayInfo::tryAnswer(T answer, bool bPart2, const std::string &flavour
             }
             else if (flags::isSet(flags::Flag::save_answer))
             {
-                std::cout << "save flag set but file exists, use -o flag to overwrite " << ( bPart2 ? pt2SolutionFile() : pt1SolutionFile() ) << '\n';
+                run::out() << "save flag set but file exists, use -o flag to overwrite " << ( bPart2 ? pt2SolutionFile() : pt1SolutionFile() ) << '\n';
             }
 
-            std::cout << "\033[31m" << answer << "\033[0m" << " is incorrect.\nThe correct answer is: " << correctStr << '\n';
+            run::out() << "\033[31m" << answer << "\033[0m" << " is incorrect.\nThe correct answer is: " << correctStr << '\n';
             return;
         }
     }
@@ -600,7 +544,7 @@ void utils::DayInfo::tryAnswer(T answer, bool bPart2, const std::string &flavour
         saveAnswer(answerStr, bPart2);
     }
 
-    std::cout << flavourStart << style::green << style::bold << answerStr << style::reset << flavourEnd << '\n';
+    run::out() << flavourStart << style::green << style::bold << answerStr << style::reset << flavourEnd << '\n';
 }
 
 template <typename T>
@@ -615,24 +559,30 @@ void utils::DayInfo::tryAnswer2(T answer, const std::string &flavourStart, const
     tryAnswer(answer, true, flavourStart, flavourEnd);
 }
 
-void utils::DayInfo::saveAnswer(const std::string &answer, bool bPart2)
+inline void utils::DayInfo::saveAnswer(const std::string &answer, bool bPart2)
+{
+    saveToSolutionsDir(answer, bPart2 ? pt2SolutionFile() : pt1SolutionFile());
+}
+
+inline void utils::DayInfo::saveToSolutionsDir(const std::string &text, const std::string &outFilePath)
 {
     if (!std::filesystem::exists(utils::allSolutionsDir()))
     {
-        std::cout << "creating dir: " << utils::allSolutionsDir() << '\n';
+        run::out() << "creating dir: " << utils::allSolutionsDir() << '\n';
         std::filesystem::create_directory(utils::allSolutionsDir());
     }
-    if (!std::filesystem::exists(puzzleSolutionsDir()))
+    // Generated inputs' answers go in a folder under the day's, like the inputs do
+    const auto outDir{ std::filesystem::path{ outFilePath }.parent_path() };
+    if (!std::filesystem::exists(outDir))
     {
-        std::cout << "creating dir: " << puzzleSolutionsDir() << '\n';
-        std::filesystem::create_directory(puzzleSolutionsDir());
+        run::out() << "creating dir: " << outDir.string() << '\n';
+        std::filesystem::create_directories(outDir);
     }
 
-    auto outFilePath{ bPart2 ? pt2SolutionFile() : pt1SolutionFile() };
     if (!flags::isSet(flags::Flag::overwrite_answer) && std::filesystem::exists(outFilePath))
     {
         std::cerr << style::yellow << "overwrite disabled, not writing answer to " << style::reset << outFilePath << '\n';
-        std::cout << "use " << style::bold << style::magenta << "-o " << style::reset << "flag to save and overwrite\n";
+        run::out() << "use " << style::bold << style::magenta << "-o " << style::reset << "flag to save and overwrite\n";
         return;
     }
 
@@ -643,25 +593,107 @@ void utils::DayInfo::saveAnswer(const std::string &answer, bool bPart2)
     }
     else
     {
-        std::cout << "writing " << answer << "\nto " << outFilePath << '\n';
-        of << answer;
+        run::out() << "writing " << text << "\nto " << outFilePath << '\n';
+        of << text;
+    }
+}
+
+// Baselines are benchmark medians in seconds, saved next to the answers with -s / -o
+// Slower than the baseline by more than the -r percentage (default 25) fails
+inline bool utils::DayInfo::tryBaseline(double seconds, bool bPart2)
+{
+    // Below this a difference is just noise, some parts only take microseconds
+    constexpr double minimumSlowdown{ 0.0001 };
+
+    std::stringstream ss;
+    ss << seconds;
+    const std::string secondsStr{ ss.str() };
+    const std::string &baselineFile{ bPart2 ? pt2BaselineFile() : pt1BaselineFile() };
+
+    std::ifstream inf{ baselineFile };
+    double baseline{ 0.0 };
+    if (!(inf >> baseline))
+    {
+        if (flags::isSet(flags::Flag::save_answer | flags::Flag::overwrite_answer))
+        {
+            saveToSolutionsDir(secondsStr, baselineFile);
+        }
+        else
+        {
+            run::out() << "no baseline for pt" << (bPart2 ? 2 : 1) << ", use " << style::bold << style::magenta << "-s " << style::reset << "to save one\n";
+        }
+        return true;
+    }
+    inf.close();
+
+    const double threshold{ run::current().options.regression };
+    const double percent{ (seconds / baseline - 1.0) * 100.0 };
+    const bool bRegressed{ percent > threshold && seconds - baseline > minimumSlowdown };
+
+    run::out() << (bRegressed ? style::red : style::green) << "pt" << (bPart2 ? 2 : 1) << ' ' << (percent >= 0.0 ? "+" : "") << percent << "% against baseline " << baseline << 's' << style::reset;
+    if (bRegressed)
+    {
+        run::out() << ", over the " << threshold << "% threshold";
+    }
+    run::out() << '\n';
+
+    // -o re-baselines, regressions included
+    if (flags::isSet(flags::Flag::overwrite_answer))
+    {
+        saveToSolutionsDir(secondsStr, baselineFile);
+        return true;
+    }
+    return !bRegressed;
+}
+
+inline void utils::DayInfo::init(std::filesystem::path cppFile, const std::string& input)
+{
+    if (!instance())
+    {
+        instance() = std::unique_ptr<DayInfo>{ new DayInfo{ cppFile, input } };
     }
 }
 
-void utils::DayInfo::init(std::filesystem::path cppFile, const std::string& input)
+inline std::unique_ptr<utils::DayInfo>& utils::DayInfo::instance()
 {
-    if (!m_singletonInstance)
+    return run::current().dayInfo;
+}
+
+namespace run
+{
+    inline Context::~Context() = default;
+
+    // Used by the standalone days and the runner's main thread
+    inline Context defaultContext;
+    inline thread_local Context* active{ &defaultContext };
+
+    inline Context& current()
     {
-        m_singletonInstance = std::unique_ptr<DayInfo>{ new DayInfo{ cppFile, input } };
+        return *active;
     }
+
+    // Makes a context active on this thread until the scope ends
+    class Scope
+    {
+        Context* m_previous;
+
+    public:
+        Scope(Context &context) : m_previous{ active } { active = &context; }
+        ~Scope() { active = m_previous; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
 }
 
-utils::DayInfo::DayInfo(std::filesystem::path cppFile, const std::string& input) :
+inline utils::DayInfo::DayInfo(std::filesystem::path cppFile, const std::string& input) :
     m_day{ cppFile.filename().replace_extension("").string() },
     m_inputFileName{ input },
     m_inputFilePath{ utils::getFilePath(cppFile, input) },
     m_puzzleSolutionsDir{ utils::allSolutionsDir().append(m_day).string() },
     m_pt1SolutionFile{ utils::allSolutionsDir().append(m_day).append(input + "_solution_pt1") },
-    m_pt2SolutionFile{ utils::allSolutionsDir().append(m_day).append(input + "_solution_pt2") }
+    m_pt2SolutionFile{ utils::allSolutionsDir().append(m_day).append(input + "_solution_pt2") },
+    m_pt1BaselineFile{ utils::allSolutionsDir().append(m_day).append(input + "_baseline_pt1") },
+    m_pt2BaselineFile{ utils::allSolutionsDir().append(m_day).append(input + "_baseline_pt2") }
 {
 }
@@ -1,163 +1,236 @@
 #pragma once
 
-#include <cmath>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <span>
+#include <utility>
+#include <vector>
 
-struct Vector2d
+namespace vec
 {
-    Vector2d(int xy = 0) : x{ xy }, y{ xy } {}
-    Vector2d(int _x, int _y) : x{ _x }, y{ _y } {}
+    // std::abs isn't constexpr until C++23
+    template<typename T>
+    constexpr T abs(T t) { return t < 0 ? -t : t; }
 
-    int x;
-    int y;
+    // -1, 0 or 1
+    template<typename T>
+    constexpr T sign(T t) { return static_cast<T>((t > 0) - (t < 0)); }
 
-    Vector2d rotateClockwise()
+    // Spreads a packed key's bits about so neighbouring coords don't land in neighbouring buckets
+    constexpr size_t mix(std::uint64_t key)
+    {
+        key ^= key >> 31;
+        key *= 0x7FB5'D329'728E'A185ull;
+        key ^= key >> 27;
+        key *= 0x81DA'DEF4'BC2D'D44Dull;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
+};
+
+template <typename T>
+struct Vec2dT
+{
+    constexpr Vec2dT(T xy = 0) : x{ xy }, y{ xy } {}
+    constexpr Vec2dT(T _x, T _y) : x{ _x }, y{ _y } {}
+
+    T x;
+    T y;
+
+    constexpr Vec2dT rotateClockwise() const
     {
         return { y, -x };
     }
 
-    Vector2d rotateAntiClockwise()
+    constexpr Vec2dT rotateAntiClockwise() const
     {
         return { -y, x };
     }
 
-    int static manhatDist(const Vector2d &lhs, const Vector2d &rhs)
+    static constexpr T manhatDist(const Vec2dT &lhs, const Vec2dT &rhs)
+    {
+        return vec::abs(lhs.x - rhs.x) + vec::abs(lhs.y - rhs.y);
+    }
+
+    constexpr Vec2dT abs() const
+    {
+        return { vec::abs(x), vec::abs(y) };
+    }
+
+    // Each of x and y down to -1, 0 or 1, so zero stays zero
+    constexpr Vec2dT sign() const
     {
-        return std::abs(lhs.x - rhs.x) + std::abs(lhs.y - rhs.y);
+        return { vec::sign(x), vec::sign(y) };
     }
 
-    friend Vector2d operator+(const Vector2d &lhs, const Vector2d &rhs)
+    friend constexpr Vec2dT operator+(const Vec2dT &lhs, const Vec2dT &rhs)
     {
         return {lhs.x + rhs.x, lhs.y + rhs.y };
     }
 
-    friend Vector2d operator-(const Vector2d &lhs, const Vector2d &rhs)
+    friend constexpr Vec2dT operator-(const Vec2dT &lhs, const Vec2dT &rhs)
     {
         return {lhs.x - rhs.x, lhs.y - rhs.y };
     }
 
-    Vector2d operator*(int s)
+    constexpr Vec2dT operator*(T s) const
     {
         return { x * s, y * s };
     }
 
-    Vector2d operator/(int s)
+    constexpr Vec2dT operator/(T s) const
     {
         return { x / s, y / s };
     }
 
-    int operator[](int i)
+    constexpr T operator[](int i) const
     {
         return i == 0 ? x : y;
     }
 
-    Vector2d& operator+=(const Vector2d &rhs)
+    constexpr T& operator[](int i)
+    {
+        return i == 0 ? x : y;
+    }
+
+    constexpr Vec2dT& operator+=(const Vec2dT &rhs)
     {
         x += rhs.x;
         y += rhs.y;
         return *this;
     }
 
-    Vector2d& operator-=(const Vector2d &rhs)
+    constexpr Vec2dT& operator-=(const Vec2dT &rhs)
     {
         x -= rhs.x;
         y -= rhs.y;
         return *this;
     }
 
-    friend bool operator==(const Vector2d &lhs,const Vector2d& rhs)
+    friend constexpr bool operator==(const Vec2dT &lhs,const Vec2dT& rhs)
     {
         return lhs.x == rhs.x && lhs.y == rhs.y;
     }
 
-    friend bool operator!=(const Vector2d &lhs,const Vector2d& rhs)
+    friend constexpr bool operator!=(const Vec2dT &lhs,const Vec2dT& rhs)
     {
         return !(lhs == rhs);
     }
 
-    friend std::ostream &operator<<(std::ostream &os, const Vector2d& vec)
+    // x then y, for std::set and std::map
+    friend constexpr bool operator<(const Vec2dT &lhs,const Vec2dT& rhs)
     {
-        return os << "{ " << vec.x << ", " << vec.y << " }";
+        return lhs.x < rhs.x || (lhs.x == rhs.x && lhs.y < rhs.y);
     }
 
-};
-
-template <typename T>
-struct Vec2dT
-{
-    Vec2dT(T xy = 0) : x{ xy }, y{ xy } {}
-    Vec2dT(T _x, T _y) : x{ _x }, y{ _y } {}
-
-    T x;
-    T y;
-
-    Vec2dT rotateClockwise()
+    // x in the top 32 bits and y in the bottom, as a hash or a key for a flat container
+    // Only round trips through fromKey when x and y fit in 32 bits (so bigger Ts are fine as long as the values aren't)
+    constexpr std::uint64_t key() const
     {
-        return { y, -x };
+        return static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32 | static_cast<std::uint32_t>(y);
     }
 
-    Vec2dT rotateAntiClockwise()
+    static constexpr Vec2dT fromKey(std::uint64_t key)
     {
-        return { -y, x };
+        return { static_cast<T>(static_cast<std::int32_t>(key >> 32)), static_cast<T>(static_cast<std::int32_t>(key & 0xFFFF'FFFFull)) };
     }
 
-    T static manhatDist(const Vec2dT &lhs, const Vec2dT &rhs)
+    friend std::ostream &operator<<(std::ostream &os, const Vec2dT& vec)
     {
-        return std::abs(lhs.x - rhs.x) + std::abs(lhs.y - rhs.y);
+        return os << "{ " << vec.x << ", " << vec.y << " }";
     }
 
-    friend Vec2dT operator+(const Vec2dT &lhs, const Vec2dT &rhs)
-    {
-        return {lhs.x + rhs.x, lhs.y + rhs.y };
-    }
+};
 
-    friend Vec2dT operator-(const Vec2dT &lhs, const Vec2dT &rhs)
-    {
-        return {lhs.x - rhs.x, lhs.y - rhs.y };
-    }
+using Vector2d = Vec2dT<int>;
 
-    Vec2dT operator*(T s)
-    {
-        return { x * s, y * s };
-    }
+template<typename T>
+struct std::hash<Vec2dT<T>>
+{
+    size_t operator()(const Vec2dT<T> &v) const noexcept { return vec::mix(v.key()); }
+};
 
-    Vec2dT operator/(T s)
+// Lots of them as an x array and a y array, so one thing done to all of them is a plain loop the compiler can vectorise
+template<typename T>
+class Vec2dBatch
+{
+public:
+    void reserve(size_t count)
     {
-        return { x / s, y / s };
+        m_xs.reserve(count);
+        m_ys.reserve(count);
     }
 
-    T operator[](T i)
+    void push_back(const Vec2dT<T> &vec)
     {
-        return i == 0 ? x : y;
+        m_xs.push_back(vec.x);
+        m_ys.push_back(vec.y);
     }
 
-    Vec2dT& operator+=(const Vec2dT &rhs)
-    {
-        x += rhs.x;
-        y += rhs.y;
-        return *this;
-    }
+    size_t size() const { return m_xs.size(); }
+    bool empty() const { return m_xs.empty(); }
+
+    Vec2dT<T> operator[](size_t i) const { return { m_xs[i], m_ys[i] }; }
+
+    std::span<const T> xs() const { return m_xs; }
+    std::span<const T> ys() const { return m_ys; }
 
-    Vec2dT& operator-=(const Vec2dT &rhs)
+    void translate(const Vec2dT<T> &by)
     {
-        x -= rhs.x;
-        y -= rhs.y;
-        return *this;
+        for (auto &x : m_xs) x += by.x;
+        for (auto &y : m_ys) y += by.y;
     }
 
-    friend bool operator==(const Vec2dT &lhs,const Vec2dT& rhs)
+    // out[i] is the manhattan distance from point to the ith one, out needs to be at least size() long
+    void manhatDists(const Vec2dT<T> &point, std::span<T> out) const
     {
-        return lhs.x == rhs.x && lhs.y == rhs.y;
+        const size_t count{ size() };
+        for (size_t i{ 0 }; i < count; ++i)
+        {
+            out[i] = vec::abs(m_xs[i] - point.x) + vec::abs(m_ys[i] - point.y);
+        }
     }
 
-    friend bool operator!=(const Vec2dT &lhs,const Vec2dT& rhs)
+    // The first i where point is no further than within[i] from the ith one, size() if there isn't one
+    // e.g. which sensor a point's in range of (day15)
+    size_t firstWithin(const Vec2dT<T> &point, std::span<const T> within) const
     {
-        return !(lhs == rhs);
+        const auto isWithin{ [&](size_t i) { return vec::abs(m_xs[i] - point.x) + vec::abs(m_ys[i] - point.y) <= within[i]; } };
+
+        // A block at a time without branching inside, only looking for which one it was when there's a hit
+        constexpr size_t block{ 16 };
+        const size_t count{ size() };
+        size_t i{ 0 };
+        for (; i + block <= count; i += block)
+        {
+            bool bHit{ false };
+            for (size_t j{ i }; j < i + block; ++j)
+            {
+                bHit |= isWithin(j);
+            }
+            if (bHit)
+                break;
+        }
+        for (; i < count; ++i)
+        {
+            if (isWithin(i))
+                return i;
+        }
+        return count;
     }
 
-    friend std::ostream &operator<<(std::ostream &os, const Vec2dT& vec)
+    // Lowest x and y, highest x and y, only when there's at least one
+    std::pair<Vec2dT<T>, Vec2dT<T>> bounds() const
     {
-        return os << "{ " << vec.x << ", " << vec.y << " }";
+        const auto [minX, maxX]{ std::minmax_element(m_xs.begin(), m_xs.end()) };
+        const auto [minY, maxY]{ std::minmax_element(m_ys.begin(), m_ys.end()) };
+        return { { *minX, *minY }, { *maxX, *maxY } };
     }
 
+private:
+    std::vector<T> m_xs;
+    std::vector<T> m_ys;
 };
@@ -2,58 +2,79 @@
 
 #include <array>
 #include <cmath>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <span>
 #include <string>
 #include <vector>
 
+#include "vector2d.h" // vec::abs, vec::mix
+
 struct Vector3d
 {
-    Vector3d(int xyz = 0) : x{ xyz }, y{ xyz }, z{ xyz } {}
-    Vector3d(int _x, int _y, int _z) : x{ _x }, y{ _y }, z{ _z } {}
+    constexpr Vector3d(int xyz = 0) : x{ xyz }, y{ xyz }, z{ xyz } {}
+    constexpr Vector3d(int _x, int _y, int _z) : x{ _x }, y{ _y }, z{ _z } {}
     Vector3d(const std::vector<int> &arr) : x{ arr[0] }, y{ arr[1] }, z{ arr[2] } {}
+    constexpr Vector3d(std::span<const int> arr) : x{ arr[0] }, y{ arr[1] }, z{ arr[2] } {}
     Vector3d(const std::vector<std::string> &arr) : x{ std::stoi(arr[0]) }, y{ std::stoi(arr[1]) }, z{ std::stoi(arr[2]) } {}
 
     template<typename T>
-    Vector3d(T _x, T _y, T _z) : x{ static_cast<int>(_x) }, y{ static_cast<int>(_y) }, z{ static_cast<int>(_z) } {}
+    constexpr Vector3d(T _x, T _y, T _z) : x{ static_cast<int>(_x) }, y{ static_cast<int>(_y) }, z{ static_cast<int>(_z) } {}
 
 
     int x;
     int y;
     int z;
 
-    void xyzMax(const Vector3d &rhs)
+    constexpr void xyzMax(const Vector3d &rhs)
     {
         x = rhs.x > x ? rhs.x : x;
         y = rhs.y > y ? rhs.y : y;
         z = rhs.z > z ? rhs.z : z;
     }
 
-    friend Vector3d operator+(const Vector3d &lhs, const Vector3d &rhs)
+    static constexpr int manhatDist(const Vector3d &lhs, const Vector3d &rhs)
+    {
+        return vec::abs(lhs.x - rhs.x) + vec::abs(lhs.y - rhs.y) + vec::abs(lhs.z - rhs.z);
+    }
+
+    friend constexpr Vector3d operator+(const Vector3d &lhs, const Vector3d &rhs)
     {
         return {lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z };
     }
 
-    friend Vector3d operator+(const Vector3d &lhs, int rhs)
+    friend constexpr Vector3d operator+(const Vector3d &lhs, int rhs)
     {
         return {lhs.x + rhs, lhs.y + rhs, lhs.z + rhs };
     }
 
-    friend Vector3d operator-(const Vector3d &lhs, const Vector3d &rhs)
+    friend constexpr Vector3d operator-(const Vector3d &lhs, const Vector3d &rhs)
     {
         return {lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z };
     }
 
-    Vector3d operator*(int s)
+    constexpr Vector3d operator*(int s) const
     {
         return { x * s, y * s, z * s };
     }
 
-    Vector3d operator/(int s)
+    constexpr Vector3d operator/(int s) const
     {
         return { x / s, y / s, z / s };
     }
 
-    Vector3d& operator+=(const Vector3d &rhs)
+    constexpr int operator[](int i) const
+    {
+        return i == 0 ? x : i == 1 ? y : z;
+    }
+
+    constexpr int& operator[](int i)
+    {
+        return i == 0 ? x : i == 1 ? y : z;
+    }
+
+    constexpr Vector3d& operator+=(const Vector3d &rhs)
     {
         x += rhs.x;
         y += rhs.y;
@@ -61,7 +82,7 @@ struct Vector3d
         return *this;
     }
 
-    Vector3d& operator-=(const Vector3d &rhs)
+    constexpr Vector3d& operator-=(const Vector3d &rhs)
     {
         x -= rhs.x;
         y -= rhs.y;
@@ -69,18 +90,50 @@ struct Vector3d
         return *this;
     }
 
-    friend bool operator==(const Vector3d &lhs,const Vector3d& rhs)
+    friend constexpr bool operator==(const Vector3d &lhs,const Vector3d& rhs)
     {
         return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z;
     }
 
-    friend bool operator!=(const Vector3d &lhs,const Vector3d& rhs)
+    friend constexpr bool operator!=(const Vector3d &lhs,const Vector3d& rhs)
     {
         return !(lhs == rhs);
     }
 
+    // x then y then z, for std::set and std::map
+    friend constexpr bool operator<(const Vector3d &lhs,const Vector3d& rhs)
+    {
+        return lhs.x < rhs.x || (lhs.x == rhs.x && (lhs.y < rhs.y || (lhs.y == rhs.y && lhs.z < rhs.z)));
+    }
+
+    // 21 bits each, so it round trips through fromKey for anything from -2^20 to 2^20 - 1
+    static constexpr int keyBits{ 21 };
+    static constexpr int keyOffset{ 1 << (keyBits - 1) };
+    static constexpr std::uint64_t keyMask{ (1ull << keyBits) - 1 };
+
+    constexpr std::uint64_t key() const
+    {
+        return (static_cast<std::uint64_t>(x + keyOffset) & keyMask) << (2 * keyBits) |
+            (static_cast<std::uint64_t>(y + keyOffset) & keyMask) << keyBits |
+            (static_cast<std::uint64_t>(z + keyOffset) & keyMask);
+    }
+
+    static constexpr Vector3d fromKey(std::uint64_t key)
+    {
+        return {
+            static_cast<int>((key >> (2 * keyBits)) & keyMask) - keyOffset,
+            static_cast<int>((key >> keyBits) & keyMask) - keyOffset,
+            static_cast<int>(key & keyMask) - keyOffset };
+    }
+
     friend std::ostream &operator<<(std::ostream &os, const Vector3d& vec)
     {
         return os << "{ " << vec.x << ", " << vec.y << ", " << vec.z << " }";
     }
 };
+
+template<>
+struct std::hash<Vector3d>
+{
+    size_t operator()(const Vector3d &v) const noexcept { return vec::mix(v.key()); }
+};
@@ -1,122 +1,368 @@
 // --- Day 1: Calorie Counting ---
 
 #include <algorithm>
-#include <array>
 #include <exception>
 #include <filesystem>
 #include <fstream>
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
-#include <numeric>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "debug.h"
+#include "generate.h"
+#include "inputview.h"
+#include "registry.h"
+#include "options.h"
+#include "scan.h"
+#include "stats.h"
+#include "stream.h"
+#include "threadpool.h"
 #include "utils.h"
 
-namespace Puzzle1
+namespace day01
 {
-	void solve(const std::string& infile)
+
+// Calories, or nothing for the blank line after each elf's
+std::optional<int> parseCalories(std::string_view line)
+{
+	if (line.empty())
 	{
-		std::ifstream inf { infile };
+		return std::nullopt;
+	}
+	return scan::toInt(line);
+}
 
-		if (!inf)
-		{
-			throw std::runtime_error("could not open " + infile);
-		}
+using TopK = stats::TopK<int>;
 
-		int highestCals{ 0 };
-		int elfCals{ 0 };
+// --top K, --percentiles 50,90,99.9 and --histogram N ask part 1 for more about the elves' totals than just the biggest
+// It's all worked out in the same pass as the answer, in memory that doesn't grow with the number of elves
+struct Query
+{
+	size_t top{ 0 };
+	std::vector<double> percentiles;
+	size_t buckets{ 0 };
 
-		while(!inf.eof())
-		{
-			std::string instr;
-			std::getline(inf, instr);
+	bool any() const { return top || !percentiles.empty() || buckets; }
+};
+
+const bool bQueryOptions{ []()
+{
+	options::add({ '\0', "top", flags::Flag::none, options::Arg::required });
+	options::add({ '\0', "percentiles", flags::Flag::none, options::Arg::required });
+	options::add({ '\0', "histogram", flags::Flag::none, options::Arg::required });
+	return true;
+}() };
+
+// Any that can't be used are left out with a message, same as a bad built in option
+Query queryFromOptions()
+{
+	Query query;
+	const auto &extra{ run::current().options.extra };
 
-			if (instr.length())
+	if (const auto top{ extra.find("top") }; top != extra.end() && !options::parseNumber(std::string_view{ top->second }, query.top, size_t{ 1 }))
+	{
+		std::cerr << "top can't use \"" << top->second << "\"\n";
+	}
+
+	if (const auto percentiles{ extra.find("percentiles") }; percentiles != extra.end())
+	{
+		scan::forEachSplit(percentiles->second, ",", [&query](std::string_view str)
+		{
+			double percentile{ 0.0 };
+			if (options::parseNumber(str, percentile, 0.0) && percentile <= 100.0)
 			{
-				elfCals += std::stoi(instr);
-				continue;
+				query.percentiles.push_back(percentile);
 			}
-
-			// new elf
-			if (elfCals > highestCals)
+			else
 			{
-				highestCals = elfCals;
+				std::cerr << "percentiles can't use \"" << str << "\"\n";
 			}
-			elfCals = 0;
+		});
+	}
+
+	if (const auto histogram{ extra.find("histogram") }; histogram != extra.end() && !options::parseNumber(std::string_view{ histogram->second }, query.buckets, size_t{ 2 }))
+	{
+		std::cerr << "histogram can't use \"" << histogram->second << "\"\n";
+	}
+
+	return query;
+}
+
+// What a query wants kept up as each elf's total goes past, part 1's answer is the top of top
+struct ElfStats
+{
+	explicit ElfStats(const Query &query) :
+		top{ std::max<size_t>(query.top, 1) },
+		histogram{ std::max<size_t>(query.buckets, 2) },
+		bDigest{ !query.percentiles.empty() },
+		bHistogram{ query.buckets > 0 }
+	{
+	}
+
+	size_t elves{ 0 };
+	TopK top;
+	stats::TDigest digest;
+	stats::Histogram histogram;
+	bool bDigest;
+	bool bHistogram;
+
+	void push(int total)
+	{
+		++elves;
+		top.push(total);
+		if (bDigest)
+		{
+			digest.add(total);
+		}
+		if (bHistogram)
+		{
+			histogram.add(static_cast<std::uint64_t>(total));
 		}
+	}
 
-		utils::printAnswer("most calories held by a single elf: ", highestCals);
+	void merge(const ElfStats &other)
+	{
+		elves += other.elves;
+		top.merge(other.top);
+		digest.merge(other.digest);
+		histogram.merge(other.histogram);
 	}
 };
 
-namespace Puzzle2
+void report(std::ostream &out, ElfStats &elfStats, const Query &query)
 {
-	void compareCals(std::array<int, 3> &arr, int cals)
+	out << elfStats.elves << " elves\n";
+
+	if (query.top)
 	{
-		if (cals < arr[0])
+		out << "top " << query.top << ":";
+		for (int total : elfStats.top.sorted())
 		{
-			return;
+			out << ' ' << total;
 		}
+		out << " (sum " << elfStats.top.sum() << ")\n";
+	}
 
-		arr[0] = cals;
+	if (!query.percentiles.empty())
+	{
+		out << "percentiles (approximate):";
+		for (double percentile : query.percentiles)
+		{
+			out << " p" << percentile << ' ' << std::llround(elfStats.digest.quantile(percentile / 100.0));
+		}
+		out << '\n';
+	}
+
+	if (query.buckets)
+	{
+		const auto &histogram{ elfStats.histogram };
+		const size_t last{ histogram.lastUsed() };
+		std::uint64_t most{ 1 };
+		for (size_t i{ 0 }; i <= last && i < histogram.buckets(); ++i)
+		{
+			most = std::max(most, histogram.count(i));
+		}
 
-		// Keep the least at position 0
-		std::sort(arr.begin(), arr.end());
+		for (size_t i{ 0 }; i <= last && i < histogram.buckets(); ++i)
+		{
+			const auto from{ i * histogram.width() };
+			out << std::setw(8) << from << " - " << std::setw(8) << from + histogram.width() - 1 << ' '
+				<< std::setw(10) << histogram.count(i) << ' ' << std::string(histogram.count(i) * 40 / most, '#') << '\n';
+		}
 	}
+}
 
-	void solve(const std::string& infile)
+// Every elf's total in [first, last) pushed to totals, which has to start at the start of an elf's list
+template<typename Totals>
+void sumElves(const char *first, const char *last, Totals &totals)
+{
+	int elfCals{ 0 };
+	bool bElf{ false };
+
+	while (first < last)
 	{
-		std::ifstream inf{ infile };
+		// blank line, new elf
+		if (*first == '\n')
+		{
+			if (bElf)
+			{
+				totals.push(elfCals);
+			}
+			elfCals = 0;
+			bElf = false;
+			++first;
+			continue;
+		}
 
-		if (!inf)
+		// Digits up to whatever isn't one, no sign or spaces to worry about
+		int calories{ 0 };
+		for (unsigned digit; first < last && (digit = static_cast<unsigned>(*first - '0')) < 10; ++first)
 		{
-			throw std::runtime_error("could not open " + infile);
+			calories = calories * 10 + static_cast<int>(digit);
 		}
+		elfCals += calories;
+		bElf = true;
 
-		std::string instr;
+		first = std::min(scan::find(first, last, '\n') + 1, last);
+	}
 
-		std::array<int, 3> highestCals{ 0, 0, 0 };
-		int elfCals{ 0 };
+	if (bElf)
+	{
+		totals.push(elfCals);
+	}
+}
 
-		while(!inf.eof())
+// scan::splitAtLines's pieces of data, each moved on to just after a blank line so no elf is split between two
+// Returns the starts with the end on the back, there may be fewer than asked for if there aren't enough blank lines
+std::vector<const char*> splitAtElves(std::string_view data, unsigned threads)
+{
+	const auto lines{ scan::splitAtLines(data, threads) };
+
+	std::vector<const char*> starts{ data.data() };
+	for (size_t i{ 1 }; i + 1 < lines.size(); ++i)
+	{
+		// From the newline before it, in case the line starting there is the blank one
+		const size_t from{ static_cast<size_t>(std::max(lines[i] - 1, starts.back()) - data.data()) };
+		const size_t blank{ scan::find(data, "\n\n", from) };
+		if (blank == data.size())
 		{
-			std::getline(inf, instr);
+			break;
+		}
+		starts.push_back(data.data() + blank + 2);
+	}
+	starts.push_back(data.data() + data.size());
+	return starts;
+}
 
-			if (!instr.length())
-			{
-				// new elf
-				compareCals(highestCals, elfCals);
-				elfCals = 0;
+// Every elf's total pushed to a copy of empty (a TopK, ElfStats, anything with push(int) and merge())
+// The mapped input's split between threads (-j, every core by default) which each keep their own copy, merged at the end
+// With --stream it's a line at a time through stream::Records instead
+template<typename Totals>
+Totals sumTotals(const std::string &infile, const Totals &empty, unsigned threads = run::current().options.threads)
+{
+	Totals totals{ empty };
 
+	if (flags::isSet(flags::Flag::stream))
+	{
+		stream::Records lines{ infile, parseCalories };
+
+		int elfCals{ 0 };
+		bool bElf{ false };
+		std::optional<int> calories;
+		while (lines.next(calories))
+		{
+			if (calories)
+			{
+				elfCals += *calories;
+				bElf = true;
 				continue;
 			}
 
-			elfCals += std::stoi(instr);
+			// new elf
+			if (bElf)
+			{
+				totals.push(elfCals);
+			}
+			elfCals = 0;
+			bElf = false;
+		}
+
+		// The last elf has no blank line after it
+		if (bElf)
+		{
+			totals.push(elfCals);
 		}
+		return totals;
+	}
 
-		auto caloriesSum{ std::accumulate(highestCals.begin(), highestCals.end(), 0) };
+	const InputView input{ infile, false };
+	const std::string_view data{ input.data() };
 
-		utils::printAnswer("calories held by the top three elves: ", caloriesSum);
+	const auto starts{ splitAtElves(data, threads) };
+	if (starts.size() == 2)
+	{
+		sumElves(starts[0], starts[1], totals);
+		return totals;
+	}
 
+	std::vector<Totals> partials(starts.size() - 1, empty);
+	{
+		ThreadPool pool{ static_cast<unsigned>(partials.size()) };
+		for (size_t i{ 0 }; i < partials.size(); ++i)
+		{
+			pool.push([&starts, &partials, i]() { sumElves(starts[i], starts[i + 1], partials[i]); });
+		}
+		pool.wait();
 	}
-};
 
-int main(int argc, char* argv[])
+	for (const auto &chunkTotals : partials)
+	{
+		totals.merge(chunkTotals);
+	}
+	return totals;
+}
+
+TopK topTotals(const std::string &infile, size_t k)
 {
-	flags::set(argc, argv);
+	return sumTotals(infile, TopK{ k });
+}
 
-	const std::string input{ utils::inputFile(__FILE__) };
+namespace Puzzle1
+{
+	void solve(const std::string& infile)
+	{
+		const Query query{ queryFromOptions() };
+		if (!query.any())
+		{
+			const auto highestCals{ topTotals(infile, 1).sum() };
+
+			utils::printAnswer("most calories held by a single elf: ", highestCals);
+			return;
+		}
+
+		auto elfStats{ sumTotals(infile, ElfStats{ query }) };
+		const auto top{ elfStats.top.sorted() };
+
+		utils::printAnswer("most calories held by a single elf: ", top.empty() ? 0 : top.front());
+		report(run::out(), elfStats, query);
+	}
+};
 
-	try
+namespace Puzzle2
+{
+	void solve(const std::string& infile)
 	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
+		const auto caloriesSum{ topTotals(infile, 3).sum() };
+
+		utils::printAnswer("calories held by the top three elves: ", caloriesSum);
 	}
-	catch(const std::exception& e)
+};
+
+namespace Generate
+{
+	// Groups of calorie counts, one group per elf, separated by blank lines
+	void input(std::ostream &out, double scale, generate::Random &random)
 	{
-		std::cerr << e.what() << '\n';
+		const size_t elves{ generate::count(250, scale) };
+		for (size_t elf{ 0 }; elf < elves; ++elf)
+		{
+			if (elf)
+			{
+				out << '\n';
+			}
+			const int items{ random.range(1, 15) };
+			for (int i{ 0 }; i < items; ++i)
+			{
+				out << random.range(1000, 20000) << '\n';
+			}
+		}
 	}
+};
 
-	return 0;
+} // namespace day01
 
-}
+AOC_MAIN(day01)
@@ -1,15 +1,35 @@
 // --- Day 2: Rock Paper Scissors ---
 
+#include <array>
+#include <cstdint>
 #include <exception>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <map>
+#include <numeric>
+#include <optional>
 #include <string>
 #include <string_view>
-
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+# include <immintrin.h>
+#endif
+
+#include "generate.h"
+#include "inputview.h"
+#include "registry.h"
+#include "scan.h"
+#include "stream.h"
+#include "threadpool.h"
 #include "utils.h"
 
+namespace day02
+{
+
 class Rps
 {
 public:
@@ -62,7 +82,7 @@ public:
 		}
 	}
 
-	static Choice outcome(char them, char outcome)
+	static constexpr Choice outcome(char them, char outcome)
 	{
 		if(outcome < 'X' || outcome > 'Z' ||
 		them < 'A' || them > 'C')
@@ -73,7 +93,7 @@ public:
 		return Rps::outcome(charThem(them), charOutcome(outcome));
 	}
 
-	static Choice outcome(Choice them, int outcome)
+	static constexpr Choice outcome(Choice them, int outcome)
 	{
 		if (static_cast<int>(them) <= static_cast<int>(errChoice) ||
 			static_cast<int>(them) >= static_cast<int>(endChoice) ||
@@ -100,7 +120,7 @@ public:
 		}
 	}
 
-	static int play(Choice them, Choice you)
+	static constexpr int play(Choice them, Choice you)
 	{      
 		if (static_cast<int>(you)  <= static_cast<int>(errChoice) ||
 			static_cast<int>(you)  >= static_cast<int>(endChoice) ||
@@ -141,7 +161,7 @@ public:
 
 	}
 
-	static int play(char themin, char youin)
+	static constexpr int play(char themin, char youin)
 	{
 		Choice them { static_cast<Choice>(themin - oppCharSub) };
 		Choice you { static_cast<Choice>(youin - youCharSub) };
@@ -149,39 +169,569 @@ public:
 		return play(them, you);
 	}
 
-	static int play2(char them, char outcome)
+	static constexpr int play2(char them, char outcome)
 	{
 		return Rps::play(Rps::charThem(them), Rps::outcome(them, outcome));
 		
 	}
 };
 
+// Every round's score looked up by the low two bits of its letters, where A B C are 1 2 3 and X Y Z are 0 1 2
+// so it's 16 bytes, one SIMD register. Other letters alias those, so check isRound() before looking one up
+using ScoreTable = std::array<std::uint8_t, 16>;
+
+constexpr size_t tableIndex(char them, char you)
+{
+	return static_cast<size_t>((them & 3) << 2 | (you & 3));
+}
+
+// Anything else scores 0, like Rps::play gives it
+constexpr bool isRound(char them, char you)
+{
+	return them >= 'A' && them <= 'C' && you >= 'X' && you <= 'Z';
+}
+
+template<typename Score>
+constexpr ScoreTable makeTable(Score score)
+{
+	ScoreTable table{};
+	for (char them : { 'A', 'B', 'C' })
+	{
+		for (char you : { 'X', 'Y', 'Z' })
+		{
+			table[tableIndex(them, you)] = static_cast<std::uint8_t>(score(them, you));
+		}
+	}
+	return table;
+}
+
+constexpr ScoreTable strategy1{ makeTable([](char them, char you) { return Rps::play(them, you); }) };
+constexpr ScoreTable strategy2{ makeTable([](char them, char outcome) { return Rps::play2(them, outcome); }) };
+
+// The example guide
+static_assert(strategy1[tableIndex('A', 'Y')] == 8 && strategy1[tableIndex('B', 'X')] == 1 && strategy1[tableIndex('C', 'Z')] == 6);
+static_assert(strategy2[tableIndex('A', 'Y')] == 4 && strategy2[tableIndex('B', 'X')] == 1 && strategy2[tableIndex('C', 'Z')] == 7);
+
+// Score of part of a guide, bStopped if it got to an empty line (where the guide ends, anything after isn't counted)
+struct Tally
+{
+	long long score{ 0 };
+	bool bStopped{ false };
+};
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+// A round to each 32 bit lane, them | ' ' << 8 | you << 16 | '\n' << 24, only while every 4th byte is a '\n' and no others are
+// and every them and you is a letter that means something
+// Sums are per lane, flushed before they could overflow (9 a round)
+constexpr size_t flushEvery{ 1 << 24 };
+constexpr int firstLetters{ 'A' | 'X' << 16 };
+#endif
+
+// [first, last) starts at the start of a line
+// While the lines are all "A X\n" they're scored a register at a time with a shuffle through the table, the rest a line at a time
+Tally scoreRounds(const char *first, const char *last, const ScoreTable &table)
+{
+	Tally tally;
+
+#if defined(__AVX2__)
+	const __m256i lut{ _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table.data()))) };
+	const __m256i newlines{ _mm256_set1_epi8('\n') };
+	const __m256i three{ _mm256_set1_epi32(3) };
+	const __m256i letters{ _mm256_set1_epi32(firstLetters) };
+	const __m256i two{ _mm256_set1_epi8(2) };
+
+	__m256i sums{ _mm256_setzero_si256() };
+	size_t blocks{ 0 };
+	while (last - first >= 32)
+	{
+		const __m256i rounds{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first)) };
+		if (static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(rounds, newlines))) != 0x88888888u)
+		{
+			break;
+		}
+		// A to C and X to Z are 0 to 2 once the first of each is taken off
+		const __m256i offsets{ _mm256_sub_epi8(rounds, letters) };
+		if ((static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(offsets, two), offsets))) & 0x55555555u) != 0x55555555u)
+		{
+			break;
+		}
+
+		const __m256i index{ _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(rounds, three), 2),
+			_mm256_and_si256(_mm256_srli_epi32(rounds, 16), three)) };
+		sums = _mm256_add_epi32(sums, _mm256_shuffle_epi8(lut, index));
+		first += 32;
+
+		if (++blocks == flushEvery)
+		{
+			alignas(32) std::array<std::uint32_t, 8> lanes;
+			_mm256_store_si256(reinterpret_cast<__m256i*>(lanes.data()), sums);
+			for (auto lane : lanes)
+			{
+				tally.score += lane;
+			}
+			sums = _mm256_setzero_si256();
+			blocks = 0;
+		}
+	}
+	if (blocks)
+	{
+		alignas(32) std::array<std::uint32_t, 8> lanes;
+		_mm256_store_si256(reinterpret_cast<__m256i*>(lanes.data()), sums);
+		for (auto lane : lanes)
+		{
+			tally.score += lane;
+		}
+	}
+#elif defined(__SSSE3__)
+	const __m128i lut{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(table.data())) };
+	const __m128i newlines{ _mm_set1_epi8('\n') };
+	const __m128i three{ _mm_set1_epi32(3) };
+	const __m128i letters{ _mm_set1_epi32(firstLetters) };
+	const __m128i two{ _mm_set1_epi8(2) };
+
+	__m128i sums{ _mm_setzero_si128() };
+	size_t blocks{ 0 };
+	while (last - first >= 16)
+	{
+		const __m128i rounds{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(first)) };
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(rounds, newlines)) != 0x8888)
+		{
+			break;
+		}
+		const __m128i offsets{ _mm_sub_epi8(rounds, letters) };
+		if ((_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(offsets, two), offsets)) & 0x5555) != 0x5555)
+		{
+			break;
+		}
+
+		const __m128i index{ _mm_or_si128(_mm_slli_epi32(_mm_and_si128(rounds, three), 2),
+			_mm_and_si128(_mm_srli_epi32(rounds, 16), three)) };
+		sums = _mm_add_epi32(sums, _mm_shuffle_epi8(lut, index));
+		first += 16;
+
+		if (++blocks == flushEvery)
+		{
+			alignas(16) std::array<std::uint32_t, 4> lanes;
+			_mm_store_si128(reinterpret_cast<__m128i*>(lanes.data()), sums);
+			for (auto lane : lanes)
+			{
+				tally.score += lane;
+			}
+			sums = _mm_setzero_si128();
+			blocks = 0;
+		}
+	}
+	if (blocks)
+	{
+		alignas(16) std::array<std::uint32_t, 4> lanes;
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes.data()), sums);
+		for (auto lane : lanes)
+		{
+			tally.score += lane;
+		}
+	}
+#endif
+
+	while (first < last)
+	{
+		const char *newline{ scan::find(first, last, '\n') };
+		if (newline == first)
+		{
+			tally.bStopped = true;
+			break;
+		}
+
+		// A line too short to be a round scores 0, same as Rps::play on it
+		if (newline - first > 2 && isRound(first[0], first[2]))
+		{
+			tally.score += table[tableIndex(first[0], first[2])];
+		}
+		first = std::min(newline + 1, last);
+	}
+
+	return tally;
+}
+
+// The mapped input split between threads at line starts (-j, every core by default), part(first, last) of each in order
+template<typename Part>
+auto splitGuide(std::string_view data, unsigned threads, Part part)
+{
+	const auto starts{ scan::splitAtLines(data, threads) };
+
+	std::vector<std::invoke_result_t<Part&, const char*, const char*>> parts(starts.size() - 1);
+	if (parts.size() == 1)
+	{
+		parts[0] = part(starts[0], starts[1]);
+	}
+	else
+	{
+		ThreadPool pool{ static_cast<unsigned>(parts.size()) };
+		for (size_t i{ 0 }; i < parts.size(); ++i)
+		{
+			pool.push([&starts, &parts, &part, i]() { parts[i] = part(starts[i], starts[i + 1]); });
+		}
+		pool.wait();
+	}
+	return parts;
+}
+
+// The whole guide's score
+long long scoreGuide(const std::string &infile, const ScoreTable &table, unsigned threads = run::current().options.threads)
+{
+	const InputView input{ infile, false };
+	const auto tallies{ splitGuide(input.data(), threads, [&table](const char *first, const char *last) { return scoreRounds(first, last, table); }) };
+
+	// In order, up to the first empty line
+	long long score{ 0 };
+	for (const auto &tally : tallies)
+	{
+		score += tally.score;
+		if (tally.bStopped)
+		{
+			break;
+		}
+	}
+	return score;
+}
+
+// "A X" -> 'A', 'X', nothing for a line too short to be a round (which scores 0, like scoreRounds() gives it)
+// bEnd for an empty line, where the guide ends
+struct Round
+{
+	char them{ 0 };
+	char you{ 0 };
+	bool bEnd{ false };
+};
+
+Round parseRound(std::string_view line)
+{
+	const size_t oppIndex{ 0 };
+	const size_t youIndex{ 2 };
+
+	if (line.empty())
+	{
+		return Round{ 0, 0, true };
+	}
+	return line.length() > youIndex ? Round{ line[oppIndex], line[youIndex] } : Round{};
+}
+
+// --- Trying out other strategies ---
+// A guide's score under any strategy only depends on how many of each round it has, so that's counted once
+// (however many guides) and every strategy is scored from the counts without going back over the rounds
+
+// How many of each round, by tableIndex(), bStopped like Tally
+struct RoundCounts
+{
+	std::array<long long, 16> counts{};
+	bool bStopped{ false };
+
+	void add(const RoundCounts &other)
+	{
+		for (size_t i{ 0 }; i < counts.size(); ++i)
+		{
+			counts[i] += other.counts[i];
+		}
+	}
+
+	long long rounds() const { return std::accumulate(counts.begin(), counts.end(), 0LL); }
+
+	long long score(const ScoreTable &table) const
+	{
+		long long score{ 0 };
+		for (size_t i{ 0 }; i < counts.size(); ++i)
+		{
+			score += counts[i] * table[i];
+		}
+		return score;
+	}
+};
+
+// Same lines as scoreRounds() counts, only rounds that mean something are counted
+RoundCounts countRounds(const char *first, const char *last)
+{
+	RoundCounts rounds;
+	while (first < last)
+	{
+		// Nearly every line's "A X\n", no need to search for the end of those
+		const bool bRound{ last - first > 3 && first[3] == '\n' && first[0] != '\n' && first[1] != '\n' && first[2] != '\n' };
+		const char *newline{ bRound ? first + 3 : scan::find(first, last, '\n') };
+		if (newline == first)
+		{
+			rounds.bStopped = true;
+			break;
+		}
+
+		if (newline - first > 2 && isRound(first[0], first[2]))
+		{
+			++rounds.counts[tableIndex(first[0], first[2])];
+		}
+		first = std::min(newline + 1, last);
+	}
+	return rounds;
+}
+
+RoundCounts countGuide(const std::string &infile, unsigned threads = run::current().options.threads)
+{
+	RoundCounts total;
+	if (flags::isSet(flags::Flag::stream))
+	{
+		stream::Records rounds{ infile, parseRound };
+		Round round;
+		while (rounds.next(round) && !round.bEnd)
+		{
+			if (isRound(round.them, round.you))
+			{
+				++total.counts[tableIndex(round.them, round.you)];
+			}
+		}
+		return total;
+	}
+
+	const InputView input{ infile, false };
+	for (const auto &counts : splitGuide(input.data(), threads, countRounds))
+	{
+		total.add(counts);
+		if (counts.bStopped)
+		{
+			break;
+		}
+	}
+	return total;
+}
+
+// Which choice each of X Y Z means, 27 of them, numbered like a 3 digit base 3 number XYZ from rock rock rock
+using Mapping = std::array<Rps::Choice, 3>;
+
+constexpr size_t mappings{ 27 };
+
+constexpr Mapping mapping(size_t number)
+{
+	return { static_cast<Rps::Choice>(1 + number / 9), static_cast<Rps::Choice>(1 + number / 3 % 3), static_cast<Rps::Choice>(1 + number % 3) };
+}
+
+constexpr std::array<ScoreTable, mappings> mappingTables{ []()
+{
+	std::array<ScoreTable, mappings> tables{};
+	for (size_t number{ 0 }; number < mappings; ++number)
+	{
+		tables[number] = makeTable([choices = mapping(number)](char them, char you) { return Rps::play(Rps::charThem(them), choices[you - 'X']); });
+	}
+	return tables;
+}() };
+
+// Part 1 reads the guide as X rock Y paper Z scissors
+static_assert(mappingTables[5] == strategy1);
+
+// "rps" for X rock Y paper Z scissors
+std::string mappingName(size_t number)
+{
+	std::string name;
+	for (const auto choice : mapping(number))
+	{
+		name += Rps::choicestr(choice)[0];
+	}
+	return name;
+}
+
+std::optional<size_t> parseMapping(std::string_view str)
+{
+	if (str.length() != 3)
+	{
+		return std::nullopt;
+	}
+
+	size_t number{ 0 };
+	for (const char ch : str)
+	{
+		const size_t digit{ std::string_view{ "rps" }.find(ch) };
+		if (digit == std::string_view::npos)
+		{
+			return std::nullopt;
+		}
+		number = number * 3 + digit;
+	}
+	return number;
+}
+
+// Mappings picked between at random in proportion to their weights, "psr:3+rrr" is 3 parts psr to 1 part rrr
+// Its expected score's the weighted average of theirs, so it's never better than the best of them
+struct Mix
+{
+	std::string name;
+	std::vector<std::pair<size_t, double>> parts; // Mapping number, weight
+
+	double score(const std::array<long long, mappings> &scores) const
+	{
+		double total{ 0.0 };
+		double weights{ 0.0 };
+		for (const auto &[number, weight] : parts)
+		{
+			total += scores[number] * weight;
+			weights += weight;
+		}
+		return weights > 0.0 ? total / weights : 0.0;
+	}
+};
+
+std::optional<Mix> parseMix(std::string_view str)
+{
+	Mix mix{ std::string{ str }, {} };
+	bool bGood{ true };
+	scan::forEachSplit(str, "+", [&mix, &bGood](std::string_view part)
+	{
+		const size_t colon{ part.find(':') };
+		const auto number{ parseMapping(part.substr(0, colon)) };
+		double weight{ 1.0 };
+		if (!number || (colon != std::string_view::npos && !options::parseNumber(part.substr(colon + 1), weight, 0.0)))
+		{
+			bGood = false;
+			return;
+		}
+		mix.parts.emplace_back(*number, weight);
+	});
+
+	if (!bGood || mix.parts.empty())
+	{
+		return std::nullopt;
+	}
+	return mix;
+}
+
+struct StrategyQuery
+{
+	size_t best{ 0 };                // --strategies, how many of the best to list
+	std::vector<std::string> guides; // --guides, opponents' guides to count as well as the input
+	std::vector<Mix> mixes;          // --mix
+
+	bool any() const { return best || !guides.empty() || !mixes.empty(); }
+};
+
+const bool bStrategyOptions{ []()
+{
+	options::add({ '\0', "strategies", flags::Flag::none, options::Arg::required });
+	options::add({ '\0', "guides", flags::Flag::none, options::Arg::required });
+	options::add({ '\0', "mix", flags::Flag::none, options::Arg::required });
+	return true;
+}() };
+
+// Any that can't be used are left out with a message, same as a bad built in option
+StrategyQuery strategyQueryFromOptions()
+{
+	StrategyQuery query;
+	const auto &extra{ run::current().options.extra };
+
+	if (const auto best{ extra.find("strategies") }; best != extra.end() && !options::parseNumber(std::string_view{ best->second }, query.best, size_t{ 1 }))
+	{
+		std::cerr << "strategies can't use \"" << best->second << "\"\n";
+	}
+
+	if (const auto guides{ extra.find("guides") }; guides != extra.end())
+	{
+		scan::forEachSplit(guides->second, ",", [&query](std::string_view str) { query.guides.emplace_back(str); });
+	}
+
+	if (const auto mixes{ extra.find("mix") }; mixes != extra.end())
+	{
+		scan::forEachSplit(mixes->second, ",", [&query](std::string_view str)
+		{
+			if (auto mix{ parseMix(str) })
+			{
+				query.mixes.push_back(std::move(*mix));
+			}
+			else
+			{
+				std::cerr << "mix can't use \"" << str << "\"\n";
+			}
+		});
+	}
+
+	return query;
+}
+
+// The best of the 27 mappings and part 2's reading of the guide (X lose Y draw Z win), then any mixes
+void report(std::ostream &out, const RoundCounts &rounds, size_t guides, const StrategyQuery &query)
+{
+	std::array<long long, 3> opponent{};
+	for (char them : { 'A', 'B', 'C' })
+	{
+		for (char you : { 'X', 'Y', 'Z' })
+		{
+			opponent[static_cast<size_t>(them - 'A')] += rounds.counts[tableIndex(them, you)];
+		}
+	}
+	out << rounds.rounds() << " rounds in " << guides << (guides == 1 ? " guide" : " guides")
+		<< ", opponent played rock " << opponent[0] << " paper " << opponent[1] << " scissors " << opponent[2] << '\n';
+
+	std::array<long long, mappings> scores{};
+	std::vector<std::pair<long long, std::string>> ranked;
+	for (size_t number{ 0 }; number < mappings; ++number)
+	{
+		scores[number] = rounds.score(mappingTables[number]);
+		ranked.emplace_back(scores[number], "XYZ=" + mappingName(number));
+	}
+	ranked.emplace_back(rounds.score(strategy2), "XYZ=lose/draw/win");
+
+	// Best first, ties by name so it's the same every time
+	std::sort(ranked.begin(), ranked.end(), [](const auto &a, const auto &b) { return a.first != b.first ? a.first > b.first : a.second < b.second; });
+
+	const size_t best{ std::min(std::max<size_t>(query.best, 1), ranked.size()) };
+	out << "best " << best << " of " << ranked.size() << " strategies:\n";
+	for (size_t i{ 0 }; i < best; ++i)
+	{
+		out << std::setw(4) << i + 1 << ' ' << std::left << std::setw(20) << ranked[i].second << std::right << ' ' << ranked[i].first << '\n';
+	}
+
+	for (const auto &mix : query.mixes)
+	{
+		out << "mix " << mix.name << ": " << std::fixed << std::setprecision(1) << mix.score(scores) << std::defaultfloat << " expected\n";
+	}
+}
+
 namespace Puzzle1
 {
 	void solve(const std::string& infile)
 	{
-		std::ifstream inf { infile };
+		const StrategyQuery query{ strategyQueryFromOptions() };
+		if (query.any())
+		{
+			auto rounds{ countGuide(infile) };
+			utils::printAnswer("your score after following strategy 1: ", rounds.score(strategy1));
 
-		if (!inf)
+			size_t guides{ 1 };
+			for (const auto &guide : query.guides)
+			{
+				try
+				{
+					rounds.add(countGuide(guide));
+					++guides;
+				}
+				catch (const std::exception &e)
+				{
+					std::cerr << "guide " << guide << " left out: " << e.what() << '\n';
+				}
+			}
+			report(run::out(), rounds, guides, query);
+			return;
+		}
+
+		if (!flags::isSet(flags::Flag::stream))
 		{
-			throw std::runtime_error("could not open " + infile);
+			utils::printAnswer("your score after following strategy 1: ", scoreGuide(infile, strategy1));
+			return;
 		}
 
-        const int oppIndex{ 0 };
-        const int youIndex{ 2 };
+		stream::Records rounds{ infile, parseRound };
 
-        int yourScore{ 0 };
-        while (inf)
+        long long yourScore{ 0 };
+        Round round;
+        while (rounds.next(round))
         {
-            std::string instr;
-            std::getline(inf, instr);
-
-			if (instr.length() == 0)
+			if (round.bEnd)
 			{
 				break;
 			}
 
-            yourScore += Rps::play(instr[oppIndex], instr[youIndex]);
+            yourScore += Rps::play(round.them, round.you);
         }
 		utils::printAnswer("your score after following strategy 1: ", yourScore);
 
@@ -192,46 +742,39 @@ namespace Puzzle2
 {
 	void solve(const std::string& infile)
 	{
-		std::ifstream inf{ infile };
-
-		if (!inf)
+		if (!flags::isSet(flags::Flag::stream))
 		{
-			throw std::runtime_error("could not open " + infile);
+			utils::printAnswer("your score after following strategy 2: ", scoreGuide(infile, strategy2));
+			return;
 		}
 
-        const int oppIndex{ 0 };
-        const int youIndex{ 2 };
+		stream::Records rounds{ infile, parseRound };
 
-        int yourScore{ 0 };
-        while (inf)
+        long long yourScore{ 0 };
+        Round round;
+        while (rounds.next(round))
         {
-            std::string instr;
-            std::getline(inf, instr);
-			if (!instr.length()) { break; }
+			if (round.bEnd) { break; }
 
-            yourScore += Rps::play2(instr[oppIndex], instr[youIndex]);
+            yourScore += Rps::play2(round.them, round.you);
         }
 
 		utils::printAnswer("your score after following strategy 2: ", yourScore);
 	}
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
-
-	const std::string input{ utils::inputFile(__FILE__) };
-
-	try
-	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
+	void input(std::ostream &out, double scale, generate::Random &random)
 	{
-		std::cerr << e.what() << '\n';
+		const size_t rounds{ generate::count(2500, scale) };
+		for (size_t i{ 0 }; i < rounds; ++i)
+		{
+			out << random.pick("ABC") << ' ' << random.pick("XYZ") << '\n';
+		}
 	}
+};
 
-	return 0;
+} // namespace day02
 
-}
+AOC_MAIN(day02)
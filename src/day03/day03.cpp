@@ -2,19 +2,37 @@
 
 #include <algorithm>
 #include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
 #include <exception> 
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <vector>
 
+#if defined(__AVX2__)
+# include <immintrin.h>
+#endif
+
+#include "generate.h"
+#include "inputview.h"
+#include "registry.h"
+#include "scan.h"
+#include "stream.h"
+#include "threadpool.h"
 #include "utils.h"
 
+namespace day03
+{
+
 namespace Day3
 {
-    int charValue(char ch)
+    constexpr int charValue(char ch)
     {
         // a-z = 1-26, A-Z = 27-52
         constexpr int lowerSub{ 'a' - 1 };  
@@ -22,157 +40,373 @@ namespace Day3
 
         return ch > 'Z' ? ch - lowerSub : ch - upperSub;
     }
-};
 
-namespace Puzzle1
-{
-    char findSharedItems(std::string_view comp1, std::string_view comp2)
+    // Which items there are, bit charValue() for each, so what's shared is an AND and its priority is the lowest bit set
+    using Items = std::uint64_t;
+
+    // Anything that isn't a letter isn't an item
+    constexpr std::array<Items, 256> itemBits{ []()
     {
-        std::vector<char> ignore;
-        ignore.reserve(comp1.length());
+        std::array<Items, 256> bits{};
+        for (char ch{ 'a' }; ch <= 'z'; ++ch)
+        {
+            bits[static_cast<unsigned char>(ch)] = Items{ 1 } << charValue(ch);
+            bits[static_cast<unsigned char>(ch - 'a' + 'A')] = Items{ 1 } << charValue(static_cast<char>(ch - 'a' + 'A'));
+        }
+        return bits;
+    }() };
+
+    // The items in [first, last), which can load (but won't use) anything up to readable so it's whole registers
+    Items items(const char *first, const char *last, [[maybe_unused]] const char *readable)
+    {
+        Items found{ 0 };
+#if defined(__AVX2__)
+        // Each byte's made its charValue(), or 64 if it's not a letter or it's past last, then 4 at a time are widened
+        // to 64 bits and 1 shifted left by them, 64 shifting it right out
+        const __m256i one{ _mm256_set1_epi64x(1) };
+        const __m256i none{ _mm256_set1_epi8(64) };
+        const __m256i upperZ{ _mm256_set1_epi8('Z') };
+        const __m256i lowerSub{ _mm256_set1_epi8('a' - 1) };
+        const __m256i upperSub{ _mm256_set1_epi8('A' - 27) };
+        const __m256i caseBit{ _mm256_set1_epi8(0x20) };
+        const __m256i lowerA{ _mm256_set1_epi8('a') };
+        const __m256i letters{ _mm256_set1_epi8(25) };
+        const __m256i positions{ _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+            16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31) };
 
-        for (auto ch1 : comp1)
+        const auto fourAt{ [&one](__m128i values) { return _mm256_sllv_epi64(one, _mm256_cvtepu8_epi64(values)); } };
+
+        __m256i bits{ _mm256_setzero_si256() };
+        while (first < last && readable - first >= 32)
         {
-            // Might be more efficient if we ignore chars we've already checked:
-            if (std::find(ignore.begin(), ignore.end(), ch1) != ignore.end())
+            const __m256i block{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first)) };
+
+            const __m256i fromA{ _mm256_sub_epi8(_mm256_or_si256(block, caseBit), lowerA) };
+            const __m256i letter{ _mm256_cmpeq_epi8(_mm256_min_epu8(fromA, letters), fromA) };
+            const __m256i inRange{ _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(std::min<ptrdiff_t>(last - first, 32))), positions) };
+            const __m256i values{ _mm256_sub_epi8(block, _mm256_blendv_epi8(upperSub, lowerSub, _mm256_cmpgt_epi8(block, upperZ))) };
+            const __m256i used{ _mm256_blendv_epi8(none, values, _mm256_and_si256(letter, inRange)) };
+
+            const __m128i low{ _mm256_castsi256_si128(used) };
+            const __m128i high{ _mm256_extracti128_si256(used, 1) };
+            bits = _mm256_or_si256(bits, _mm256_or_si256(
+                _mm256_or_si256(_mm256_or_si256(fourAt(low), fourAt(_mm_srli_si128(low, 4))), _mm256_or_si256(fourAt(_mm_srli_si128(low, 8)), fourAt(_mm_srli_si128(low, 12)))),
+                _mm256_or_si256(_mm256_or_si256(fourAt(high), fourAt(_mm_srli_si128(high, 4))), _mm256_or_si256(fourAt(_mm_srli_si128(high, 8)), fourAt(_mm_srli_si128(high, 12))))));
+            first += 32;
+        }
+
+        const __m128i pairs{ _mm_or_si128(_mm256_castsi256_si128(bits), _mm256_extracti128_si256(bits, 1)) };
+        found = static_cast<Items>(_mm_cvtsi128_si64(_mm_or_si128(pairs, _mm_unpackhi_epi64(pairs, pairs))));
+#endif
+        for (; first < last; ++first)
+        {
+            found |= itemBits[static_cast<unsigned char>(*first)];
+        }
+        return found;
+    }
+
+    Items items(std::string_view str)
+    {
+        return items(str.data(), str.data() + str.length(), str.data() + str.length());
+    }
+
+    // The priority of the lowest item in shared
+    int priority(Items shared)
+    {
+        return std::countr_zero(shared);
+    }
+
+    // Sum of priorities for a part of the input, bStopped if it got to where the input stops counting
+    // bNoneShared if a rucksack or group had nothing in common before that
+    struct Sum
+    {
+        long long sum{ 0 };
+        bool bStopped{ false };
+        bool bNoneShared{ false };
+    };
+
+    // Where each thread's part of the mapped input starts (and the end last), always at a line that's a multiple of
+    // linesPerPart in (-j, every core by default)
+    std::vector<const char*> splitLines(std::string_view data, size_t linesPerPart, unsigned threads)
+    {
+        auto starts{ scan::splitAtLines(data, threads) };
+        const char *const end{ starts.back() };
+
+        if (linesPerPart == 1 || starts.size() == 2)
+        {
+            return starts;
+        }
+
+        // Lines in each, counted on every core too, then each start moves on to the next line that begins a part
+        std::vector<size_t> lines(starts.size() - 1);
+        {
+            ThreadPool pool{ static_cast<unsigned>(lines.size()) };
+            for (size_t i{ 0 }; i < lines.size(); ++i)
             {
-                continue;
+                pool.push([&starts, &lines, i]() { lines[i] = scan::count(starts[i], starts[i + 1], '\n'); });
             }
+        }
 
-            // Does our char from compartment 1 appear in compartment 2?
-            for (auto ch2 : comp2)
+        size_t line{ 0 };
+        for (size_t i{ 1 }; i + 1 < starts.size(); ++i)
+        {
+            line += lines[i - 1];
+            for (size_t skip{ (linesPerPart - line % linesPerPart) % linesPerPart }; skip && starts[i] < end; --skip)
             {
-                if (ch1 == ch2)
-                {
-                    return ch1;
-                }
+                starts[i] = std::min(scan::find(starts[i], end, '\n') + 1, end);
             }
-            ignore.push_back(ch1);
         }
-        return ' ';
+        return starts;
     }
 
-    char findSharedItems(std::string_view rucksack)
+    // Each part's Sum from sumPart(first, last, end) where end's the end of the input, added up in order
+    // up to the one that stopped, throws if one had nothing shared before then
+    template<typename SumPart>
+    long long sumParts(const std::string &infile, size_t linesPerPart, SumPart sumPart, unsigned threads = run::current().options.threads)
     {
-        std::string_view firstHalf{ rucksack.substr(0, rucksack.length() / 2) };
-        std::string_view secondHalf{ rucksack.substr(rucksack.length() / 2, rucksack.length() / 2) };
+        const InputView input{ infile, false };
+        const std::string_view data{ input.data() };
+        const char *const end{ data.data() + data.size() };
+        const auto starts{ splitLines(data, linesPerPart, threads) };
 
-        char dupe{ findSharedItems(firstHalf, secondHalf) };
-        if (dupe != ' ')
+        std::vector<Sum> sums(starts.size() - 1);
+        if (sums.size() == 1)
         {
-            return dupe;
+            sums[0] = sumPart(starts[0], starts[1], end);
         }
         else
         {
-            std::cerr << "no duplicates (this shouldn't happen!)\n";
-            throw std::runtime_error("couldn't find a solution!");
+            ThreadPool pool{ static_cast<unsigned>(sums.size()) };
+            for (size_t i{ 0 }; i < sums.size(); ++i)
+            {
+                pool.push([&starts, &sums, &sumPart, end, i]() { sums[i] = sumPart(starts[i], starts[i + 1], end); });
+            }
+            pool.wait();
+        }
+
+        long long total{ 0 };
+        for (const auto &sum : sums)
+        {
+            if (sum.bNoneShared)
+            {
+                std::cerr << "no duplicates (this shouldn't happen!)\n";
+                throw std::runtime_error("couldn't find a solution!");
+            }
+
+            total += sum.sum;
+            if (sum.bStopped)
+            {
+                break;
+            }
         }
+        return total;
     }
+};
 
-	void solve(const std::string& infile)
-	{
-		std::ifstream inf { infile };
+namespace Puzzle1
+    // What's in both halves of the rucksack (the last item of an odd length one's in neither)
+    // What's in both halves of the rucksack (the middle item of an odd one's in neither)
+    Day3::Items findSharedItems(const char *first, const char *last, const char *readable)
+    {
+        const ptrdiff_t half{ (last - first) / 2 };
+        return Day3::items(first, first + half, readable) & Day3::items(first + half, first + half * 2, readable);
+    }
 
-		if (!inf)
-		{
-			throw std::runtime_error("could not open " + infile);
-		}
+    // Rucksacks from first up to last, stops at a line too short to be one
+    Day3::Sum sumRucksacks(const char *first, const char *last, const char *end)
+    {
+        Day3::Sum sum;
+        while (first < last)
+        {
+            const char *newline{ scan::find(first, end, '\n') };
+            if (newline - first <= 1)
+            {
+                sum.bStopped = true;
+                break;
+            }
 
-        int prioritiesSum{ 0 };
+            const Day3::Items shared{ findSharedItems(first, newline, end) };
+            if (!shared)
+            {
+                sum.bNoneShared = true;
+                break;
+            }
+            sum.sum += Day3::priority(shared);
+            first = newline + 1;
+        }
+        return sum;
+    }
 
-        while (inf)
+	void solve(const std::string& infile)
+	{
+        if (!flags::isSet(flags::Flag::stream))
         {
-            std::string instr;
-            std::getline(inf, instr);
+            utils::printAnswer("priorities sum: ", Day3::sumParts(infile, 1, sumRucksacks));
+            return;
+        }
 
-            if (instr.length() > 1)
+        // The searching's done as the lines are parsed, so with --stream it's all on the reader thread
+        // 0 for a line too short to be a rucksack, which is where it stops
+        stream::Records priorities{ infile, [](std::string_view rucksack)
+        {
+            if (rucksack.length() <= 1)
             {
-                prioritiesSum += Day3::charValue(findSharedItems(instr));
+                return 0;
             }
-            else
+
+            const auto end{ rucksack.data() + rucksack.length() };
+            const Day3::Items shared{ findSharedItems(rucksack.data(), end, end) };
+            if (!shared)
             {
-                utils::printAnswer("priorities sum: ", prioritiesSum);
-                return; // finished
+                std::cerr << "no duplicates (this shouldn't happen!)\n";
+                throw std::runtime_error("couldn't find a solution!");
             }
+            return Day3::priority(shared);
+        } };
+
+        long long prioritiesSum{ 0 };
+
+        int priority{ 0 };
+        while (priorities.next(priority) && priority)
+        {
+            prioritiesSum += priority;
         }
+
+        utils::printAnswer("priorities sum: ", prioritiesSum);
 	}
 };
 
 namespace Puzzle2
 {
-
-    char findSharedBadge(std::array<std::string, 3> elfGroup)
+    // Groups of three starting from first up to last (their lines can go on past it), stops at an empty line
+    // or a group that isn't finished before the end
+    Day3::Sum sumGroups(const char *first, const char *last, const char *end)
     {
-        std::vector<char> ignore;
-
-        for (auto ch1: elfGroup[0])
+        Day3::Sum sum;
+        while (first < last)
         {
-            if (std::find(ignore.begin(), ignore.end(), ch1) != ignore.end())
+            Day3::Items badge{ ~Day3::Items{ 0 } };
+            for (size_t elf{ 0 }; elf < 3; ++elf)
             {
-                continue;
-            }
+                const char *newline{ scan::find(first, end, '\n') };
+                if (newline == first)
+                {
+                    sum.bStopped = true;
+                    return sum;
+                }
 
-            if (std::find(elfGroup[1].begin(), elfGroup[1].end(), ch1) == elfGroup[1].end())
-            {
-                ignore.push_back(ch1);
-                continue;
+                badge &= Day3::items(first, newline, end);
+                first = std::min(newline + 1, end);
             }
 
-            if (std::find(elfGroup[2].begin(), elfGroup[2].end(), ch1) != elfGroup[2].end())
+            if (!badge)
             {
-                return ch1;
+                sum.bNoneShared = true;
+                break;
             }
+            sum.sum += Day3::priority(badge);
         }
-
-        return ' ';
+        return sum;
     }
 
 	void solve(const std::string& infile)
 	{
-		std::ifstream inf{ infile };
+        if (!flags::isSet(flags::Flag::stream))
+        {
+            utils::printAnswer("priorities sum: ", Day3::sumParts(infile, 3, sumGroups));
+            return;
+        }
 
-		if (!inf)
-		{
-			throw std::runtime_error("could not open " + infile);
-		}
+        // Nothing for an empty line, which is where it stops
+        stream::Records rucksacks{ infile, [](std::string_view line)
+        {
+            return line.empty() ? std::nullopt : std::optional{ Day3::items(line) };
+        } };
 
-        std::array<std::string, 3> elfGroup;
-        int sum{ 0 };
+        std::optional<Day3::Items> rucksack;
+        long long sum{ 0 };
 
-        while (inf)
+        while (true)
         {
+            Day3::Items badge{ ~Day3::Items{ 0 } };
             for (size_t i{ 0 }; i < 3; ++i)
             {
-                std::getline(inf, elfGroup[i]);
-                
-                if(elfGroup[i].length() < 1)
+                if (!rucksacks.next(rucksack) || !rucksack)
                 {
                     utils::printAnswer("priorities sum: ", sum);
                     return; // finished
                 }
+                badge &= *rucksack;
             }
 
-            sum += Day3::charValue(findSharedBadge(elfGroup));
+            if (!badge)
+            {
+                std::cerr << "no badge (this shouldn't happen!)\n";
+                throw std::runtime_error("couldn't find a solution!");
+            }
+            sum += Day3::priority(badge);
         }
 	}
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
+    // Groups of three rucksacks: each has exactly one item in both compartments and
+    // each group has exactly one item (the badge) in all three
+    void input(std::ostream &out, double scale, generate::Random &random)
+    {
+        const std::string_view items{ "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ" };
+        const size_t groups{ generate::count(100, scale) };
 
-	const std::string input{ utils::inputFile(__FILE__) };
+        for (size_t group{ 0 }; group < groups; ++group)
+        {
+            const char badge{ random.pick(items) };
 
-	try
-	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
-	{
-		std::cerr << e.what() << '\n';
-	}
+            // Every other item is left out of at least one of the three
+            std::array<std::string, 3> allowed;
+            for (char item : items)
+            {
+                const size_t without{ random.index(3) };
+                for (size_t elf{ 0 }; elf < 3; ++elf)
+                {
+                    if (item == badge || elf != without)
+                    {
+                        allowed[elf] += item;
+                    }
+                }
+            }
+
+            for (auto &pool : allowed)
+            {
+                random.shuffle(pool);
+                const char shared{ pool.back() };
+                pool.pop_back();
+
+                // Everything else goes in one compartment or the other, never both
+                const size_t half{ pool.size() / 2 };
+                const size_t length{ static_cast<size_t>(random.range(8, 24)) };
+                std::string left{ shared };
+                std::string right{ shared };
+                while (left.length() < length)
+                {
+                    left += pool[random.index(half)];
+                    right += pool[half + random.index(pool.size() - half)];
+                }
+
+                if (badge != shared)
+                {
+                    const bool bLeft{ pool.find(badge) < half };
+                    (bLeft ? left : right)[1] = badge;
+                }
+
+                random.shuffle(left);
+                random.shuffle(right);
+                out << left << right << '\n';
+            }
+        }
+    }
+};
 
-	return 0;
+} // namespace day03
 
-}
+AOC_MAIN(day03)
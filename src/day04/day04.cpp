@@ -5,11 +5,18 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <optional>
 #include <string>
 #include <string_view>
 
+#include "generate.h"
+#include "registry.h"
+#include "stream.h"
 #include "utils.h"
 
+namespace day04
+{
+
 namespace Day4
 {
 	// std::array<int, 4> getRanges(std::string_view elfpair) // string_view caused a subscript out of range error on Windows not sure why
@@ -33,6 +40,16 @@ namespace Day4
 
 		return ranges;
 	}
+
+	// Nothing for an empty line, which is where it stops
+	std::optional<std::array<int, 4>> parsePair(std::string_view elfpair)
+	{
+		if (elfpair.empty())
+		{
+			return std::nullopt;
+		}
+		return getRanges(std::string{ elfpair });
+	}
 }
 
 namespace Puzzle1
@@ -48,27 +65,16 @@ namespace Puzzle1
 
 	void solve(const std::string& infile)
 	{
-		std::ifstream inf { infile };
-
-		if (!inf)
-		{
-			throw std::runtime_error("could not open " + infile);
-		}
+		stream::Records pairs{ infile, Day4::parsePair };
 		
 		int containedCount{ 0 };
-        while (inf)
+		std::optional<std::array<int, 4>> elfpair;
+        while (pairs.next(elfpair) && elfpair)
         {
-            std::string elfpair;
-            std::getline(inf, elfpair);
-
-            if (elfpair.length() < 1)
-            {
-				utils::printAnswer("contained count: ", containedCount);
-                return; // finished
-            }
-
-			containedCount += checkContained(Day4::getRanges(elfpair));
+			containedCount += checkContained(*elfpair);
 		}
+
+		utils::printAnswer("contained count: ", containedCount);
 	}
 };
 
@@ -83,46 +89,33 @@ namespace Puzzle2
 
 	void solve(const std::string& infile)
 	{
-		std::ifstream inf{ infile };
-
-		if (!inf)
-		{
-			throw std::runtime_error("could not open " + infile);
-		}
+		stream::Records pairs{ infile, Day4::parsePair };
 
 		int overlapCount{ 0 };
-        while (inf)
+		std::optional<std::array<int, 4>> elfpair;
+        while (pairs.next(elfpair) && elfpair)
         {
-            std::string elfpair;
-            std::getline(inf, elfpair);
-
-            if (elfpair.length() < 1)
-            {
-				utils::printAnswer("overlap count: ", overlapCount);
-                return; // finished
-            }
-
-			overlapCount += checkOverlap(Day4::getRanges(elfpair));
+			overlapCount += checkOverlap(*elfpair);
 		}
+
+		utils::printAnswer("overlap count: ", overlapCount);
 	}
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
-
-	const std::string input{ utils::inputFile(__FILE__) };
-
-	try
+	void input(std::ostream &out, double scale, generate::Random &random)
 	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
-	{
-		std::cerr << e.what() << '\n';
+		const size_t pairs{ generate::count(1000, scale) };
+		for (size_t i{ 0 }; i < pairs; ++i)
+		{
+			const int firstStart{ random.range(1, 99) };
+			const int secondStart{ random.range(1, 99) };
+			out << firstStart << '-' << random.range(firstStart, 99) << ',' << secondStart << '-' << random.range(secondStart, 99) << '\n';
+		}
 	}
+};
 
-	return 0;
+} // namespace day04
 
-}
+AOC_MAIN(day04)
@@ -12,8 +12,13 @@
 #include <string_view>
 #include <vector>
 
+#include "generate.h"
+#include "registry.h"
 #include "utils.h"
 
+namespace day05
+{
+
 namespace Day5
 {
 	using CrateStackType = std::deque<char>;
@@ -209,22 +214,65 @@ namespace Puzzle2
 	}
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
+	// Nine stacks drawn like the puzzle's, then moves that never empty a stack (the tops are the answer)
+	void input(std::ostream &out, double scale, generate::Random &random)
+	{
+		const std::string_view letters{ "ABCDEFGHIJKLMNOPQRSTUVWXYZ" };
+		const size_t stacks{ 9 };
 
-	const std::string input{ utils::inputFile(__FILE__) };
+		std::array<std::string, stacks> crates;
+		size_t tallest{ 0 };
+		for (auto &stack : crates)
+		{
+			stack.resize(static_cast<size_t>(random.range(2, 8)));
+			for (char &crate : stack)
+			{
+				crate = random.pick(letters);
+			}
+			tallest = std::max(tallest, stack.size());
+		}
 
-	try
-	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
-	{
-		std::cerr << e.what() << '\n';
+		// Every row is padded to the full width, the puzzle counts the stacks from the first row's length
+		for (size_t row{ tallest }; row > 0; --row)
+		{
+			std::string line;
+			for (const auto &stack : crates)
+			{
+				line += stack.size() >= row ? std::string{ '[', stack[row - 1], ']' } : "   ";
+				line += ' ';
+			}
+			out << line.substr(0, stacks * 4 - 1) << '\n';
+		}
+		for (size_t i{ 1 }; i <= stacks; ++i)
+		{
+			out << (i > 1 ? " " : "") << ' ' << i << ' ';
+		}
+		out << "\n\n";
+
+		std::array<size_t, stacks> heights;
+		std::transform(crates.begin(), crates.end(), heights.begin(), [](const std::string &stack) { return stack.size(); });
+
+		const size_t moves{ generate::count(502, scale) };
+		for (size_t i{ 0 }; i < moves; ++i)
+		{
+			size_t from;
+			do
+			{
+				from = random.index(stacks);
+			} while (heights[from] < 2);
+
+			size_t to{ (from + 1 + random.index(stacks - 1)) % stacks };
+			const size_t count{ 1 + random.index(std::min<size_t>(heights[from] - 1, 8)) };
+			heights[from] -= count;
+			heights[to] += count;
+
+			out << "move " << count << " from " << from + 1 << " to " << to + 1 << '\n';
+		}
 	}
+};
 
-	return 0;
+} // namespace day05
 
-}
+AOC_MAIN(day05)
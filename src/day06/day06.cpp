@@ -5,9 +5,16 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <string_view>
 
+#include "arena.h"
+#include "generate.h"
+#include "registry.h"
 #include "utils.h"
 
+namespace day06
+{
+
 // Really kinda silly but I had fun with it
 class CharsCircular
 {
@@ -17,7 +24,7 @@ public:
 		Node** currptr{ &curr };
 		for(size_t i{ 0 }; i < size; ++i)
 		{
-			*currptr = new Node;
+			*currptr = m_nodes.make<Node>();
 			currptr = &((*currptr)->next);
 		}
 		*currptr = curr; // Final element should be pointing back at the first
@@ -28,23 +35,12 @@ public:
 		Node** currptr{ &curr };
 		for(size_t i{ 0 }; i < size; ++i)
 		{
-			*currptr = new Node(chars[i]);
+			*currptr = m_nodes.make<Node>(chars[i]);
 			currptr = &((*currptr)->next);
 		}
 		*currptr = curr; // Final element should be pointing back at the first 
 	}
 
-	~CharsCircular()
-	{
-		Node* start{ curr };
-		do 
-		{
-			Node* temp{ curr };
-			curr = curr->next;
-			delete temp;
-		} while(curr != start);
-	}
-
 	void replace(char ch)
 	{
 		curr->ch = ch;
@@ -53,7 +49,7 @@ public:
 
 	void insert(char ch)
 	{
-		curr->next = new Node(ch, curr->next);
+		curr->next = m_nodes.make<Node>(ch, curr->next);
 	}
 
 	void print()
@@ -107,6 +103,8 @@ private:
 		Node* next;
 	};
 
+	// All the nodes go when the arena does, no walking round the circle deleting them
+	mem::Arena m_nodes{ 256 };
 	Node* curr;
 	size_t size{ 4 };
 };
@@ -207,22 +205,25 @@ namespace Puzzle2
 	}
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
+	// Only a, b and c until near the end, so there's no marker until the 14 different letters there
+	void input(std::ostream &out, double scale, generate::Random &random)
+	{
+		const size_t length{ generate::count(4096, scale, 30) };
 
-	const std::string input{ utils::inputFile(__FILE__) };
+		std::string signal(length, 'a');
+		for (char &ch : signal)
+		{
+			ch = random.pick("abc");
+		}
+		const std::string_view marker{ "defghijklmnopq" };
+		std::copy(marker.begin(), marker.end(), signal.end() - 10 - static_cast<std::ptrdiff_t>(marker.length()));
 
-	try
-	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
-	{
-		std::cerr << e.what() << '\n';
+		out << signal << '\n';
 	}
+};
 
-	return 0;
+} // namespace day06
 
-}
+AOC_MAIN(day06)
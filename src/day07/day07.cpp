@@ -7,17 +7,26 @@
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
+#include "arena.h"
 #include "debug.h"
+#include "generate.h"
+#include "registry.h"
 #include "utils.h"
 
+namespace day07
+{
+
 class DirTree
 {
 public:
-    DirTree() : m_root{ new Dir{ "/", nullptr } }, m_pwd{ m_root } {}
-    ~DirTree() { delete m_root; }
+    // Every Dir and File, and their maps' nodes, are in m_arena so there's nothing to delete one at a time
+    DirTree() : m_root{ m_arena.make<Dir>("/", nullptr, &m_arena) }, m_pwd{ m_root } {}
 
     void parseInput(const std::string &line)
     {
@@ -121,32 +130,22 @@ private:
     };
     struct Dir : public File
     {
-        Dir(const std::string &_name, Dir *_parent) : File{ _name }, parent{ _parent } {}
-        ~Dir()
-        {
-            for (auto file : files)
-            {
-                // std::cout << "deleting: " << file.first << '\n';
-                delete file.second;
-            }
-            for (auto dir : directories)
-            {
-                // std::cout << "deleting: " << dir.first << '\n';
-                delete dir.second;
-            }
-        }
+        Dir(const std::string &_name, Dir *_parent, std::pmr::memory_resource *arena) :
+            File{ _name }, parent{ _parent }, directories{ arena }, files{ arena } {}
 
         // std::string name;
         Dir* parent;
         // std::map<std::string &, File*> children; // Dir inherits from Files so they could be in one container
         // I don't think map was the right choice
-        std::map<const std::string, Dir*> directories;
+        // std::less<> so they can be looked up by std::string without making a pmr one
+        std::pmr::map<std::pmr::string, Dir*, std::less<>> directories;
         
-        std::map<const std::string, File*> files;
+        std::pmr::map<std::pmr::string, File*, std::less<>> files;
 
         // int size{ -1 }; // Sentinel value suggesting size hasn't been calculated
     };
 
+    mem::Arena m_arena; // Before m_root, which is made in it
     Dir* m_root;
     Dir* m_pwd;
     
@@ -172,9 +171,9 @@ private:
             return m_pwd;
         }
 
-        if (m_pwd->directories.contains(_name))
+        if (auto dir{ m_pwd->directories.find(std::string_view{ _name }) }; dir != m_pwd->directories.end())
         {
-            m_pwd = m_pwd->directories[_name];
+            m_pwd = dir->second;
             return m_pwd;
         }
         else
@@ -186,7 +185,7 @@ private:
 
     Dir* mkdir(const std::string &_name)
     {
-        if (m_pwd->directories.contains(_name))
+        if (m_pwd->directories.contains(std::string_view{ _name }))
         {
             std::cout << "directory already exists: " << _name << '\n'; 
             return cd(_name);
@@ -198,8 +197,8 @@ private:
             return cd(_name);
         }
 
-        Dir* newdir{ new Dir{ _name, m_pwd } };
-        m_pwd->directories[newdir->name] = newdir;
+        Dir* newdir{ m_arena.make<Dir>(_name, m_pwd, &m_arena) };
+        m_pwd->directories.emplace(newdir->name, newdir);
 
         m_allDirectories.push_back(newdir);
          
@@ -214,20 +213,20 @@ private:
             return nullptr; // Maybe return null?
         }
 
-        if (m_pwd->files.contains(name))
+        if (m_pwd->files.contains(std::string_view{ name }))
         {
             std::cout << "file already exists: " << name << '\n'; 
             return nullptr;
         }
 
-        auto newfile{ new File(name, size) };
+        auto newfile{ m_arena.make<File>(name, size) };
 
-        m_pwd->files[newfile->name] = newfile;
+        m_pwd->files.emplace(newfile->name, newfile);
         // m_pwd->size += size;
 
         addToSize(size, m_pwd);
         
-        return m_pwd->files[name];
+        return newfile;
     }
 
     void addToSize(const int size, Dir* const dir) const
@@ -301,22 +300,77 @@ namespace Puzzle2
 	}
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
+    struct Dir
+    {
+        std::string name;
+        std::vector<size_t> children;
+    };
 
-	const std::string input{ utils::inputFile(__FILE__) };
+    std::string randomName(generate::Random &random)
+    {
+        std::string name(static_cast<size_t>(random.range(3, 8)), 'a');
+        for (char &ch : name)
+        {
+            ch = random.pick("abcdefghijklmnopqrstuvwxyz");
+        }
+        return name;
+    }
 
-	try
-	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
-	{
-		std::cerr << e.what() << '\n';
-	}
+    // cd into each directory, ls, then its subdirectories, then cd back out
+    void walk(std::ostream &out, const std::vector<Dir> &dirs, size_t at, generate::Random &random)
+    {
+        out << "$ cd " << dirs[at].name << "\n$ ls\n";
+
+        const int files{ random.range(0, 4) };
+        for (int i{ 0 }; i < files; ++i)
+        {
+            out << random.range(1000, 300000) << ' ' << randomName(random);
+            if (random.chance(0.5))
+            {
+                out << '.' << randomName(random).substr(0, 3);
+            }
+            out << '\n';
+        }
+        for (size_t child : dirs[at].children)
+        {
+            out << "dir " << dirs[child].name << '\n';
+        }
+
+        for (size_t child : dirs[at].children)
+        {
+            walk(out, dirs, child, random);
+            out << "$ cd ..\n";
+        }
+    }
+
+    // A tree of directories, new ones often going under the one made just before so some branches get deep
+    void input(std::ostream &out, double scale, generate::Random &random)
+    {
+        const size_t count{ generate::count(180, scale) };
+        const size_t maxDepth{ 20 + static_cast<size_t>(std::log2(static_cast<double>(count))) };
+
+        std::vector<Dir> dirs{ { "/", {} } };
+        std::vector<size_t> depths{ 0 };
+        while (dirs.size() < count)
+        {
+            size_t parent{ random.index(dirs.size()) };
+            if (random.chance(0.4) && depths.back() < maxDepth)
+            {
+                parent = dirs.size() - 1;
+            }
+
+            // Numbered so siblings never share a name
+            dirs.push_back({ randomName(random) + std::to_string(dirs[parent].children.size()), {} });
+            depths.push_back(depths[parent] + 1);
+            dirs[parent].children.push_back(dirs.size() - 1);
+        }
+
+        walk(out, dirs, 0, random);
+    }
+};
 
-	return 0;
+} // namespace day07
 
-}
+AOC_MAIN(day07)
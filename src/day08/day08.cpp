@@ -1,6 +1,7 @@
 // --- Day 8: Treetop Tree House ---
 
 #include <array>
+#include <cmath>
 #include <exception>
 #include <filesystem>
 #include <fstream>
@@ -8,86 +9,36 @@
 #include <string>
 #include <vector>
 
+#include "bitgrid.h"
 #include "debug.h"
+#include "generate.h"
+#include "grid.h"
+#include "registry.h"
 #include "utils.h"
 
-void checkRow(const std::vector<std::string> &map, std::vector<std::vector<bool>> &visibility, const size_t row)
+namespace day08
 {
-    size_t col{ 0 };
-    char largest{ map[row][col] };
-    size_t reverseEnd{ 1 };
 
-    while(++col < map[row].length() - 1)
-    {
-        if (map[row][col] > largest)
-        {
-            visibility[row][col] = true;
-            reverseEnd = col;
-
-            if (map[row][col] == '9')
-            {
-                break;
-            }
-
-            largest = map[row][col];
-        }
-    }
-
-    col = map[row].length() - 1;
-    largest = map[row][col];
-
-    while (--col > reverseEnd)
-    {
-        if (map[row][col] > largest)
-        {
-            visibility[row][col] = true;
-
-            if (map[row][col] == '9')
-            {
-                break;
-            }
+using TreeMap = Grid2D<char>;
 
-            largest = map[row][col];
-        }
-    }
-}
-
-void checkCol(const std::vector<std::string> &map, std::vector<std::vector<bool>> &visibility, const size_t col)
+// Marks every tree in a line that's taller than all the trees before it, looking from start in direction step
+void checkLine(const TreeMap &map, BitGrid &visibility, Vector2d start, const Vector2d &step)
 {
-    size_t row{ 0 };
-    char largest{ map[row][col] };
-    size_t reverseEnd{ 1 };
+    char largest{ map[start] };
 
-    while(++row < map.size() - 1)
+    // The padding's '\0', so the edge of the map ends the line
+    for (Vector2d tree{ start + step }; map[tree]; tree += step)
     {
-        if (map[row][col] > largest)
+        if (map[tree] > largest)
         {
-            visibility[row][col] = true;
-            reverseEnd = row;
+            visibility.set(tree.x, tree.y);
 
-            if (map[row][col] == '9')
+            if (map[tree] == '9')
             {
                 break;
             }
 
-            largest = map[row][col];
-        }
-    }
-
-    row = map.size() - 1;
-    largest = map[row][col];
-
-    while (--row > reverseEnd)
-    {
-        if (map[row][col] > largest)
-        {
-            visibility[row][col] = true;
-            if (map[row][col] == '9')
-            {
-                break;
-            }
-            largest = map[row][col];
-
+            largest = map[tree];
         }
     }
 }
@@ -96,214 +47,90 @@ namespace Puzzle1
 {
 	void solve(const std::string& infile)
 	{
-		std::ifstream inf { infile };
-
-		if (!inf)
-		{
-			throw std::runtime_error("could not open " + infile);
-		}
-
-        const std::vector<std::string> trees{ utils::bufferLines(infile) };
+        const TreeMap trees{ TreeMap::fromLines(utils::bufferLines(infile), 1) };
 
         // I can't think how to not count trees twice when checking rows then columns
-        // So we're storing whether each tree is visible in a vector with matching row/col indices
-        std::vector<std::vector<bool>> treeVisibility{ trees.size(), std::vector(trees[0].length(), false) };
-        
-        for (auto &row : treeVisibility)
+        // So we're storing whether each tree is visible in a grid of bits the same shape as the trees
+        // The trees around the edge can always be seen
+        BitGrid treeVisibility{ trees.width(), trees.height() };
+        for (int col{ 0 }; col < trees.width(); ++col)
         {
-            *(row.begin()) = true;
-            *(row.rbegin()) = true;
+            treeVisibility.set(col, 0);
+            treeVisibility.set(col, trees.height() - 1);
         }
-
-        *(treeVisibility.begin()) = std::vector<bool>( trees[0].length(), true );
-        *(treeVisibility.rbegin()) = *(treeVisibility.begin());
-
-        for (size_t col{ 0 }; col < trees[0].length(); ++col)
+        for (int row{ 0 }; row < trees.height(); ++row)
         {
-            checkCol(trees, treeVisibility, col);
+            treeVisibility.set(0, row);
+            treeVisibility.set(trees.width() - 1, row);
         }
-        int count{ 0 };
-        for (size_t row{ 0 }; row < trees.size(); ++row)
-        {
-            checkRow(trees, treeVisibility, row);
-
-            for (size_t i{ 0 }; i < treeVisibility[0].size(); ++i)
-            {
-                if (treeVisibility[row][i])
-                {
-                    ++count;
-                    DP(trees[row][i]);
-                }
-                else
-                {
-                    DP(' ');
-                }
-            }
-            DL("");
-
-        }
-        
-        utils::printAnswer("total visible trees: ", count);
-
-	}
-};
 
-namespace Puzzle2
-{
-    using TreeMap = std::vector<std::string>;
-    using TreeRow = std::string;
-
-    int treeScoreIterators(const TreeMap &map, TreeMap::const_iterator treerow, TreeRow::const_iterator tree)
-    {
-        const char treeHeight{ *tree };
-        int score{ 0 };
-
-        auto comptree{ tree };
-
-        while (++comptree != (*treerow).end())
-        {
-            ++score;
-
-            if (*comptree >= treeHeight)
-            {
-                break;
-            }
-        }
-
-        comptree = tree;
-        int visible { 0 };
-        
-        while (--comptree >= (*treerow).begin())
+        for (int col{ 0 }; col < trees.width(); ++col)
         {
-            ++visible;
-
-            if (*comptree >= treeHeight)
-            {
-                break;
-            }
+            checkLine(trees, treeVisibility, { col, 0 }, { 0, 1 });
+            checkLine(trees, treeVisibility, { col, trees.height() - 1 }, { 0, -1 });
         }
-
-        score *= visible;
-
-        auto row{ treerow };
-        visible = 0;
-
-        const auto treeOffset{ tree - (*treerow).begin() };
-
-        while (++row != map.end())
+        for (int row{ 0 }; row < trees.height(); ++row)
         {
-            ++visible;
-
-            if ((*row)[static_cast<size_t>(treeOffset)] >= treeHeight)
-            {
-                break;
-            }
+            checkLine(trees, treeVisibility, { 0, row }, { 1, 0 });
+            checkLine(trees, treeVisibility, { trees.width() - 1, row }, { -1, 0 });
         }
 
-        score *= visible;
-
-        row = treerow;
-        visible = 0;
-
-        while (--row != map.begin() - 1)
+        for (int row{ 0 }; row < trees.height(); ++row)
         {
-            ++visible;
-
-            if ((*row)[static_cast<size_t>(treeOffset)] >= treeHeight)
+            for (int col{ 0 }; col < trees.width(); ++col)
             {
-                break;
+                DP(treeVisibility.test(col, row) ? trees.at(col, row) : ' ');
             }
+            DL("");
         }
 
-        score *= visible;
+        // A popcount a word at a time
+        utils::printAnswer("total visible trees: ", treeVisibility.count());
 
-        return score;
-    }
+	}
+};
 
-    int treeScore(const std::vector<std::string> &map, const size_t treerow, const size_t treecol)
+namespace Puzzle2
+{
+    // How many trees can be seen in each direction multiplied together, walking by flat index
+    int treeScore(const TreeMap &map, const size_t tree, const std::array<std::ptrdiff_t, 4> &directions)
     {
-        const char treeHeight{ map[treerow][treecol] };
-        int score{ 0 };
-
-        int col{ static_cast<int>(treecol) };
+        const char treeHeight{ map[tree] };
+        int score{ 1 };
 
-        while (++col < static_cast<int>(map[treerow].length()))
+        for (const auto direction : directions)
         {
-            ++score;
+            int visible{ 0 };
 
-            if (map[treerow][static_cast<size_t>(col)] >= treeHeight)
+            // Stop at the padding ('\0') round the edge
+            for (size_t comptree{ tree + static_cast<size_t>(direction) }; map[comptree]; comptree += static_cast<size_t>(direction))
             {
-                break;
-            }
-        }
-
-        col = treecol;
-        int visible { 0 };
-        
-        while (--col >= 0)
-        {
-            ++visible;
-
-            if (map[treerow][static_cast<size_t>(col)] >= treeHeight)
-            {
-                break;
-            }
-        }
-
-        score *= visible;
+                ++visible;
 
-        int row{ static_cast<int>(treerow) };
-        visible = 0;
-
-        while (++row < static_cast<int>(map.size()))
-        {
-            ++visible;
-
-            if (map[static_cast<size_t>(row)][treecol] >= treeHeight)
-            {
-                break;
+                if (map[comptree] >= treeHeight)
+                {
+                    break;
+                }
             }
-        }
-
-        score *= visible;
 
-        row = treerow;
-        visible = 0;
-
-        while (--row >= 0)
-        {
-            ++visible;
-
-            if (map[static_cast<size_t>(row)][treecol] >= treeHeight)
-            {
-                break;
-            }
+            score *= visible;
         }
 
-        score *= visible;
-
         return score;
-
     }
 
 	void solve(const std::string& infile)
 	{
-		std::ifstream inf{ infile };
-
-		if (!inf)
-		{
-			throw std::runtime_error("could not open " + infile);
-		}
-
-        const TreeMap trees{ utils::bufferLines(infile) };
+        const TreeMap trees{ TreeMap::fromLines(utils::bufferLines(infile), 1) };
+        const auto directions{ trees.offsets(grid::orthogonal) };
 
         int highScore{ 0 };
 
-        for (auto rowiter{ trees.begin() }; rowiter != trees.end(); ++rowiter)
+        for (int row{ 0 }; row < trees.height(); ++row)
         {
-            for (auto treeiter{ (*rowiter).begin() }; treeiter != (*rowiter).end(); ++treeiter)
+            for (int col{ 0 }; col < trees.width(); ++col)
             {
-                auto score{ treeScoreIterators(trees, rowiter, treeiter) };
+                auto score{ treeScore(trees, trees.index(col, row), directions) };
                 highScore = score > highScore ? score : highScore;
             }
         }
@@ -313,22 +140,24 @@ namespace Puzzle2
 	}
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
-
-	const std::string input{ utils::inputFile(__FILE__) };
-
-	try
-	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
-	{
-		std::cerr << e.what() << '\n';
-	}
+    // Square grid of tree heights, side growing with the square root of scale so the tree count goes up with it
+    void input(std::ostream &out, double scale, generate::Random &random)
+    {
+        const size_t side{ generate::count(99, std::sqrt(scale), 2) };
+        std::string row(side, '0');
+        for (size_t y{ 0 }; y < side; ++y)
+        {
+            for (char &tree : row)
+            {
+                tree = static_cast<char>('0' + random.range(0, 9));
+            }
+            out << row << '\n';
+        }
+    }
+};
 
-	return 0;
+} // namespace day08
 
-}
+AOC_MAIN(day08)
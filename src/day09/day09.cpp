@@ -8,68 +8,24 @@
 #include <fstream>
 #include <iostream>
 #include <map>
-#include <set>
 #include <string>
+#include <unordered_set>
 #include <utility>
 
+#include "frames.h"
+#include "generate.h"
 #include "image.h"
+#include "registry.h"
 #include "utils.h"
+#include "vector2d.h"
 
-struct Coord
+namespace day09
 {
-	Coord() = default;
-	Coord(int _x, int _y) : x{ _x }, y{ _y } {}
 
-	int x{ 0 };
-	int y{ 0 };
-
-	// Overloading specific operators that should help with the tail function
-	friend Coord operator+(const Coord& a, const Coord& b) { return { a.x + b.x, a.y + b.y }; }
-	friend Coord operator-(const Coord& a, const Coord& b) { return { a.x - b.x, a.y - b.y }; }
-	friend bool operator==(const Coord& a, const Coord& b) { return a.x == b.x && a.y == b.y; }
-	friend bool operator<(const Coord&a, const Coord& b) { return a.x < b.x || ( a.x == b.x && a.y < b.y ); }
-	friend bool operator>(const Coord&a, const Coord& b) { return a.x > b.x || ( a.x == b.x && a.y > b.y ); }
-
-	friend Coord operator+(const Coord& a, const int& b) { return { a.x + b, a.y + b }; }
-	// Int comparisons not necessarily intuitive but useful for the checks we use
-	friend bool operator==(const Coord& a, const int& b) { return a.x == b && a.y == b; }
-	friend bool operator!=(const Coord& a, const int& b) { return !(a.x == b && a.y == b); }
-	friend bool operator>(const Coord& a, const int& b) { return a.x > b || a.y > b; }
-
-	explicit operator bool () const {return !(x == 0 && y == 0); }
-
-	Coord& operator+=(const Coord& b)
-	{
-		this->x += b.x;
-		this->y += b.y;
-		return *this;
-	}
-	Coord& operator+=(const int& b)
-	{
-		this->x += b;
-		this->y += b;
-		return *this;
-	}
-	
-	friend Coord operator/(const Coord& a, const Coord& b)
-	{
-		int divx{ b.x == 0 ? 1 : b.x };
-		int divy{ b.y == 0 ? 1 : b.y };
-		return { a.x / divx, a.y / divy };
-	}
-
-	Coord abs() { return { std::abs(x), std::abs(y) }; }
-	
-};
+using Coord = Vector2d;
 
 using Rope = std::array<Coord, 20>;
 
-std::ostream& operator<<(std::ostream& os, const Coord& coord)
-{
-    os << "{ " << coord.x << ", " << coord.y << " }";
-    return os;
-}
-
 std::pair<Coord, int> parseLine(const std::string &line)
 {
 	int dist{ std::atoi(line.data() + 2) };
@@ -90,9 +46,9 @@ Coord moveTail(const Coord &head, const Coord & tail)
 	auto distMag{ dist.abs() };
 
 	// Keep direction, reduce any x or y movement to at most 1
-	if (distMag > 1)
+	if (distMag.x > 1 || distMag.y > 1)
 	{	
-		return dist / distMag;
+		return dist.sign();
 	}
 
 	return { 0, 0 };
@@ -110,7 +66,7 @@ bool propagateRopeMove(Coord* knotParent, const Coord* end)
 	auto dist{ *knotParent - *(knotParent + 1) };
 
 	// Stop propogation, return false to signify no need to update list of visited coords
-	if (!dist)
+	if (dist == Coord{ 0, 0 })
 	{
 		return false;
 	}
@@ -118,9 +74,9 @@ bool propagateRopeMove(Coord* knotParent, const Coord* end)
 	auto distMag{ dist.abs() };
 
 	// Keep direction, reduce any x or y movement to at most 1
-	if (distMag > 1)
+	if (distMag.x > 1 || distMag.y > 1)
 	{	
-		*(knotParent + 1) += dist / distMag;
+		*(knotParent + 1) += dist.sign();
 	}
 
 	return propagateRopeMove(++knotParent, end);
@@ -133,172 +89,33 @@ bool moveRope(Coord* head, const Coord *end, const Coord &move)
 	return propagateRopeMove(head, end);
 }
 
-void drawRope(Coord* head, Coord* end)
+// One frame of the rope with the origin in the middle, anything further out than 150 x 80 isn't drawn
+void drawRope(const Coord* head, const Coord* end, frames::Sink &sink)
 {
-	static int calls{ 0 };
-
-	Coord min{ *head };
-	Coord max{ *head };
-
-	std::for_each(head + 1, end, 
-		[&min, &max](const Coord &knot)
+	sink.frame([head, end](Image8 &canvas)
 		{
-			if (knot.x > max.x)
-			{
-				max.x = knot.x;
-			}
-			else if (knot.x < min.x)
-			{
-				min.x = knot.x;
-			}
+			const Coord min{ -(canvas.width() / 2), -(canvas.height() / 2) };
+			canvas.fill(Color{});
 
-			if (knot.y > max.y)
+			for (int y{ 0 }; y < canvas.height(); ++y)
 			{
-				max.y = knot.y;
+				canvas.setColor(Color{ 0.f, 0.f, 0.25f }, -min.x, y);
 			}
-			else if (knot.y < min.y)
+			for (int x{ 0 }; x < canvas.width(); ++x)
 			{
-				min.y = knot.y;
+				canvas.setColor(Color{ 0.f, 0.f, 0.25f }, x, -min.y);
 			}
-		});
-
-	Coord span{ (max - min) + 1 };
-
-	std::string blank( static_cast<size_t>(span.x), ' ' );
-	std::vector<std::string> grid{ static_cast<size_t>(span.y), blank };
-
-	/*
-	for (int i{ 0 }; &(head[i]) != end; ++i)
-	{
-		char ch;
-		if (i == 0)
-		{
-			ch = 'H';
-		}
-		else if (&(head[i]) == end - 1)
-		{
-			ch = 'T';
-		}
-		else
-		{
-			ch = std::to_string(i + 1)[0];
-		}
-		
-		auto normalised{ head[i] - min };
-		auto &ingrid{ grid[static_cast<size_t>(normalised.y)][static_cast<size_t>(normalised.x)] };
-		ingrid = ingrid == ' ' ? ch : ingrid;
-	}
 
-	for (auto &line : grid)
-	{
-		std::cout << line << '\n';
-	}
-
-	std::cout << '\n';
-	*/
-
-
-	//// Well that was fun
-	
-
-	//int canvasWidth{ 640 };
-	//int canvasHeight{ 480 };
-	//Coord origin{ 320, 240 };
-
-	//Image bmp{ canvasWidth, canvasHeight, Color(1.f, 1.f, 1.f)};
-
-	//for (int i{ 0 }; &(head[i]) != end; ++i)
-	//{
-	//	auto pixel{ origin + head[i] };
-	//	if (pixel.x < 0 || pixel.y < 0 || pixel.x >= canvasWidth || pixel.y >= canvasHeight)
-	//	{
-	//		continue;
-	//	}
-	//	bmp.setColor(Color{ 1.f, 0.f, 0.f }, pixel.x, pixel.y);
-	//}
-
-
-	//Image bmp{ static_cast<int>(grid[0].length()), static_cast<int> (grid.size()) };
-	//for (size_t y{ 0 }; y < grid.size(); ++y)
-	//{
-	//	for (size_t x{ 0 }; x < grid[0].length(); ++x)
-	//	{
-	//		if (grid[y][x] != ' ')
-	//		{
-	//			bmp.setColor(Color(1.f, 0.f, 0.f), static_cast<int>(x), static_cast<int>(y));
-	//		}
-	//	}
-	//}
-
-	
-	//min.x = min.x > 0 ? 0 : min.x;
-	//min.y = min.y > 0 ? 0 : min.y;
-	//max.x = max.x < 0 ? 0 : max.x;
-	//max.y = max.y < 0 ? 0 : max.y;
-
-
-	//min.x = min.x > 0 ? -1 * max.x : min.x;
-	//min.y = min.y > 0 ? -1 * max.y : min.y;
-	//max.x = max.x < 0 ? -1 * min.x : max.x;
-	//max.y = max.y < 0 ? -1 * min.y : max.y;
-
-	auto minabs = min.abs();
-	auto maxabs = max.abs();
-
-	max.x = std::max(minabs.x, maxabs.x);
-	min.x = std::max(minabs.x, maxabs.x) * -1;
-	max.y = std::max(minabs.y, maxabs.y);
-	min.y = std::max(minabs.y, maxabs.y) * -1;
-
-	
-	//static Coord largestSpan{ 0, 0 };
-	span = (max - min) + 1;
-
-	//largestSpan.x = span.x > largestSpan.x ? span.x : largestSpan.x;
-	//largestSpan.y = span.y > largestSpan.y ? span.y : largestSpan.y;
-
-	// Want to keep the origin at the centre really
-	span = { 301, 161 };
-	min.x = -150;
-	min.y = -80;
-	max.x = 150;
-	max.y = 80;
-
-	if (++calls < 500)
-	{
-		std::string imagename{ "./images/rope/rope_" + std::to_string(calls) + ".bmp" };
-		Image bmp{ span.x, span.y };
-
-		std::cout << imagename << " = span: " << span << '\n';
-
-		for (int y{ 0 }; y < span.y; ++y)
-		{
-			int originx{ 0 - min.x };
-			bmp.setColor(Color{ 0.f, 0.f, 0.25f }, originx, y);
-		}
-
-		for (int x{ 0 }; x < span.x; ++x)
-		{
-			int originy{ 0 - min.y };
-			bmp.setColor(Color{ 0.f, 0.f, 0.25f }, x, originy);
-		}
-
-		for (int i{ 0 }; &(head[i]) != end; ++i)
-		{
-			auto pixel{ head[i] - min };
-			std::cout << pixel << ' ';
-			if (pixel.x < 0 || pixel.y < 0 || pixel.x >= span.x || pixel.y >= span.y)
+			for (const Coord* knot{ head }; knot != end; ++knot)
 			{
-				continue;
+				const auto pixel{ *knot - min };
+				if (pixel.x < 0 || pixel.y < 0 || pixel.x >= canvas.width() || pixel.y >= canvas.height())
+				{
+					continue;
+				}
+				canvas.setColor(Color{ 1.f, 0.f, 0.f }, pixel.x, pixel.y);
 			}
-			bmp.setColor(Color{ 1.f, 0.f, 0.f }, pixel.x, pixel.y);
-		}
-		std::cout << '\n';
-
-		bmp.save(imagename.data());
-
-	}
-
+		});
 }
 
 namespace Puzzle1
@@ -315,7 +132,7 @@ namespace Puzzle1
 
 		Coord tail{ 0, 0 };
 		Coord head{ 0, 0 };
-		std::set<Coord> visited{ tail };
+		std::unordered_set<Coord> visited{ tail };
 
 		while(inf)
 		{
@@ -329,7 +146,7 @@ namespace Puzzle1
 
 				auto tailmove{ moveTail(head, tail) };
 
-				if (tailmove != 0)
+				if (tailmove != Coord{ 0, 0 })
 				{
 					tail += tailmove;
 					visited.insert(tail);
@@ -354,7 +171,9 @@ namespace Puzzle2
 		}
 
 		Rope rope;
-		std::set<Coord> visited{ rope[0] };
+		std::unordered_set<Coord> visited{ rope[0] };
+
+		auto sink{ frames::record("rope", 301, 161) }; // With --frames
 
 		while(inf)
 		{
@@ -376,8 +195,10 @@ namespace Puzzle2
 
 				--moves.second;
 
-				// Careful uncommenting this, it creates a series of bitmaps!
-				// drawRope(&(*rope.begin()), ptr2);
+				if (sink)
+				{
+					drawRope(&(*rope.begin()), ptr2, *sink);
+				}
 			}
 		}
 
@@ -385,22 +206,18 @@ namespace Puzzle2
 	}
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
-
-	const std::string input{ utils::inputFile(__FILE__) };
-
-	try
-	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
+	void input(std::ostream &out, double scale, generate::Random &random)
 	{
-		std::cerr << e.what() << '\n';
+		const size_t moves{ generate::count(2000, scale) };
+		for (size_t i{ 0 }; i < moves; ++i)
+		{
+			out << random.pick("UDLR") << ' ' << random.range(1, 19) << '\n';
+		}
 	}
+};
 
-	return 0;
+} // namespace day09
 
-}
+AOC_MAIN(day09)
@@ -6,20 +6,30 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <string_view>
 
 #include "debug.h"
+#include "generate.h"
+#include "registry.h"
+#include "scan.h"
+#include "stream.h"
 #include "utils.h"
 
+namespace day10
+{
+
+// addx's amount, 0 for noop
+int parseInstruction(std::string_view instr)
+{
+	return instr.length() > 4 && instr[3] == 'x' ? scan::toInt(instr.substr(4)) : 0;
+}
+
 namespace Puzzle1
 {
 	void solve(const std::string& infile)
 	{
-		std::ifstream inf { infile };
-
-		if (!inf)
-		{
-			throw std::runtime_error("could not open " + infile);
-		}
+		// Only the first 240 cycles are read, the rest of the file never is
+		stream::Records instructions{ infile, parseInstruction };
 
 		int cycle{ 0 };
 		int x{ 1 };
@@ -36,15 +46,10 @@ namespace Puzzle1
 			// If not already executing an instruction
 			if (!addqueue)
 			{
-				std::string instr;
-				if (inf)
+				int add{ 0 };
+				if (instructions.next(add))
 				{
-					std::getline(inf, instr);
-				}
-
-				if (instr.length() && instr[3] == 'x')
-				{
-					addqueue = std::atoi(instr.data() + 4);
+					addqueue = add;
 				}
 			}
 			else
@@ -72,12 +77,8 @@ namespace Puzzle2
 {
 	void solve(const std::string& infile)
 	{
-		std::ifstream inf { infile };
-
-		if (!inf)
-		{
-			throw std::runtime_error("could not open " + infile);
-		}
+		// Only the first 240 cycles are read, the rest of the file never is
+		stream::Records instructions{ infile, parseInstruction };
 
 		int cycle{ 0 };
 		int x{ 1 };
@@ -113,15 +114,10 @@ namespace Puzzle2
 			// If not already executing an instruction
 			if (!addqueue)
 			{
-				std::string instr;
-				if (inf)
+				int add{ 0 };
+				if (instructions.next(add))
 				{
-					std::getline(inf, instr);
-				}
-
-				if (instr.length() && instr[3] == 'x')
-				{
-					addqueue = std::atoi(instr.data() + 4);
+					addqueue = add;
 				}
 			}
 			else
@@ -141,22 +137,34 @@ namespace Puzzle2
 	}
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
+	// The puzzle only ever reads the first 240 cycles, so anything past that is only parsed (if at all)
+	void input(std::ostream &out, double scale, generate::Random &random)
+	{
+		const size_t instructions{ generate::count(147, scale) };
+		int x{ 1 };
+		for (size_t i{ 0 }; i < instructions; ++i)
+		{
+			if (random.chance(0.4))
+			{
+				out << "noop\n";
+				continue;
+			}
 
-	const std::string input{ utils::inputFile(__FILE__) };
+			// Keep the sprite somewhere near the screen
+			int add;
+			do
+			{
+				add = random.range(-15, 15);
+			} while (!add || x + add < -5 || x + add > 45);
+			x += add;
 
-	try
-	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
-	{
-		std::cerr << e.what() << '\n';
+			out << "addx " << add << '\n';
+		}
 	}
+};
 
-	return 0;
+} // namespace day10
 
-}
+AOC_MAIN(day10)
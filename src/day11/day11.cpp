@@ -1,5 +1,8 @@
 // --- Day 11: Monkey in the Middle ---
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <deque>
 #include <exception>
 #include <filesystem>
@@ -9,8 +12,13 @@
 #include <string>
 #include <vector>
 
+#include "generate.h"
+#include "registry.h"
 #include "utils.h"
 
+namespace day11
+{
+
 // Initially tried to brute force with unsigned long long
 // But the numbers were TOO big and we had to puzzle out some modulo and 
 // lowest common denominator shenanigans
@@ -345,6 +353,8 @@ namespace Puzzle1
 			throw std::runtime_error("could not open " + infile);
 		}
 
+		MonkeyFactory::reset(); // Monkeys are static, so clear out any from an earlier run
+
 		while(inf)
 		{
 			auto monkeyInfo{ utils::getLinesUntil(inf,
@@ -381,6 +391,8 @@ namespace Puzzle2
 			throw std::runtime_error("could not open " + infile);
 		}
 
+		MonkeyFactory::reset(); // Monkeys are static, so clear out any from an earlier run
+
 		while(inf)
 		{
 			auto monkeyInfo{ utils::getLinesUntil(inf,
@@ -413,22 +425,54 @@ namespace Puzzle2
 	}
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
+	// More monkeys and more items each as scale goes up, the test divisors are all primes
+	// so their lcm (which worry levels are kept under) stays small enough for old * old
+	void input(std::ostream &out, double scale, generate::Random &random)
+	{
+		const std::array<int, 9> primes{ 2, 3, 5, 7, 11, 13, 17, 19, 23 };
+		const size_t monkeys{ std::min<size_t>(generate::count(8, std::sqrt(scale), 2), 100) };
+		const size_t squarer{ random.index(monkeys) }; // Just the one, like the puzzle
 
-	const std::string input{ utils::inputFile(__FILE__) };
+		for (size_t monkey{ 0 }; monkey < monkeys; ++monkey)
+		{
+			if (monkey)
+			{
+				out << '\n';
+			}
+			out << "Monkey " << monkey << ":\n  Starting items: ";
 
-	try
-	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
-	{
-		std::cerr << e.what() << '\n';
+			const size_t items{ generate::count(4.5, std::sqrt(scale) * (0.5 + static_cast<double>(random.range(0, 100)) / 100.0)) };
+			for (size_t i{ 0 }; i < items; ++i)
+			{
+				out << (i ? ", " : "") << random.range(50, 99);
+			}
+
+			out << "\n  Operation: new = old ";
+			if (monkey == squarer)
+				out << "* old";
+			else if (random.chance(0.3))
+				out << "* " << random.range(2, 19);
+			else
+				out << "+ " << random.range(1, 8);
+
+			// Two different monkeys, neither of them this one
+			const auto other{ [&]() { return (monkey + 1 + random.index(monkeys - 1)) % monkeys; } };
+			const size_t ifTrue{ other() };
+			size_t ifFalse{ other() };
+			while (ifFalse == ifTrue && monkeys > 2)
+			{
+				ifFalse = other();
+			}
+
+			out << "\n  Test: divisible by " << primes[monkey % primes.size()]
+				<< "\n    If true: throw to monkey " << ifTrue
+				<< "\n    If false: throw to monkey " << ifFalse << '\n';
+		}
 	}
+};
 
-	return 0;
+} // namespace day11
 
-}
+AOC_MAIN(day11)
@@ -1,46 +1,40 @@
 // --- Day 12: Hill Climbing Algorithm ---
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <deque>
 #include <exception>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "generate.h"
+#include "grid.h"
+#include "image.h"
+#include "registry.h"
 #include "utils.h"
+#include "vector2d.h"
 
-struct Coord
+namespace day12
 {
-	Coord(int _x = 0, int _y = 0) : x{ _x }, y{ _y } {}
 
-	int x;
-	int y;
-
-	friend Coord operator+(const Coord &a, const Coord &b) { return { a.x + b.x, a.y + b.y }; }
-	friend Coord operator-(const Coord &a, const Coord &b) { return { a.x - b.x, a.y - b.y }; }
-};
-
-std::ostream &operator<<(std::ostream& os, const Coord &coord)
-{
-	return os << "{ " << coord.x << ", " << coord.y << " }";
-}
+using Coord = Vector2d;
 
 class TerrainMap
 {
 public:
-	using container_type = std::vector<std::string>;
+	using container_type = Grid2D<char>;
 
-	TerrainMap(container_type map) : m_map{ map }
+	// The scores are padded with 0 rather than -1, so the edges look like they've already been visited
+	TerrainMap(std::span<const std::string_view> map) :
+		m_map{ container_type::fromLines(map, 1) },
+		m_scores{ m_map.width(), m_map.height(), -1, 1, 0 }
 	{
-		m_scores.reserve(m_map.size());
-		for (size_t i{ 0 }; i < m_map.size(); ++i)
-		{
-			m_scores.push_back(std::vector<int>(m_map[0].length(), -1));
-		}
-		m_scores.shrink_to_fit();
-		
 		findStartAndEnd();
 	}
 
@@ -89,6 +83,39 @@ public:
 		return getScore(to);
 	}
 
+	// With --render, elevation from dark to light green, with everywhere the search reached going from yellow to red the further it got
+	void render(const std::string &name) const
+	{
+		const int width{ m_map.width() };
+		const int height{ m_map.height() };
+		const int cell{ std::max(1, 1024 / width) };
+
+		int furthest{ 1 };
+		for (int y{ 0 }; y < height; ++y)
+		{
+			const auto row{ m_scores.row(y) };
+			furthest = std::max(furthest, *std::max_element(row.begin(), row.end()));
+		}
+
+		Image image{ width * cell, height * cell };
+		image.render([this, cell, height, furthest](int x, int y)
+			{
+				// Image row 0 is the bottom
+				const Coord coord{ x / cell, height - 1 - y / cell };
+				const float elevation{ static_cast<float>(getHeight(coord) - 'a') / 25.0f };
+				const Color ground{ 0.1f + 0.5f * elevation, 0.3f + 0.7f * elevation, 0.1f + 0.5f * elevation };
+
+				const int score{ getScore(coord) };
+				if (score == -1)
+					return ground;
+
+				const float along{ static_cast<float>(score) / static_cast<float>(furthest) };
+				return Color{ 0.5f + 0.5f * ground.r, (1.0f - along) * 0.5f + 0.5f * ground.g, 0.5f * ground.b };
+			}, run::current().options.threads);
+
+		image.save(utils::imagePath(name).concat(".bmp").string().c_str(), run::current().options.threads);
+	}
+
 private:
 
 	container_type m_map;
@@ -96,28 +123,28 @@ private:
 	Coord start;
 	Coord goal;
 
-	std::vector<std::vector<int>> m_scores;
+	Grid2D<int> m_scores;
 
 	bool findStartAndEnd()
 	{
 		int found{ 0 };
-		for (size_t y{ 0 }; y < m_map.size(); ++y)
+		for (int y{ 0 }; y < m_map.height(); ++y)
 		{
-			for (size_t x{ 0 }; x < m_map[0].length(); ++x)
+			for (int x{ 0 }; x < m_map.width(); ++x)
 			{
-				if (m_map[y][x] == 'S')
+				if (m_map.at(x, y) == 'S')
 				{
-					m_map[y][x] = 'a';
-					start = { static_cast<int>(x), static_cast<int>(y) };
+					m_map.at(x, y) = 'a';
+					start = { x, y };
 					if (++found == 2)
 					{
 						return true;
 					}
 				}
-				else if (m_map[y][x] == 'E')
+				else if (m_map.at(x, y) == 'E')
 				{
-					m_map[y][x] = 'z';
-					goal = { static_cast<int>(x), static_cast<int>(y) };
+					m_map.at(x, y) = 'z';
+					goal = { x, y };
 					if (++found == 2)
 					{
 						return true;
@@ -131,23 +158,17 @@ private:
 	void addNeighboursIf(std::deque<Coord> &pending, bool (*condition)(char, char))
 	{
 		auto curr{ pending.front() };
-		const std::array<Coord, 4> neighbours {{
-			curr + Coord{ 0, -1 },
-			curr + Coord{ 0, 1 }, 
-			curr + Coord{ -1, 0 }, 
-			curr + Coord{ 1, 0 } 
-		}};
 
 		auto checks {
 			[this, condition](const Coord &a, const Coord &b)
 			{ 
-				return this->inBounds(b) &&		// Valid indices
-					this->getScore(b) == -1 &&	// Only look at unscored coords
+				return this->getScore(b) == -1 &&	// Only look at unscored coords (the padding's 0 so that's never out of bounds)
 					condition(this->getHeight(a), this->getHeight(b));	// Compare current height against neighbour's
 			} };
 
-		for (auto &neighbour : neighbours)
+		for (const auto &direction : grid::orthogonal)
 		{
+			const Coord neighbour{ curr + direction };
 			if (checks(curr, neighbour))
 			{
 				setScore(neighbour, getScore(curr) + 1);
@@ -158,26 +179,17 @@ private:
 
 	char getHeight(const Coord &coord) const
 	{
-		return m_map[static_cast<size_t>(coord.y)][static_cast<size_t>(coord.x)];
+		return m_map[coord];
 	}
 
 	int getScore(const Coord &coord) const
 	{
-		return m_scores[static_cast<size_t>(coord.y)][static_cast<size_t>(coord.x)];
+		return m_scores[coord];
 	}
 
 	void setScore(const Coord &coord, int score)
 	{
-		m_scores[static_cast<size_t>(coord.y)][static_cast<size_t>(coord.x)] = score;
-	}
-
-	bool inBounds(const Coord &coord)
-	{
-		const size_t x{ static_cast<size_t>(coord.x) };
-		const size_t y{ static_cast<size_t>(coord.y) };
-		return
-			y >= 0 && y < m_map.size() &&
-			x >= 0 && x < m_map[y].length();
+		m_scores[coord] = score;
 	}
 };
 
@@ -191,6 +203,11 @@ namespace Puzzle1
 
 		utils::printAnswer("shortest path from start to goal: ", solution);
 
+		if (flags::isSet(flags::Flag::render))
+		{
+			grid.render("heightmap");
+		}
+
 	}
 };
 
@@ -204,25 +221,45 @@ namespace Puzzle2
 
 		utils::printAnswer("shortest path from goal to low point: ", solution);
 
+		if (flags::isSet(flags::Flag::render))
+		{
+			grid.render("heightmap");
+		}
+
 	}
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
-
-	const std::string input{ utils::inputFile(__FILE__) };
-
-	try
-	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
+	// Climbs from a on the left to z on the right with dips scattered about
+	// The top row and right hand column have no dips, so there's always a way from S to E
+	void input(std::ostream &out, double scale, generate::Random &random)
 	{
-		std::cerr << e.what() << '\n';
+		const size_t width{ generate::count(95, std::sqrt(scale), 26) };
+		const size_t height{ generate::count(41, std::sqrt(scale), 2) };
+
+		std::string row(width, 'a');
+		for (size_t y{ 0 }; y < height; ++y)
+		{
+			for (size_t x{ 0 }; x < width; ++x)
+			{
+				int elevation{ static_cast<int>(x * 26 / width) };
+				if (y && x + 1 < width && random.chance(0.15))
+				{
+					elevation = std::max(0, elevation - random.range(1, 3));
+				}
+				row[x] = static_cast<char>('a' + elevation);
+			}
+			if (y == height / 2)
+			{
+				row.front() = 'S';
+				row.back() = 'E';
+			}
+			out << row << '\n';
+		}
 	}
+};
 
-	return 0;
+} // namespace day12
 
-}
+AOC_MAIN(day12)
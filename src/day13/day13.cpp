@@ -11,8 +11,13 @@
 #include <string_view>
 
 #include "debug.h"
+#include "generate.h"
+#include "registry.h"
 #include "utils.h"
 
+namespace day13
+{
+
 // Find the next comma and return a string starting from the following char
 std::string_view next(std::string_view in)
 {
@@ -184,22 +189,43 @@ namespace Puzzle2
 	}
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
-
-	const std::string input{ utils::inputFile(__FILE__) };
-
-	try
+	void packet(std::ostream &out, int depth, generate::Random &random)
 	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
+		out << '[';
+		const int length{ random.range(0, 5) };
+		for (int i{ 0 }; i < length; ++i)
+		{
+			if (i)
+			{
+				out << ',';
+			}
+			if (depth < 4 && random.chance(0.3))
+				packet(out, depth + 1, random);
+			else
+				out << random.range(0, 10);
+		}
+		out << ']';
 	}
-	catch(const std::exception& e)
+
+	void input(std::ostream &out, double scale, generate::Random &random)
 	{
-		std::cerr << e.what() << '\n';
+		const size_t pairs{ generate::count(150, scale) };
+		for (size_t i{ 0 }; i < pairs; ++i)
+		{
+			if (i)
+			{
+				out << '\n';
+			}
+			packet(out, 0, random);
+			out << '\n';
+			packet(out, 0, random);
+			out << '\n';
+		}
 	}
+};
 
-	return 0;
+} // namespace day13
 
-}
+AOC_MAIN(day13)
@@ -1,74 +1,28 @@
 // --- Day 14: Regolith Reservoir ---
 
+#include <algorithm>
+#include <cmath>
 #include <exception>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <iostream>
-#include <set>
 #include <string>
 #include <string_view>
+#include <vector>
 
+#include "bitgrid.h"
+#include "flatmap.h"
+#include "frames.h"
+#include "generate.h"
+#include "registry.h"
 #include "utils.h"
+#include "vector2d.h"
 
-struct Coord
+namespace day14
 {
-    using Coord_t = int;
 
-    Coord() : x{ 0 }, y{ 0 } {}
-    Coord(Coord_t _x, Coord_t _y) : x{ _x }, y{ _y } {}
-
-    Coord_t x;
-    Coord_t y;
-
-    Coord abs()
-    {
-        return { x < 0 ? x * - 1 : x, y < 0 ? y * - 1 : y };
-    }
-
-    Coord normalised()
-    {
-        return *this / abs();
-    }
-
-    friend Coord operator/(const Coord &lhs, const Coord &rhs)
-    {
-        return { lhs.x / rhs.x, lhs.y / rhs.y };
-    }
-
-    friend Coord operator+(const Coord &lhs, const Coord &rhs)
-    {
-        return { lhs.x + rhs.x, lhs.y + rhs.y };
-    }
-    friend Coord operator-(const Coord &lhs, const Coord &rhs)
-    {
-        return { lhs.x - rhs.x, lhs.y - rhs.y };
-    }
-
-    friend bool operator==(const Coord &lhs, const Coord &rhs)
-    {
-        return lhs.x == rhs.x && lhs.y == rhs.y;
-    }
-    friend bool operator!=(const Coord &lhs, const Coord &rhs)
-    {
-        return !(lhs == rhs);
-    }
-
-    friend bool operator<(const Coord &lhs, const Coord &rhs)
-    {
-        return lhs.x < rhs.x || (lhs.x == rhs.x && lhs.y < rhs.y);
-    }
-    friend bool operator>(const Coord &lhs, const Coord &rhs)
-    {
-        return lhs.x > rhs.x || (lhs.x == rhs.x && lhs.y > rhs.y);
-    }
-
-};
-
-std::ostream& operator<<(std::ostream& os, const Coord& coord)
-{
-    return os << "{ " << coord.x << ", " << coord.y << " }";
-}
+using Coord = Vector2d;
 
 // Recurse through the line while fnc == true
 void forEachOnLine(const Coord &coord, const Coord &step, const Coord &end, std::function<bool(const Coord&)> fnc)
@@ -84,64 +38,117 @@ void forEachOnLine(const Coord &coord, const Coord &step, const Coord &end, std:
 // Include the first, exclude the last
 void forEachOnLine(const Coord &start, const Coord &end, std::function<bool(const Coord&)> fnc)
 {
-    const Coord step{ (end - start).normalised() };
+    const Coord step{ (end - start).sign() };
     forEachOnLine(start, step, end, fnc);
 }
 
 // Skip the first one, include the last one (skip the first because it'll be added to the map twice elsewise)
 void forEachOnLineSkipFirst(const Coord &start, const Coord &end, std::function<bool(const Coord&)> fnc)
 {
-    const Coord step{ (end - start).normalised() };
+    const Coord step{ (end - start).sign() };
     forEachOnLine(start + step, step, end + step, fnc);
 }
 
+// The rocks as bits, x from origin.x and y from 0, anything outside width and height left out
+BitGrid rockBits(const flat::Set<Coord> &cave, const Coord &origin, int width, int height)
+{
+    BitGrid rocks{ width, height };
+    for (const auto &rock : cave)
+    {
+        const Coord bit{ rock - origin };
+        if (rocks.inBounds(bit.x, bit.y))
+        {
+            rocks.set(bit.x, bit.y);
+        }
+    }
+    return rocks;
+}
+
+// For --frames, x from origin.x and y from 0 down the screen
+void drawRocks(Image8 &canvas, const flat::Set<Coord> &cave, const Coord &origin)
+{
+    for (const auto &rock : cave)
+    {
+        const Coord pixel{ rock - origin };
+        if (pixel.x >= 0 && pixel.y >= 0 && pixel.x < canvas.width() && pixel.y < canvas.height())
+        {
+            canvas.setColor(Color{ 0.5f, 0.5f, 0.5f }, pixel.x, pixel.y);
+        }
+    }
+}
+
+void drawSand(frames::Sink &sink, const Coord &sand, const Coord &origin)
+{
+    const Coord pixel{ sand - origin };
+    if (pixel.x >= 0 && pixel.y >= 0 && pixel.x < sink.canvas().width() && pixel.y < sink.canvas().height())
+    {
+        sink.canvas().setColor(Color{ 0.9f, 0.8f, 0.4f }, pixel.x, pixel.y);
+    }
+    sink.frame();
+}
+
 namespace Puzzle1
 {
-    // Return false when sand falls into the void or true if it settles
-    bool sandFall(std::set<Coord> &cave, const Coord &sand)
+    // Edges of the rocks, found before any sand falls
+    struct Bounds
     {
-        static const Coord::Coord_t leftBound{ (*(cave.begin())).x };
-        static const Coord::Coord_t rightBound{ (*(cave.rbegin())).x };
-        // Just finding the largest y value from the cave stones
-        static const Coord::Coord_t lowerBound{
-            (*(std::max_element(cave.begin(), cave.end(),
-            [](const Coord& a, const Coord& b)
-                {
-                    return a.y < b.y;
-                }))).y };
+        Bounds(int left, int right, int lower) : leftBound{ left }, rightBound{ right }, lowerBound{ lower } {}
 
-        if (sand.x < leftBound || sand.x > rightBound || sand.y > lowerBound)
+        Bounds(const flat::Set<Coord> &cave) :
+            leftBound{ cave.begin()->x },
+            rightBound{ cave.begin()->x },
+            lowerBound{ cave.begin()->y }
+        {
+            for (const auto &rock : cave)
+            {
+                leftBound = std::min(leftBound, rock.x);
+                rightBound = std::max(rightBound, rock.x);
+                lowerBound = std::max(lowerBound, rock.y);
+            }
+        }
+
+        int leftBound;
+        int rightBound;
+        int lowerBound;
+    };
+
+    // Return false when sand falls into the void or true if it settles
+    // In the cave's coords, which has a spare column either side of the bounds so looking down-left / down-right from the edge is fine
+    bool sandFall(BitGrid &cave, const Coord &sand, const Bounds &bounds, Coord &settled)
+    {
+        if (sand.x < bounds.leftBound || sand.x > bounds.rightBound || sand.y > bounds.lowerBound)
         {
             return false;
         }
             
         // Fall straight down if there's room
-        if (!cave.contains(sand + Coord{ 0, 1 }))
+        if (!cave.test(sand.x, sand.y + 1))
         {
-            return sandFall(cave, sand + Coord{ 0 , 1 });
+            return sandFall(cave, sand + Coord{ 0 , 1 }, bounds, settled);
         }
 
         // Left-down
-        if (!cave.contains(sand + Coord{ -1, 1 }))
+        if (!cave.test(sand.x - 1, sand.y + 1))
         {
-            return sandFall(cave, sand + Coord{ -1, 1 });
+            return sandFall(cave, sand + Coord{ -1, 1 }, bounds, settled);
         }
 
         // Right-down
-        if (!cave.contains(sand + Coord{ 1, 1 }))
+        if (!cave.test(sand.x + 1, sand.y + 1))
         {
-            return sandFall(cave, sand + Coord{ 1, 1 });
+            return sandFall(cave, sand + Coord{ 1, 1 }, bounds, settled);
         }
 
         // Settle
-        cave.insert(sand); 
+        cave.set(sand.x, sand.y);
+        settled = sand;
         return true;
         
     }
 
 	void solve(const std::string& infile)
 	{
-        std::set<Coord> caveMap;
+        flat::Set<Coord> caveMap;
 
         // Firstly, get the coords from the input file to build a cave map
         utils::forEachLine(infile,
@@ -188,10 +195,29 @@ namespace Puzzle1
         const Coord sandStart{ 500, 0 };
 
         int unitsOfSand{ 0 };
-        
-        while(sandFall(caveMap, sandStart))
+        const Bounds rockBounds{ caveMap };
+
+        // Bits for the cave from one left of the rocks to one right of them and a row below, so x and y are from origin
+        const Coord origin{ rockBounds.leftBound - 1, 0 };
+        BitGrid cave{ rockBits(caveMap, origin, rockBounds.rightBound - rockBounds.leftBound + 3, rockBounds.lowerBound + 2) };
+        const Bounds bounds{ 1, cave.width() - 2, rockBounds.lowerBound };
+
+        // With --frames, a frame per unit of sand
+        auto sink{ frames::record("sand", rockBounds.rightBound - rockBounds.leftBound + 1, rockBounds.lowerBound + 1, true) };
+        const Coord canvasOrigin{ 1, 0 };
+        if (sink)
+        {
+            drawRocks(sink->canvas(), caveMap, Coord{ rockBounds.leftBound, 0 });
+        }
+
+        Coord settled{};
+        while(sandFall(cave, sandStart - origin, bounds, settled))
         {
             ++unitsOfSand;
+            if (sink)
+            {
+                drawSand(*sink, settled, canvasOrigin);
+            }
         }
 
         utils::printAnswer("Total of: ", unitsOfSand, " units of sand before abyssal fall");
@@ -201,56 +227,50 @@ namespace Puzzle1
 
 namespace Puzzle2
 {
-    // Return false when sand comes to rest at 500, 0
-    bool sandFall(std::set<Coord> &cave, const Coord &sand)
+    // Just finding the largest y value from the cave stones
+    int findCaveFloor(const flat::Set<Coord> &cave)
     {
-        // Just finding the largest y value from the cave stones
-        static const Coord::Coord_t caveFloor{
-            (*(std::max_element(cave.begin(), cave.end(),
+        return (*(std::max_element(cave.begin(), cave.end(),
             [](const Coord& a, const Coord& b)
                 {
                     return a.y < b.y;
                 }))
-            ).y + 2 };
-
-        if (sand.y == caveFloor - 1)
-        {
-            cave.insert(sand);
-            return true;
-        }
-
-        // Fall straight down if there's room
-        if (!cave.contains(sand + Coord{ 0, 1 }))
-        {
-            return sandFall(cave, sand + Coord{ 0 , 1 });
-        }
+            ).y + 2;
+    }
 
-        // Left-down
-        if (!cave.contains(sand + Coord{ -1, 1 }))
-        {
-            return sandFall(cave, sand + Coord{ -1, 1 });
-        }
+    // With a floor nothing falls out, so the sand ends up everywhere it can get to: a space is sand if it's not rock
+    // and there's sand in any of the three above it, so each row is the one above spread one either way less the rocks
+    // That's a row at a time in 64 wide words, rather than a unit of sand at a time
+    // fnc(sand, y) after each row
+    template<typename Fnc>
+    BitGrid fillSand(const BitGrid &rocks, int startX, Fnc &&fnc)
+    {
+        BitGrid sand{ rocks.width(), rocks.height() };
+        sand.set(startX, 0);
+        fnc(sand, 0);
 
-        // Right-down
-        if (!cave.contains(sand + Coord{ 1, 1 }))
+        std::vector<BitGrid::word_t> left(sand.wordsPerRow());
+        std::vector<BitGrid::word_t> right(sand.wordsPerRow());
+        for (int y{ 1 }; y < sand.height(); ++y)
         {
-            return sandFall(cave, sand + Coord{ 1, 1 });
-        }
+            const auto above{ sand.row(y - 1) };
+            BitGrid::shiftRow(above, 1, left);
+            BitGrid::shiftRow(above, -1, right);
 
-        if (sand == Coord{ 500, 0 })
-        {
-            return false;
+            const auto rock{ rocks.row(y) };
+            const auto row{ sand.row(y) };
+            for (size_t i{ 0 }; i < row.size(); ++i)
+            {
+                row[i] = (above[i] | left[i] | right[i]) & ~rock[i];
+            }
+            fnc(sand, y);
         }
-
-        // Settle
-        cave.insert(sand); 
-        return true;
-        
+        return sand;
     }
 
 	void solve(const std::string& infile)
 	{
-        std::set<Coord> caveMap;
+        flat::Set<Coord> caveMap;
         utils::forEachLine(infile,
             [&caveMap](std::string_view line)
             {
@@ -292,35 +312,68 @@ namespace Puzzle2
 
         const Coord sandStart{ 500, 0 };
 
-        // Starting from 1 'cause we were off by 1!
-        int unitsOfSand{ 1 };
-        
-        while(sandFall(caveMap, sandStart))
+        const int caveFloor{ findCaveFloor(caveMap) };
+
+        // The pile can't spread further than its height either side of where it starts
+        const Coord origin{ sandStart.x - caveFloor, 0 };
+        const BitGrid rocks{ rockBits(caveMap, origin, 2 * caveFloor + 1, caveFloor) };
+
+        // With --frames, a frame per row of sand
+        auto sink{ frames::record("sand", rocks.width(), rocks.height(), true) };
+        if (sink)
         {
-            ++unitsOfSand;
+            drawRocks(sink->canvas(), caveMap, origin);
         }
 
+        const BitGrid sand{ fillSand(rocks, sandStart.x - origin.x,
+            [&sink](const BitGrid &sand, int y)
+            {
+                if (sink)
+                {
+                    sand.forEachSet(y, [&sink, y](int x) { sink->canvas().setColor(Color{ 0.9f, 0.8f, 0.4f }, x, y); });
+                    sink->frame();
+                }
+            }) };
+
+        const size_t unitsOfSand{ sand.count() };
+
         utils::printAnswer("Total of: ", unitsOfSand, " units of sand before cave is full");
 
     }
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
+    // Paths of horizontal and vertical lines, the cave getting deeper and wider (and so the pile of sand bigger) with scale
+    void input(std::ostream &out, double scale, generate::Random &random)
+    {
+        const int depth{ static_cast<int>(generate::count(160, std::sqrt(scale), 20)) };
+        const size_t paths{ generate::count(160, scale) };
 
-	const std::string input{ utils::inputFile(__FILE__) };
+        for (size_t path{ 0 }; path < paths; ++path)
+        {
+            int x{ random.range(500 - depth / 2, 500 + depth / 2) };
+            int y{ random.range(13, depth) };
+            out << x << ',' << y;
 
-	try
-	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
-	{
-		std::cerr << e.what() << '\n';
-	}
+            const int lines{ random.range(1, 6) };
+            bool bHorizontal{ random.chance(0.5) };
+            for (int line{ 0 }; line < lines; ++line)
+            {
+                const int length{ random.range(1, 8) * (random.chance(0.5) ? 1 : -1) };
+                if (bHorizontal)
+                    x += length;
+                else
+                    y = y + length < 13 ? y - length : y + length;
+                bHorizontal = !bHorizontal;
+
+                out << " -> " << x << ',' << y;
+            }
+            out << '\n';
+        }
+    }
+};
 
-	return 0;
+} // namespace day14
 
-}
+AOC_MAIN(day14)
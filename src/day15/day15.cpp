@@ -12,105 +12,35 @@
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 #include "debug.h"
+#include "generate.h"
+#include "registry.h"
+#include "scan.h"
 #include "utils.h"
+#include "vector2d.h"
 
-struct Coord // I keep making Coord structs. Why don't I just copy and paste?!
+namespace day15
 {
-    using type = long; // Changing int to long lets me do the * 4000000 thing at the end hehe
-    
-    Coord(type _x, type _y) : x{ _x }, y{ _y } {}
-    
-    Coord(std::string_view str, bool bSearchBackwards = false)
-    {
-        if (!bSearchBackwards)
-        {
-            x = std::atoi( str.data() + str.find('x') + 2 );
-            y = std::atoi( str.data() + str.find('y') + 2 );
-        }
-        else
-        {
-            x = std::atoi( str.data() + str.find_last_of('x') + 2 );
-            y = std::atoi( str.data() + str.find_last_of('=') + 1 ); 
-        }
-    }
-
-    type x;
-    type y; 
-
-    type dist(const Coord &rhs)
-    {
-        return dist(*this, rhs);
-    }
-
-    friend Coord operator+(const Coord &lhs, const Coord &rhs)
-    {
-        return Coord{ lhs.x + rhs.x, lhs.y + rhs.y };
-    }
 
-    friend Coord operator-(const Coord &lhs, const Coord &rhs)
-    {
-        return Coord{ lhs.x - rhs.x, lhs.y - rhs.y };
-    }
-
-    friend Coord operator*(const Coord &lhs, const int i)
-    {
-        return { lhs.x * i, lhs.y * i };
-    }
-
-    // Manhattan distance between two coords
-    static type dist(const Coord &lhs, const Coord &rhs)
-    {
-        return std::abs(lhs.x - rhs.x) + std::abs(lhs.y - rhs.y);
-    }
-
-    friend bool operator<(const Coord &lhs, const Coord &rhs)
-    {
-        return lhs.x < rhs.x || ( lhs.x == rhs.x && lhs.y < rhs.y );
-    }
+// I keep making Coord structs. Why don't I just copy and paste?!
+using coord_t = long; // Changing int to long lets me do the * 4000000 thing at the end hehe
+using Coord = Vec2dT<coord_t>;
 
-    Coord& operator+=(const Coord &add)
-    {   
-        x += add.x;
-        y += add.y;
-        return *this;
-    }
-
-    friend bool operator==(const Coord &lhs, const Coord &rhs)
-    {
-        return lhs.x == rhs.x && lhs.y == rhs.y;
-    }
-
-    friend Coord operator/(const Coord &lhs, const Coord &rhs)
-    {
-        return { lhs.x / rhs.x, lhs.y / rhs.y };
-    }
-
-    Coord abs()
-    {
-        return { std::abs(x), std::abs(y) }; 
-    }
-
-    Coord normalised()
-    {
-        return *this / (*this).abs();
-    }
-
-    static Coord direction(const Coord &from, const Coord &to)
-    {
-        return (to - from) / (to - from).abs();
-    }
+// From an input line, the sensor's coord or the beacon's if bSearchBackwards
+Coord parseCoord(std::string_view str, bool bSearchBackwards = false)
+{
+    thread_local scan::Ints<coord_t> ints;
+    const auto numbers{ ints.extract(str) }; // sensor x, y, beacon x, y
 
-    Coord direction(const Coord &to)
-    {
-       return direction(*this, to);
-    }
-};
+    const size_t first{ bSearchBackwards ? 2u : 0u };
+    return { numbers[first], numbers[first + 1] };
+}
 
 struct MinMax
 {
-    using minmax_t = Coord::type;
+    using minmax_t = coord_t;
 
     MinMax(const minmax_t _min, const minmax_t _max) : min{ _min }, max{ _max } {}
     minmax_t min;
@@ -142,11 +72,6 @@ struct MinMax
     }
 };
 
-std::ostream& operator<<(std::ostream &os, const Coord &coord)
-{
-    return os << "{ " << coord.x << ", " << coord.y << " }";
-}
-
 std::ostream& operator<<(std::ostream &os, const MinMax &range)
 {
     return os << "{ " << range.min << ", " << range.max << " }";
@@ -262,10 +187,15 @@ int numberFromInput(std::string_view line, const size_t index = 11)
 
 void parseInput(std::string_view line, MinMaxRanges &coverage)
 {
-    const Coord::type rowToCheck{ flags::isSet(flags::Flag::test) ? 10 : 2000000 };
+    if (line.empty())
+    {
+        return;
+    }
 
-    const Coord sensor{ line };
-    const Coord beacon{ line, true };
+    const coord_t rowToCheck{ flags::isSet(flags::Flag::test) ? 10 : 2000000 };
+
+    const Coord sensor{ parseCoord(line) };
+    const Coord beacon{ parseCoord(line, true) };
 
     const auto rowDist{ std::abs(sensor.y - rowToCheck) };
 
@@ -274,7 +204,7 @@ void parseInput(std::string_view line, MinMaxRanges &coverage)
         coverage.addBeacon(beacon.x);
     }
 
-    const auto beaconDist { Coord::dist(sensor, beacon) };
+    const auto beaconDist { Coord::manhatDist(sensor, beacon) };
 
     // Double whatever's left from the y difference, as it spreads left and right equally
     const auto excessCoverage{ beaconDist - rowDist };
@@ -293,27 +223,25 @@ void parseInput(std::string_view line, MinMaxRanges &coverage)
 
 struct Sensor
 {
-    Sensor(Coord::type x, Coord::type y, Coord::type _radius) : location{ x, y }, radius{ _radius } {}
-    Sensor(Coord _location, Coord::type _radius) : location{ _location }, radius{ _radius } {}
+    Sensor(coord_t x, coord_t y, coord_t _radius) : location{ x, y }, radius{ _radius } {}
+    Sensor(Coord _location, coord_t _radius) : location{ _location }, radius{ _radius } {}
 
     // Construct straight from the input file line why not
     Sensor(std::string_view inputLine)
-        : location{ std::atoi( inputLine.data() + inputLine.find('x') + 2 ),
-                    std::atoi( inputLine.data() + inputLine.find('y') + 2 ) }
+        : location{ parseCoord(inputLine) }
     {
-        const Coord beacon{ std::atoi( inputLine.data() + inputLine.find_last_of('x') + 2 ),
-                            std::atoi( inputLine.data() + inputLine.find_last_of('=') + 1 ) };
+        const Coord beacon{ parseCoord(inputLine, true) };
     
-        radius = Coord::dist(location, beacon);
+        radius = Coord::manhatDist(location, beacon);
 
         DL(location << ", radius: " << radius);
     }
     Coord location;
-    Coord::type radius;
+    coord_t radius;
 
     bool overlaps(const Coord &coord)
     {
-        return location.dist(coord) <= radius;
+        return Coord::manhatDist(location, coord) <= radius;
     }
 
 };
@@ -321,14 +249,30 @@ struct Sensor
 class SensorList
 {
     std::vector<Sensor> m_sensors;
+    // The same again as arrays, for checking a location against all of them at once
+    Vec2dBatch<coord_t> m_locations;
+    std::vector<coord_t> m_radii;
+    size_t m_lastCover{ 0 };
     const Coord lowerBound{ 0, 0 };
 
     const Coord upperBound{ flags::isSet(flags::Flag::test) ? Coord{ 20, 20 } : Coord{ 4000000, 4000000 } };
 
 public:
+    // Neighbouring locations are nearly always covered by the same sensor, so that one's checked first
+    bool covered(const Coord &location)
+    {
+        if (m_lastCover < m_sensors.size() && Coord::manhatDist(m_locations[m_lastCover], location) <= m_radii[m_lastCover])
+            return true;
+
+        m_lastCover = m_locations.firstWithin(location, m_radii);
+        return m_lastCover < m_sensors.size();
+    }
+
     void insert(const Sensor& sensor)
     {
         m_sensors.push_back(sensor);
+        m_locations.push_back(sensor.location);
+        m_radii.push_back(sensor.radius);
     }
 
     Coord checkPerimeters()
@@ -341,9 +285,8 @@ public:
             { -1, 1 }   // left-up
         }};
 
-        for (auto iter1{ m_sensors.begin() }; iter1 != m_sensors.end(); ++iter1)
+        for (const auto &checkingSensor : m_sensors)
         {
-            auto checkingSensor{ *iter1 };
 
             DL("SENSOR checking: " << checkingSensor.location << " rad: " << checkingSensor.radius);
 
@@ -362,40 +305,14 @@ public:
             auto check{ left + 
                         directions[0] *
                         std::max(
-                            std::max((lowerBound.x - left.x), Coord::type{ 0 }),
-                            std::max((lowerBound.y - left.y), Coord::type{ 0 }))};
+                            std::max((lowerBound.x - left.x), coord_t{ 0 }),
+                            std::max((lowerBound.y - left.y), coord_t{ 0 }))};
 
             // Iterate from the left of the sensor's radius to the top
             while (check.y < top.y && check.y <= upperBound.y && check.x <= upperBound.x)
             {
-                bool bOverlapped{ true };
-
-                // Is this location covered by any sensors?
-                for (auto iter2{ m_sensors.begin() }; iter2 != m_sensors.end(); ++iter2)
-                {
-                    if (iter1 == iter2) continue;
-
-                    auto sensorComp{ *iter2 };
-
-                    // I thought we could skip ahead upon collisions (and still think it!)
-                    // But this doesn't work for the non-test input so there must be edge cases or something idk!
-                    if (auto sensorDist{ sensorComp.location.dist(check) }; sensorDist <= sensorComp.radius)
-                    {
-                        // DL("Collision with " << sensorComp.location << ", r: " << sensorComp.radius << " at " << check);
-                        
-                        // This line is the skip that breaks it (but not for the test input):
-                        // check += directions[0] * sensorDist;
-
-                        // DL("Skipping to " << check);
-                        bOverlapped = true;
-                        break;
-                    }
-
-                    bOverlapped = false;
-                }
-
-                // If we get here without an overlap, we've found the beacon
-                if (!bOverlapped)
+                // Is this location covered by any sensors? (the one we're going round never covers its own perimeter)
+                if (!covered(check))
                 {
                     return check;
                 }
@@ -410,33 +327,13 @@ public:
             check = top + 
                         directions[1] *
                         std::max(
-                            std::max((lowerBound.x - top.x), Coord::type{ 0 }),
-                            std::max((top.y - upperBound.y), Coord::type{ 0 }));
+                            std::max((lowerBound.x - top.x), coord_t{ 0 }),
+                            std::max((top.y - upperBound.y), coord_t{ 0 }));
             
             while (check.x < right.x && check.y >= lowerBound.y && check.x <= upperBound.x)
             {
-                bool bOverlapped{ true };
-
-                for (auto iter2{ m_sensors.begin() }; iter2 != m_sensors.end(); ++iter2)
-                {
-                    if (iter1 == iter2) continue;
-
-                    auto sensorComp{ *iter2 };
-
-                    if (auto sensorDist{ sensorComp.location.dist(check) }; sensorDist <= sensorComp.radius)
-                    {
-                        // DL("Collision with " << sensorComp.location << ", r: " << sensorComp.radius << " at " << check);
-                        // check += directions[1] * sensorDist;
-                        // DL("Skipping to " << check);
-                        bOverlapped = true;
-                        break;
-                    }
-
-                    bOverlapped = false;
-
-                }
-
-                if (!bOverlapped)
+                // Is this location covered by any sensors? (the one we're going round never covers its own perimeter)
+                if (!covered(check))
                 {
                     return check;
                 }
@@ -448,31 +345,13 @@ public:
             check = right + 
                         directions[2] *
                         std::max(
-                            std::max((right.x - upperBound.x), Coord::type{ 0 }),
-                            std::max((right.y - upperBound.y), Coord::type{ 0 }));
+                            std::max((right.x - upperBound.x), coord_t{ 0 }),
+                            std::max((right.y - upperBound.y), coord_t{ 0 }));
 
             while (check.y > bottom.y && check.y >= lowerBound.y && check.x >= lowerBound.x)
             {
-                bool bOverlapped{ true };
-
-                for (auto iter2{ m_sensors.begin() }; iter2 != m_sensors.end(); ++iter2)
-                {
-                    if (iter1 == iter2) continue;
-
-                    auto sensorComp{ *iter2 };
-
-                    if (auto sensorDist{ sensorComp.location.dist(check) }; sensorDist <= sensorComp.radius)
-                    {
-                        // DL("Collision with " << sensorComp.location << ", r: " << sensorComp.radius << " at " << check);
-                        // check += directions[2] * sensorDist;
-                        // DL("Skipping to " << check);
-                        bOverlapped = true;
-                        break;
-                    }
-                    bOverlapped = false;
-                }
-
-                if (!bOverlapped)
+                // Is this location covered by any sensors? (the one we're going round never covers its own perimeter)
+                if (!covered(check))
                 {
                     return check;
                 }
@@ -484,31 +363,13 @@ public:
             check = bottom + 
                         directions[3] *
                         std::max(
-                            std::max((bottom.x - upperBound.x), Coord::type{ 0 }),
-                            std::max((lowerBound.y - bottom.y), Coord::type{ 0 }));
+                            std::max((bottom.x - upperBound.x), coord_t{ 0 }),
+                            std::max((lowerBound.y - bottom.y), coord_t{ 0 }));
 
             while (check.x > left.x && check.y <= upperBound.y && check.x >= lowerBound.x)
             {
-                bool bOverlapped{ true };
-
-                for (auto iter2{ m_sensors.begin() }; iter2 != m_sensors.end(); ++iter2)
-                {
-                    if (iter1 == iter2) continue;
-
-                    auto sensorComp{ *iter2 };
-                    if (auto sensorDist{ sensorComp.location.dist(check) }; sensorDist <= sensorComp.radius)
-                    {
-                        // DL("Collision with " << sensorComp.location << ", r: " << sensorComp.radius << " at " << check);
-                        // check += directions[3] * sensorDist;
-                        // DL("Skipping to " << check);
-                        bOverlapped = true;
-                        break;
-                    }
-
-                    bOverlapped = false;
-                }
-
-                if (!bOverlapped)
+                // Is this location covered by any sensors? (the one we're going round never covers its own perimeter)
+                if (!covered(check))
                 {
                     return check;
                 }
@@ -590,23 +451,56 @@ namespace Puzzle2
 
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
+    // Every sensor's beacon is one closer than the distress beacon, which is then the only uncovered spot in the search area:
+    // a grid of sensors covers everything more than a couple of grid spaces away from it,
+    // and eight more around it (along the axes and diagonals) cover everything closer
+    void input(std::ostream &out, double scale, generate::Random &random)
+    {
+        const coord_t area{ 4000000 };
+        const Coord distress{ random.range(coord_t{ 1 }, area - 1), random.range(coord_t{ 1 }, area - 1) };
 
-	const std::string input{ utils::inputFile(__FILE__) };
+        const size_t gridSensors{ generate::count(18, scale) };
+        const auto side{ static_cast<coord_t>(std::ceil(std::sqrt(static_cast<double>(gridSensors)))) };
+        const coord_t spacing{ area / side + 1 };
 
-	try
-	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
-	{
-		std::cerr << e.what() << '\n';
-	}
+        std::vector<Coord> sensors;
+        for (coord_t gx{ 0 }; gx < side; ++gx)
+        {
+            for (coord_t gy{ 0 }; gy < side; ++gy)
+            {
+                // Up to a quarter of a space off centre
+                const coord_t jitter{ spacing / 4 };
+                sensors.push_back({ gx * spacing + spacing / 2 + random.range(-jitter, jitter), gy * spacing + spacing / 2 + random.range(-jitter, jitter) });
+            }
+        }
 
-	return 0;
+        // Each grid sensor is at most 1.5 spaces (manhattan) from any point, so these need to cover 3 spaces out
+        const coord_t near{ spacing * 3 / 2 + 2 };
+        for (const Coord &offset : { Coord{ near, 0 }, Coord{ -near, 0 }, Coord{ 0, near }, Coord{ 0, -near },
+                                     Coord{ near, near }, Coord{ near, -near }, Coord{ -near, near }, Coord{ -near, -near } })
+        {
+            sensors.push_back({ distress.x + offset.x, distress.y + offset.y });
+        }
+        random.shuffle(sensors);
 
-}
+        for (const auto &sensor : sensors)
+        {
+            const coord_t toDistress{ std::abs(sensor.x - distress.x) + std::abs(sensor.y - distress.y) };
+            if (toDistress < 2)
+                continue;
+
+            // Anywhere on the diamond one in from the distress beacon
+            const coord_t reach{ toDistress - 1 };
+            const coord_t dx{ random.range(-reach, reach) };
+            const coord_t dy{ (reach - std::abs(dx)) * (random.chance(0.5) ? 1 : -1) };
+
+            out << "Sensor at x=" << sensor.x << ", y=" << sensor.y << ": closest beacon is at x=" << sensor.x + dx << ", y=" << sensor.y + dy << '\n';
+        }
+    }
+};
+
+} // namespace day15
 
+AOC_MAIN(day15)
@@ -1,11 +1,13 @@
 // --- Day 16: Proboscidea Volcanium ---
 
+#include <algorithm>
 #include <deque>
 #include <exception>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <set>
 #include <stack>
 #include <string>
 #include <string_view>
@@ -13,15 +15,23 @@
 #include <vector>
 
 #include "debug.h"	// Enable debug macros with -d flag
+#include "flatmap.h"
+#include "generate.h"
 #include "log.h"	// Enable with -l flag
+#include "profile.h"	// Enable with -p flag
+#include "registry.h"
 #include "utils.h"
 #include "timer.h"
 
+namespace day16
+{
+
 struct UsefulValves
 {
 	using bits_t = std::uint16_t;
 
-	using map_t = std::map<bits_t, int>;
+	// Looked up on every step of the searches, so hash maps rather than trees
+	using map_t = flat::Map<bits_t, int>;
 	static map_t flows; // id = key
 	static map_t distances; // bitwise or | 2 ids for key
 
@@ -90,6 +100,29 @@ struct AllValves
 
 	static const int totalTime;
 
+	// Everything's static, so clear out an earlier run's valves before parsing different ones
+	static void reset()
+	{
+		for (auto &&valve : list)
+		{
+			delete valve.second;
+		}
+		list.clear();
+		distances.clear();
+		bitIds.clear();
+
+		std::set<UsefulValves::map_t*> distMaps{ UsefulValves::distsPerTime.begin(), UsefulValves::distsPerTime.end() };
+		for (auto *distMap : distMaps)
+		{
+			delete distMap;
+		}
+		UsefulValves::distsPerTime.clear();
+		UsefulValves::flows.clear();
+		UsefulValves::distances.clear();
+		UsefulValves::orderedFlows.clear();
+		UsefulValves::orderedDistancesPerValve.clear();
+	}
+
 	static void push(std::string_view fromInput)
 	{
 		// ValveInfo newValve{ fromInput };
@@ -188,6 +221,8 @@ struct AllValves
 		{
 			UsefulValves::orderedFlows.push_back({ flow.first, flow.second });
 		}
+		// flows isn't in id order any more, put it back in it first so valves with the same flow end up in the same order they always did
+		std::sort(UsefulValves::orderedFlows.begin(), UsefulValves::orderedFlows.end());
 		std::sort(UsefulValves::orderedFlows.begin(), UsefulValves::orderedFlows.end(),
 			[](auto &l, auto &r)
 			{
@@ -234,6 +269,19 @@ struct State
 
 	static int bestRelease;
 
+	using cache_t = flat::Map<std::pair<int, bits_t>, int, flat::PairHash>;
+	static cache_t releaseFromLastOpenedCache;
+	static cache_t idealReleaseCache;
+	static flat::Map<std::pair<bits_t, int>, bits_t, flat::PairHash> unreachableCache;
+
+	static void reset()
+	{
+		bestRelease = 0;
+		releaseFromLastOpenedCache.clear();
+		idealReleaseCache.clear();
+		unreachableCache.clear();
+	}
+
 	static int initialPotential()
 	{
 		int potential{ 0 };
@@ -263,11 +311,11 @@ struct State
 
 	int idealReleaseFromLastOpened()
 	{
-		static std::map<std::pair<int, bits_t>, int> cache;
+		auto &cache{ releaseFromLastOpenedCache };
 
-		if (cache.contains( {time, opened} ) )
+		if (const auto cached{ cache.find({ time, opened }) }; cached != cache.end())
 		{
-			return cache[{time,opened}];
+			return cached->second;
 		}
 
 		int potential{ 0 };
@@ -287,11 +335,11 @@ struct State
 
 	static int idealRelease(int time, bits_t openValves)
 	{
-		static std::map<std::pair<int, bits_t>, int> cache;
+		auto &cache{ idealReleaseCache };
 
-		if (cache.contains({ time, openValves }))
+		if (const auto cached{ cache.find({ time, openValves }) }; cached != cache.end())
 		{
-			return cache[ { time, openValves } ];
+			return cached->second;
 		}
 
 		auto potentialTime{ time };
@@ -319,14 +367,11 @@ struct State
 	static bits_t unreachable(bits_t from, int time)
 	{
 		//  static std::map<std::pair<bits_t, int>, bits_t> cache;
-		static std::map<bits_t, std::map<int, bits_t>> cache;
+		auto &cache{ unreachableCache };
 
-		if (cache.contains(from))
+		if (const auto cached{ cache.find({ from, time }) }; cached != cache.end())
 		{
-			if (cache[from].contains(time))
-			{
-				return cache[from][time];
-			}
+			return cached->second;
 		}
 
 		bits_t unreachableValves{ 0 };
@@ -338,7 +383,7 @@ struct State
 			}
 		}
 
-		cache[from][time] = unreachableValves;
+		cache[{ from, time }] = unreachableValves;
 
 		return unreachableValves;
 	}
@@ -372,6 +417,9 @@ struct State
 };
 
 int State::bestRelease{ 0 };
+State::cache_t State::releaseFromLastOpenedCache;
+State::cache_t State::idealReleaseCache;
+flat::Map<std::pair<State::bits_t, int>, State::bits_t, flat::PairHash> State::unreachableCache;
 const int State::totalTime{ 30 };
 
 struct StateTwoWorkers
@@ -429,19 +477,13 @@ struct StateTwoWorkers
 	// Flip bits which don't represent any valve to 1 (only 16th bit for puzzle input, 11 bits for test)
 	static bt initialUnused()
 	{
-		static bool bSet{ false };
-		static bt ignoreValveIds{ 0 };
-
-		if (!bSet)
+		bt ignoreValveIds{ 0 };
+		for (bt i{ 1 }; i != 0; i <<= 1)
 		{
-			for (bt i{ 1 }; i != 0; i <<= 1)
+			if (!v::flows.contains(i))
 			{
-				if (!v::flows.contains(i))
-				{
-					ignoreValveIds |= i;
-				}
+				ignoreValveIds |= i;
 			}
-			bSet = true;
 		}
 
 		return ignoreValveIds;
@@ -593,18 +635,26 @@ namespace Puzzle1
 			throw std::runtime_error("could not open " + infile);
 		}
 
-		while (inf)
+		// Part 2 uses the valves parsed here, so this is the only place they're cleared
+		AllValves::reset();
+		State::reset();
+
 		{
-			std::string line;
-			std::getline(inf, line);
-			if (line.length())
+			PROFILE("parse");
+			while (inf)
 			{
-				AllValves::push(line);
+				std::string line;
+				std::getline(inf, line);
+				if (line.length())
+				{
+					AllValves::push(line);
+				}
 			}
-		}
 
-		AllValves::compress();
+			AllValves::compress();
+		}
 
+		PROFILE("search");
 		auto s{ State{} };
 		utils::printAnswer("total possible pressure release in 30 seconds: ", State::openAll(s));
 	}
@@ -624,28 +674,107 @@ namespace Puzzle2
 			throw std::runtime_error("could not open " + infile);
 		}
 
+		PROFILE("search");
 		auto st2{ StateTwoWorkers{} };
 
 		utils::printAnswer("total possible pressure release in 26 seconds with an elephant's help: ", st2.depthFirst());
 	}
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
+	// Same 15 valves with flow as the puzzle (the bitmasks only have room for that many), scale adds more empty ones between them
+	// Two letter names only go to 676 valves
+	void input(std::ostream &out, double scale, generate::Random &random)
+	{
+		const size_t valves{ std::min<size_t>(generate::count(59, scale, 16), 26 * 26) };
+
+		std::vector<std::string> names;
+		for (char first{ 'A' }; first <= 'Z'; ++first)
+		{
+			for (char second{ 'A' }; second <= 'Z'; ++second)
+			{
+				if (first != 'A' || second != 'A')
+				{
+					names.push_back({ first, second });
+				}
+			}
+		}
+		random.shuffle(names);
+		names.resize(valves - 1);
+		names.insert(names.begin(), "AA");
+
+		// Like the puzzle, AA and the valves with flow are joined by corridors of empty valves
+		// A random tree of them so they're all connected, plus a few shortcuts
+		const size_t rooms{ 16 };
+		std::set<std::pair<size_t, size_t>> roomPairs;
+		for (size_t room{ 1 }; room < rooms; ++room)
+		{
+			roomPairs.insert({ random.index(room), room });
+		}
+		while (roomPairs.size() < rooms + 4)
+		{
+			const size_t a{ random.index(rooms) };
+			const size_t b{ random.index(rooms) };
+			if (a < b)
+			{
+				roomPairs.insert({ a, b });
+			}
+		}
+
+		std::vector<std::set<size_t>> tunnels(valves);
+		const auto connect{ [&](size_t a, size_t b) { tunnels[a].insert(b); tunnels[b].insert(a); } };
+		// Corridors are as long as the puzzle's whatever the scale, anything more than that goes in dead ends off them
+		// (longer corridors would only leave less of the 30 minutes for opening valves)
+		const size_t corridorValves{ std::min<size_t>(valves, 59) };
+		size_t nextEmpty{ rooms };
+		size_t pairsLeft{ roomPairs.size() };
+		for (const auto &[a, b] : roomPairs)
+		{
+			// An even share of what's left, give or take one
+			const size_t share{ (corridorValves - nextEmpty) / pairsLeft-- };
+			const size_t corridor{ pairsLeft ? std::min(share + random.index(3) - std::min<size_t>(share, 1), corridorValves - nextEmpty) : corridorValves - nextEmpty };
+			size_t previous{ a };
+			for (size_t i{ 0 }; i < corridor; ++i)
+			{
+				connect(previous, nextEmpty);
+				previous = nextEmpty++;
+			}
+			connect(previous, b);
+		}
+		for (; nextEmpty < valves; ++nextEmpty)
+		{
+			connect(random.index(nextEmpty), nextEmpty);
+		}
 
-	const std::string input{ utils::inputFile(__FILE__) };
+		std::vector<int> flows(valves, 0);
+		for (size_t room{ 1 }; room < rooms; ++room)
+		{
+			flows[room] = random.range(3, 25); // AA never has any
+		}
 
-	try
-	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
-	{
-		std::cerr << e.what() << '\n';
+		std::vector<size_t> order(valves);
+		for (size_t valve{ 0 }; valve < valves; ++valve)
+		{
+			order[valve] = valve;
+		}
+		random.shuffle(order);
+
+		for (size_t valve : order)
+		{
+			out << "Valve " << names[valve] << " has flow rate=" << flows[valve]
+				<< (tunnels[valve].size() == 1 ? "; tunnel leads to valve " : "; tunnels lead to valves ");
+			bool bFirst{ true };
+			for (size_t other : tunnels[valve])
+			{
+				out << (bFirst ? "" : ", ") << names[other];
+				bFirst = false;
+			}
+			out << '\n';
+		}
 	}
+};
 
-	return 0;
+} // namespace day16
 
-}
+AOC_MAIN(day16)
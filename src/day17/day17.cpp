@@ -13,11 +13,21 @@
 #include <utility>
 #include <vector>
 
+#include "arena.h"
+#include "bitgrid.h"
 #include "debug.h"
+#include "flatmap.h"
+#include "frames.h"
+#include "generate.h"
 #include "log.h"
+#include "profile.h"	// Enable with -p flag
+#include "registry.h"
 #include "utils.h"
 #include "vector2d.h"
 
+namespace day17
+{
+
 struct Rect
 {
 	Rect(int left, int lower, int right, int upper) : lowerLeft{ left, lower }, upperRight{ right, upper } {}
@@ -192,23 +202,20 @@ public:
 		return (location.x < 0 || location.x + bounds.x > 6);
 	}
 
+	const std::vector<Rect>& colliders() const
+	{
+		return primitives;
+	}
+
 };
 
+// Owns the rocks too, they're all freed in one go with its pool
 class CollisionCollection
 {
 public: 
-	~CollisionCollection()
+	Rock* make(int x, int y, std::vector<Rect> &prims)
 	{
-		for (auto &&bucket : m_rocks)
-		{
-			for (auto *rock : bucket)
-			{
-				if (--(rock->pointersTo) == 0)
-				{
-					delete rock;
-				}
-			}
-		}
+		return m_pool.make(x, y, prims);
 	}
 
 	using bucket_t = std::vector<Rock*>;
@@ -218,22 +225,22 @@ public:
 	int lowestPoint{ 0 };
 	long long cummulativeHeight{ 0 };
 
+	// Every settled cell as a bit, a row of the 7 wide chamber in each row's one word
+	// so a rock's checked against the settled ones a row of each of its rects at a time, not rock against rock
+	// Rocks deleted from the buckets stay here, but they're only ever below where anything can reach now
 	bool collides(Rock *rock) const
 	{
-		auto lowerBucket{ rock->location.y };
-		auto upperBucket{ rock->boundingRect().top() };
-
-		for (auto i{ heightToIndex(lowerBucket) }; i <= heightToIndex(upperBucket); ++i)
-		{
-			for (auto *otherRock : m_rocks[i])
+		bool bCollides{ false };
+		forEachSpan(*rock, [this, &bCollides](int y, BitGrid::word_t span)
 			{
-				if (rock->collides(*otherRock))
-				{
-					return true;
-				}
-			}
-		}
-		return false;
+				bCollides = bCollides || (y < m_settled.height() && (m_settled.row(y)[0] & span));
+			});
+		return bCollides;
+	}
+
+	bool occupied(const Vector2d &point) const
+	{
+		return m_settled.inBounds(point.x, point.y) && m_settled.test(point.x, point.y);
 	}
 
 	Rock* collides(const Vector2d &point) const
@@ -256,7 +263,7 @@ public:
 			{
 				if (--(rock->pointersTo) == 0)
 				{
-					delete rock;
+					m_pool.destroy(rock);
 				}
 			}
 		}
@@ -292,13 +299,16 @@ public:
 			{
 				if (!list.contains(rock) && --(rock->pointersTo) <= 0)
 				{
-					delete rock;
+					m_pool.destroy(rock);
 				}
 			}
 
 			bucket.clear();
 		}
 
+		// Only the kept rocks' bits, push refills them
+		m_settled.resize(0);
+
 		for (auto *rock : list)
 		{
 			rock->pointersTo = 0;
@@ -329,6 +339,9 @@ public:
 			bucket.clear();
 		}
 
+		// The settled bits all move too, push refills them
+		m_settled.resize(0);
+
 		for (auto *rock : allRocks)
 		{
 			rock->translate(0, -lowestPoint);
@@ -347,7 +360,7 @@ public:
 			{
 				if(!list.contains(rock) && --(rock->pointersTo) <= 0)
 				{
-					delete rock;
+					m_pool.destroy(rock);
 				}
 			}
 
@@ -355,7 +368,10 @@ public:
 		}
 
 		highestPoint -= lowestPoint;
-		
+
+		// Only the kept rocks' bits, moved down, push refills them
+		m_settled.resize(0);
+
 		for (auto *rock : list)
 		{
 			rock->pointersTo = 0;
@@ -376,7 +392,7 @@ public:
 			{
 				if (--(rock->pointersTo) == 0)
 				{
-					delete rock;
+					m_pool.destroy(rock);
 				}
 			}
 			m_rocks[i].clear();
@@ -390,7 +406,7 @@ public:
 		Rock* rock;
 		RockLinkedList *next = nullptr;
 
-		RockLinkedList* push(Rock *newRock)
+		RockLinkedList* push(Rock *newRock, mem::Pool<RockLinkedList> &pool)
 		{
 			if (!rock)
 			{
@@ -399,13 +415,22 @@ public:
 			}
 			else
 			{
-				return new RockLinkedList(newRock, this);
+				return pool.make(newRock, this);
 			}
 		}
 	};
 
 	void push(Rock* newRock)
 	{
+		if (m_settled.height() <= newRock->top())
+		{
+			m_settled.resize(newRock->top() + 1);
+		}
+		forEachSpan(*newRock, [this](int y, BitGrid::word_t span)
+			{
+				m_settled.row(y)[0] |= span;
+			});
+
 		auto lowBucket{ heightToIndex(newRock->location.y) };
 		auto highBucket{ heightToIndex(newRock->top()) };
 
@@ -431,10 +456,27 @@ public:
 	}
 
 private:
+	mem::Pool<Rock> m_pool;
 	container_t m_rocks;
+	BitGrid m_settled{ 7, 0 };
 
 	int m_ySeparation{ 100 };
 
+	// fnc(y, bits) for each row of each of the rock's rects, with a bit set for each x it covers
+	template<typename Fnc>
+	static void forEachSpan(const Rock &rock, Fnc &&fnc)
+	{
+		for (const auto &collider : rock.colliders())
+		{
+			const Rect rect{ collider.translate(rock.location.x, rock.location.y) };
+			const BitGrid::word_t span{ ((BitGrid::word_t{ 1 } << (rect.right() - rect.left() + 1)) - 1) << rect.left() };
+			for (int y{ rect.bottom() }; y <= rect.top(); ++y)
+			{
+				fnc(y, span);
+			}
+		}
+	}
+
 	size_t heightToIndex(long height) const
 	{
 		return static_cast<size_t>(height / m_ySeparation);
@@ -528,6 +570,45 @@ void drawRange(Vector2d lowerLeft, Vector2d upperRight, const CollisionCollectio
 	DL("");
 }
 
+// Top of the tower for --frames, cell pixels square, the walls grey and the rock that just landed red
+// Scrolls half a screen at a time so most frames only change a few rows
+void drawTower(Image8 &canvas, const CollisionCollection &rocks, Rock* landed, int cell)
+{
+	const int rows{ canvas.height() / cell };
+	const int page{ rows / 2 };
+	const int top{ rocks.highestPoint + 4 };
+	const int bottom{ top < rows ? 0 : ((top - rows) / page + 1) * page };
+
+	for (int row{ 0 }; row < rows; ++row)
+	{
+		const int y{ bottom + row };
+		for (int x{ -1 }; x <= 7; ++x)
+		{
+			Color color{};
+			if (x == -1 || x == 7)
+			{
+				color = { 0.5f, 0.5f, 0.5f };
+			}
+			else if (landed->collides(x, y))
+			{
+				color = { 1.f, 0.f, 0.f };
+			}
+			else if (rocks.collides({ x, y }))
+			{
+				color = { 0.6f, 0.4f, 0.2f };
+			}
+
+			for (int py{ row * cell }; py < (row + 1) * cell; ++py)
+			{
+				for (int px{ (x + 1) * cell }; px < (x + 2) * cell; ++px)
+				{
+					canvas.setColor(color, px, py);
+				}
+			}
+		}
+	}
+}
+
 // State of floor and indices of cycling rocks & jets, + height
 struct RocksState
 {
@@ -542,20 +623,10 @@ struct RocksState
 	long long highPoint;
 	long long count;
 
+	// Same things operator< looks at - this used to break out of the floor loop and say true anyway
 	friend bool operator==(const RocksState &lhs, const RocksState &rhs)
 	{
-		if (lhs.highFloor.size() == rhs.highFloor.size() && lhs.jetIndex == rhs.jetIndex && lhs.rockIndex == rhs.rockIndex)
-		{
-			for (size_t i{ 0 }; i < lhs.highFloor.size(); ++i)
-			{
-				if (lhs.highFloor[i] != rhs.highFloor[i])
-				{
-					break;
-				}
-			}
-			return true;
-		}
-		return false;
+		return lhs.jetIndex == rhs.jetIndex && lhs.rockIndex == rhs.rockIndex && lhs.highFloor == rhs.highFloor;
 	}
 
 	// Less than required for storing in an ordered list
@@ -584,11 +655,25 @@ struct RocksState
 	}
 };
 
+// For a flat::Set of previous states, hashes what operator== compares
+struct RocksStateHash
+{
+	size_t operator()(const RocksState &state) const noexcept
+	{
+		std::uint64_t hash{ vec::mix((static_cast<std::uint64_t>(state.jetIndex) << 3) ^ state.rockIndex) };
+		for (const auto &row : state.highFloor)
+		{
+			hash = vec::mix(hash ^ row.to_ullong());
+		}
+		return hash;
+	}
+};
+
 // Now that you have a floor checker, you can use it to purge every rock not touching it
 RocksState::floor_t wallToWall(Vector2d start, CollisionCollection &rocks)
 {
 	// Find first settled (non-wall) rock
-	while (!(rocks.collides(start)))
+	while (!(rocks.occupied(start)))
 	{
 		start.y -= 1;
 	}
@@ -615,9 +700,9 @@ RocksState::floor_t wallToWall(Vector2d start, CollisionCollection &rocks)
 
 	while (curr.x < 6)
 	{
-		if (auto *leftCollider{ rocks.collides(curr + left) }; !leftCollider)
+		if (!rocks.occupied(curr + left))
 		{
-			if (auto *frontCollider{ rocks.collides(curr + dir) }; frontCollider)
+			if (rocks.occupied(curr + dir))
 			{
 				// floorRocks.insert(frontCollider);
 
@@ -709,7 +794,10 @@ namespace Puzzle1
 		}
 
 		std::string jets;
-		std::getline(inf, jets);
+		{
+			PROFILE("parse");
+			std::getline(inf, jets);
+		}
 
 		std::vector<Rect> Horizontal4{ { 0, 0, 3, 0 } }; // ####
 
@@ -745,9 +833,12 @@ namespace Puzzle1
 
 		settledRocksPartitioned.push_back(std::vector<Rock*>{});
 
-		std::vector<Rock*> walls{ new Rock{ -1, 0, wallsCollider } , new Rock{ 7, 0, wallsCollider } };
+		// Every rock's from here and they all go with it, no deleting them once they're done with
+		mem::Pool<Rock> rockPool;
 
-		settledRocksPartitioned[0].push_back( new Rock{ 0, 0, floorCollider });
+		std::vector<Rock*> walls{ rockPool.make(-1, 0, wallsCollider) , rockPool.make(7, 0, wallsCollider) };
+
+		settledRocksPartitioned[0].push_back(rockPool.make(0, 0, floorCollider));
 		
 		int highestPoint{ 0 };
 
@@ -757,9 +848,10 @@ namespace Puzzle1
 		const int totalRocks{ 2022 };
 		int rockCount{ 0 };
 
+		PROFILE("simulate");
 		while (++rockCount <= totalRocks)
 		{
-			Rock* testrock{ new Rock{ 2, highestPoint + 4, *rockShape } };
+			Rock* testrock{ rockPool.make(2, highestPoint + 4, *rockShape) };
 
 			logger << 'r' << rockCount << ":s" << rockShape - collisionShapes.begin() << ':';
 
@@ -896,17 +988,6 @@ namespace Puzzle1
 			}
 		}
 
-		for (auto &&rockCont : settledRocksPartitioned)
-		{
-			for (auto *rock : rockCont)
-			{
-				if (--(rock->pointersTo) <= 0)
-				{
-					delete rock;
-				}
-			}
-		}
-
 		utils::printAnswer("height of rock tower after 2022 rocks have fallen: ", highestPoint);
 	}
 };
@@ -930,7 +1011,10 @@ namespace Puzzle2
 		}
 
 		std::string jets;
-		std::getline(inf, jets);
+		{
+			PROFILE("parse");
+			std::getline(inf, jets);
+		}
 
 		std::vector<Rect> Horizontal4{ { 0, 0, 3, 0 } }; // ####
 
@@ -959,7 +1043,7 @@ namespace Puzzle2
 		std::vector<Rect> floorCollider{ { 0, 0, 6, 0 } }; 
 
 		CollisionCollection rocks;
-		rocks.push(new Rock{ 0, 0, floorCollider });
+		rocks.push(rocks.make(0, 0, floorCollider));
 
 		size_t rockShape{ 0 };
 		size_t jet{ 0 };
@@ -967,17 +1051,22 @@ namespace Puzzle2
 		const long long totalRocks{ 1000000000000 };
 		long long rockCount{ 0 };
 
-		std::set<RocksState> previousStates;
+		flat::Set<RocksState, RocksStateHash> previousStates;
 
 		long long skipRepeatChecksFor{ static_cast<long long>(jets.length()) };
 
 		bool bRepetitionFound{ false };
+
+		const int cell{ 4 };
+		auto sink{ frames::record("tower", 9 * cell, 64 * cell) }; // With --frames, a frame per rock
+
+		PROFILE("simulate");
 		while (++rockCount <= totalRocks)
 		{
 			// Foolishly I left the purging stuff in the floor checker
 			// highest point needs to be adjusted when purging floors
 			// haven't been able to get the right answer with purging and shifting
-			Rock* testrock{ new Rock{ 2, rocks.highestPoint + 4, collisionShapes[rockShape] } };
+			Rock* testrock{ rocks.make(2, rocks.highestPoint + 4, collisionShapes[rockShape]) };
 
 			logger << 'r' << rockCount << ":s" << rockShape << ':';
 
@@ -1031,17 +1120,22 @@ namespace Puzzle2
 				rocks.highestPoint = testrock->top();
 			}
 
+			if (sink)
+			{
+				sink->frame([&](Image8 &canvas) { drawTower(canvas, rocks, testrock, cell); });
+			}
+
 			// drawRange({ -1, -1 }, { 8, rocks.highestPoint }, rocks, testrock);
 
 			RocksState newState{ rockShape, jet, wallToWall({ 0, rocks.highestPoint }, rocks), rocks.cummulativeHeight, rockCount };
 			if (!bRepetitionFound && rockCount > skipRepeatChecksFor)
 			{
-				if (previousStates.contains(newState))
+				if (const auto previous{ previousStates.find(newState) }; previous != previousStates.end())
 				{
 					bRepetitionFound = true;
 
 					DL("states matched:\n");
-					auto patternStart{ *(previousStates.find(newState)) };
+					const auto &patternStart{ *previous };
 					DL("jet index:   " << patternStart.jetIndex << " vs " << newState.jetIndex);
 					DL("shape index: " << patternStart.rockIndex << " vs " << newState.rockIndex);
 					DL("rocks wall-wall span: ");
@@ -1095,22 +1189,19 @@ namespace Puzzle2
 	}
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
-
-	const std::string input{ utils::inputFile(__FILE__) };
-
-	try
+	void input(std::ostream &out, double scale, generate::Random &random)
 	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
-	{
-		std::cerr << e.what() << '\n';
+		std::string jets(generate::count(10091, scale), '<');
+		for (char &jet : jets)
+		{
+			jet = random.pick("<>");
+		}
+		out << jets << '\n';
 	}
+};
 
-	return 0;
+} // namespace day17
 
-}
+AOC_MAIN(day17)
@@ -1,134 +1,79 @@
 // --- Day 18: Boiling Boulders ---
 
 #include <array>
-#include <deque>
+#include <cmath>
 #include <exception>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#include "bitgrid.h"
 #include "debug.h"	// Enable debug macros with -d flag
+#include "generate.h"
+#include "grid.h"
 #include "log.h"	// Enable with -l flag
+#include "registry.h"
+#include "scan.h"
 #include "utils.h"
 #include "vector3d.h"
 
-struct LavaMap
+namespace day18
 {
-	using cont_t = std::vector<std::vector<std::vector<int>>>;
-	LavaMap(int sizeX, int sizeY, int sizeZ) :
-		map{ ST(sizeX), std::vector<std::vector<int>>{ ST(sizeY), std::vector<int>(ST(sizeZ), 0) } }
-	{
-	}
-	LavaMap(const Vector3d &v3) : LavaMap(v3.x, v3.y, v3.z) {}
 
-	int& operator[](const Vector3d &v3)
+// The lava as bits, x along a row and a row for each y, z (so a step in z is size.y rows)
+// with a layer of air all the way round, which is where part 2's flood starts
+struct LavaBits
+{
+	LavaBits(const std::string &input)
 	{
-		return map[ST(v3.x)][ST(v3.y)][ST(v3.z)];
-	}
+		Vector3d largest{ 0 };
+		scan::Ints<int> xyz; // Reused for every line
+		// First find the largest value in each dimension to size the grid in one go
+		utils::doOnSplit(input, "\n", [&largest, &xyz](std::string_view line)
+		{ 
+			Vector3d coord{ xyz.split(line, ",") };
+			largest.xyzMax(coord);
+		});
 
-	std::vector<std::vector<int>>& operator[](int i)
-	{
-		return map[ST(i)];
-	}
+		size = largest + 3;
+		bits = BitGrid{ size.x, size.y * size.z };
 
-	bool inBounds(const Vector3d &co)
-	{
-		return co.x >= 0 && co.x < TOI(map.size()) &&
-			   co.y >= 0 && co.y < TOI(map[0].size()) &&
-			   co.z >= 0 && co.z < TOI(map[0][0].size());
-	}
-
-	// A for each to keep these nested fors out of my sight
-	// int arg == value of coord in map, Vector3d& arg is the coord itself
-	void forEach(std::function<void(int, Vector3d&)> fnc, const Vector3d &startOffset = 0, const Vector3d &endOffset = 0)
-	{
-		for (size_t x{ ST(startOffset.x) }; x < map.size() - ST(endOffset.x); ++x)
-		{
-			for (size_t y{ ST(startOffset.y) }; y < map[0].size() - ST(endOffset.y); ++ y)
-			{
-				for (size_t z{ ST(startOffset.z) }; z < map[0][0].size() - ST(endOffset.z); ++z)
-				{
-					Vector3d coord{ x, y, z };
-					fnc((*this)[coord], coord);	
-				}
-			}
-		}
-	}
+		utils::doOnSplit(input, "\n", [this, &xyz](std::string_view line)
+		{ 
+			// We add 1 to input coords x, y & z because we reserve 0 for the air round the outside
+			const Vector3d coord{ Vector3d{ xyz.split(line, ",") } + 1 };
+			bits.set(coord.x, coord.z * size.y + coord.y);
+		});
 
-	// For each with predicate (I used this one for part 1)
-	// fnc is passed the coordinate of truthy predicates as a Vector3d
-	void forEachThat(std::function<bool(int)> pred, std::function<void(Vector3d&)> fnc, const Vector3d &startOffset = 0, const Vector3d &endOffset = 0)
-	{
-		for (size_t x{ ST(startOffset.x) }; x < map.size() - ST(endOffset.x); ++x)
+		// How far each face's neighbour is along a row and in rows
+		for (size_t i{ 0 }; i < grid::faces.size(); ++i)
 		{
-			for (size_t y{ ST(startOffset.y) }; y < map[0].size() - ST(endOffset.y); ++ y)
-			{
-				for (size_t z{ ST(startOffset.z) }; z < map[0][0].size() - ST(endOffset.z); ++z)
-				{
-					Vector3d coord{ x, y, z };
-					if (pred((*this)[coord]))
-					{
-						fnc(coord);	
-					}
-				}
-			}
+			shifts[i] = { grid::faces[i].x, grid::faces[i].y + grid::faces[i].z * size.y };
 		}
 	}
 
-	cont_t map;
-
+	Vector3d size;
+	BitGrid bits;
+	std::array<std::pair<int, int>, grid::faces.size()> shifts{};
 };
 
 namespace Puzzle1
 {
 	void solve(const std::string& infile)
 	{
-		std::string input{ utils::bufferInput(infile) };
-
-		// Map out the entirety of the bounding cuboid around the lava
-		// It's quick this way!
-
-		Vector3d largest{ 0 };
-		// First find the largest value in each dimension to initialise the cube list in one go
-		utils::doOnSplit(input, "\n", [&largest](std::string_view line)
-		{ 
-			Vector3d coord{ utils::splitInts(line, ",") };
-			largest.xyzMax(coord);
-		});
-
-		// Vector of vector of vectors of int for [x][y][z] random access
-		LavaMap map3d{ largest + 1 };
-
-		// Set each lava coordinate to 1 in our map3d list
-		utils::doOnSplit(input, "\n", [&map3d](std::string_view line)
-		{ 
-			Vector3d coord{ utils::splitInts(line, ",") };
-			map3d[coord] = 1;
-		});
+		const LavaBits lava{ utils::bufferInput(infile) };
 
-		int surfaceArea{ 0 };
-
-		auto isLava{ [](int val){ return val == 1; } };
-
-		auto addSurfaceArea { [&surfaceArea, &map3d](Vector3d &coord){
-			int sides{ 6 };
-			const std::array<Vector3d, 6> adjacent{ { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } } };
-			for (auto &&dir : adjacent)
-			{
-				auto neighbour{ coord + dir };
-				if (map3d.inBounds(neighbour) && map3d[coord + dir] == 1)
-				{
-					--sides;
-				}
-			}
-			surfaceArea += sides;
-		} };
-		
-		// Mmm that's nice syntax, that's the good stuff
-		map3d.forEachThat(isLava, addSurfaceArea);
+		// Every cube has 6 sides, less one for each side touching another cube
+		// Lava shifted one step in a direction and anded with the lava is every cube with a neighbour that way, a word of cubes at a time
+		size_t surfaceArea{ 6 * lava.bits.count() };
+		for (const auto &[dx, dy] : lava.shifts)
+		{
+			surfaceArea -= lava.bits.countAndShifted(lava.bits, dx, dy);
+		}
 
 		utils::printAnswer("surface area of lava droplet: ", surfaceArea);
 
@@ -140,98 +85,71 @@ namespace Puzzle2
 {
 	void solve(const std::string& infile)
 	{
-		// Map a cuboid, enveloping the extents of the input coordinates such that the lava is entirely contained 
-		// (Size is 24 x 23 x 24 for input data)
-		// Initialise all values to 0 (0 can signify empty space initially)
-		
-		// Using input coordinates, make all lava-occupied spaces 1 (0 == nothing, 1 == lava)
-		// Starting from the outside, give every point which is not occupied by lava some other value (2),
-		// queueing neighbours with values of 0, changing those to 2 (2 == exterior space)
+		// Starting from a corner of the air round the outside, flood the exterior as far as it goes in each direction in turn,
+		// stopping at lava, until it stops growing. Each direction's a sweep of shifts and ors over 64 bit words
+		// rather than a queue of one cube at a time, and it only takes as many rounds as the exterior has corners to get round
 
-		// The exterior surface area will then be incremented for every neighbour of a 2 space which 
-		// has a value of 1 - ie everywhere exterior coords are adjacent to lava coords
+		// The exterior surface area is then every side of lava with exterior next to it
 
-		// This full map (vector of vectors of vectors) is a lot quicker than what I did for part 1 btw
-		// Do it there too?
+		const LavaBits lava{ utils::bufferInput(infile) };
 
-		std::string input{ utils::bufferInput(infile) };
+		BitGrid exterior{ lava.bits.width(), lava.bits.height() };
+		exterior.set(0, 0);
 
-		Vector3d largest{ 0 };
-		// First find the largest value in each dimension to initialise the cube list in one go
-		utils::doOnSplit(input, "\n", [&largest](std::string_view line)
-		{ 
-			Vector3d coord{ utils::splitInts(line, ",") };
-			largest.xyzMax(coord);
-		});
+		// A step in y from the last y of one z lands on the first y of the next, but those rows are both the air round the outside anyway
+		BitGrid last;
+		do
+		{
+			last = exterior;
+			for (const auto &[dx, dy] : lava.shifts)
+			{
+				exterior.spread(dx, dy, lava.bits);
+			}
+		} while (!(exterior == last));
 
-		// Vector of vector of vectors of int for [x][y][z] random access
-		LavaMap map3d{ largest + 3 };
+		size_t outerSurface{ 0 };
+		for (const auto &[dx, dy] : lava.shifts)
+		{
+			outerSurface += lava.bits.countAndShifted(exterior, dx, dy);
+		}
 
-		// Set each lava coordinate to 1 in our map3d list
-		utils::doOnSplit(input, "\n", [&map3d](std::string_view line)
-		{ 
-			Vector3d coord{ utils::splitInts(line, ",") };
-			// We add 1 to input coords x, y & z because we reserve [0] for exterior spaces
-			map3d[coord + 1] = 1;
-		});
+		utils::printAnswer("exterior surface area of lava droplet: ", outerSurface);
 
-		// Starting from origin (which we have ensured is an exterior (non-lava) coordinate)
-		// Breadth-first search neighbouring spaces with value 0,
-		// set them to 2 to signify exterior coordinates (& avoid re-adding them to the queue)
-		std::deque<Vector3d> queue{ { 0, 0, 0 } };
-		map3d[Vector3d{0, 0, 0}] = 2;
+	}
+};
 
-		int outerSurface{ 0 };
+namespace Generate
+{
+	// A lumpy ball of lava with air pockets inside, the box it's in growing with the cube root of scale
+	void input(std::ostream &out, double scale, generate::Random &random)
+	{
+		const int side{ static_cast<int>(generate::count(20, std::cbrt(scale), 4)) };
+		const double centre{ (side - 1) / 2.0 };
 
-		while (!queue.empty())
+		std::vector<Vector3d> cubes;
+		for (int x{ 0 }; x < side; ++x)
 		{
-			auto cur{ queue.front() };
-			queue.pop_front();
-
-			const std::vector<Vector3d> adjacent{ { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } } };
-			
-			for (auto &&dir : adjacent)
+			for (int y{ 0 }; y < side; ++y)
 			{
-				auto neighbour{ cur + dir };
-
-				if (map3d.inBounds(neighbour))
+				for (int z{ 0 }; z < side; ++z)
 				{
-					// Queue neighbouring exterior spaces
-					if (!map3d[neighbour])
-					{
-						map3d[neighbour] = 2;
-						queue.push_back(neighbour);
-					}
-					else if (map3d[neighbour] == 1)
+					const double distance{ std::sqrt((x - centre) * (x - centre) + (y - centre) * (y - centre) + (z - centre) * (z - centre)) };
+					if (distance < centre * (0.75 + 0.25 * static_cast<double>(random.range(0, 100)) / 100.0) && random.chance(0.85))
 					{
-						// Exterior coordinates adjacent to lava increment surface area
-						++outerSurface;
+						cubes.push_back({ x, y, z });
 					}
 				}
 			}
 		}
+		random.shuffle(cubes);
 
-		utils::printAnswer("exterior surface area of lava droplet: ", outerSurface);
-
+		for (const auto &cube : cubes)
+		{
+			out << cube.x << ',' << cube.y << ',' << cube.z << '\n';
+		}
 	}
 };
 
-int main(int argc, char* argv[])
-{
-	flags::set(argc, argv);
-
-	const std::string input{ utils::inputFile(__FILE__) };
-
-	try
-	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
-	{
-		std::cerr << e.what() << '\n';
-	}
-
-	return 0;
+} // namespace day18
 
-}
+AOC_MAIN(day18)
@@ -12,10 +12,16 @@
 #include <string_view>
 
 #include "debug.h"	// Enable debug macros with -d flag
+#include "generate.h"
 #include "log.h"	// Enable with -l flag
+#include "profile.h"	// Enable with -p flag
+#include "registry.h"
 #include "utils.h"
 #include "timer.h"
 
+namespace day19
+{
+
 const std::array<int, 35> triangularNumbers { 0, 1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 66, 78, 91, 105, 120,136, 153, 171, 190, 210, 231, 253, 276, 300, 325, 351, 378, 406, 435, 465, 496, 528, 561, 595 };
 
 // Indices for each resource - used like an enum but I don't have to cast anything this way
@@ -589,6 +595,7 @@ namespace Puzzle1
 		
 		t.reset();
 
+		PROFILE("search");
 		while (blueprint.length())
 		{
 			Blueprint bp{ blueprint };
@@ -631,6 +638,7 @@ namespace Puzzle2
 
 		t.reset();
 
+		PROFILE("search");
 		while (--count >= 0)
 		{
 			Blueprint bp{ blueprint };
@@ -647,22 +655,22 @@ namespace Puzzle2
 	}
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
-
-	const std::string input{ utils::inputFile(__FILE__) };
-
-	try
+	// Costs in the same ranges as the puzzle's, part 2 only looks at the first three
+	void input(std::ostream &out, double scale, generate::Random &random)
 	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
-	{
-		std::cerr << e.what() << '\n';
+		const size_t blueprints{ generate::count(30, scale, 3) };
+		for (size_t id{ 1 }; id <= blueprints; ++id)
+		{
+			out << "Blueprint " << id << ": Each ore robot costs " << random.range(2, 4)
+				<< " ore. Each clay robot costs " << random.range(2, 4)
+				<< " ore. Each obsidian robot costs " << random.range(2, 4) << " ore and " << random.range(5, 20)
+				<< " clay. Each geode robot costs " << random.range(2, 4) << " ore and " << random.range(7, 20) << " obsidian.\n";
+		}
 	}
+};
 
-	return 0;
+} // namespace day19
 
-}
+AOC_MAIN(day19)
@@ -7,11 +7,18 @@
 #include <string>
 #include <vector>
 
+#include "arena.h"
 #include "debug.h"	// Enable debug macros with -d flag
+#include "generate.h"
 #include "log.h"	// Enable with -l flag
+#include "registry.h"
+#include "scan.h"
 #include "timer.h"
 #include "utils.h"
 
+namespace day20
+{
+
 // Doubly-linked - you could go single and convert negative moves to +ve though
 template<typename T>
 struct Node
@@ -126,14 +133,17 @@ namespace Puzzle1
 		std::vector<Node<int>*> nodeOrder;
 		nodeOrder.reserve(inputLines.size());
 
-		nodeOrder.push_back(new Node<int>{ std::stoi(inputLines[0]), 0 });
+		// One block with room for every node (plus a bit for the block header), so they sit one after another and all go with the arena
+		mem::Arena nodes{ inputLines.size() * sizeof(Node<int>) + 64 };
+
+		nodeOrder.push_back(nodes.make<Node<int>>(scan::toInt(inputLines[0]), nullptr));
 		
 		Node<int> *zero{ nodeOrder[0]->data == 0 ? nodeOrder[0] : nullptr };
 
 		for (size_t i{ 1 }; i < inputLines.size(); ++i)
 		{
 			// auto newNode{ new Node{ std::stoi(inputLines[i]) } };
-			auto newNode{ new Node{ std::stoi(inputLines[i]), nodeOrder[i - 1] } };
+			auto newNode{ nodes.make<Node<int>>(scan::toInt(inputLines[i]), nodeOrder[i - 1]) };
 			nodeOrder[i - 1]->next = newNode;
 			nodeOrder.push_back(newNode);
 
@@ -186,7 +196,9 @@ namespace Puzzle2
 
 		const long key{ 811589153 };
 
-		nodeOrder.push_back(new Node<long long>{ std::stoll(inputLines[0]) * key, 0 });
+		mem::Arena nodes{ inputLines.size() * sizeof(Node<long long>) + 64 };
+
+		nodeOrder.push_back(nodes.make<Node<long long>>(scan::toInt<long long>(inputLines[0]) * key, nullptr));
 		
 		;
 		Node<long long> *zero{ nodeOrder[0]->data == 0 ? nodeOrder[0] : nullptr };
@@ -194,7 +206,7 @@ namespace Puzzle2
 		for (size_t i{ 1 }; i < inputLines.size(); ++i)
 		{
 			// auto newNode{ new Node{ std::stoi(inputLines[i]) } };
-			auto newNode{ new Node{ std::stoll(inputLines[i]) * key, nodeOrder[i - 1] } };
+			auto newNode{ nodes.make<Node<long long>>(scan::toInt<long long>(inputLines[i]) * key, nodeOrder[i - 1]) };
 			nodeOrder[i - 1]->next = newNode;
 			nodeOrder.push_back(newNode);
 
@@ -239,24 +251,25 @@ namespace Puzzle2
 	}
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
-
-	const std::string input{ utils::inputFile(__FILE__) };
-
-	DL("input: " << input); 
-
-	try
+	// Exactly one 0, like the puzzle
+	void input(std::ostream &out, double scale, generate::Random &random)
 	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
-	{
-		std::cerr << e.what() << '\n';
+		const size_t numbers{ generate::count(5000, scale, 2) };
+		const size_t zeroAt{ random.index(numbers) };
+		for (size_t i{ 0 }; i < numbers; ++i)
+		{
+			int number{ 0 };
+			while (i != zeroAt && !number)
+			{
+				number = random.range(-9999, 9999);
+			}
+			out << number << '\n';
+		}
 	}
+};
 
-	return 0;
+} // namespace day20
 
-}
+AOC_MAIN(day20)
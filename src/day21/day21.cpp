@@ -1,5 +1,8 @@
 // --- Day 21: Monkey Math ---
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <exception>
 #include <forward_list>
 #include <fstream>
@@ -9,16 +12,37 @@
 #include <set>
 #include <string>
 #include <string_view>
-#include <unordered_map>
-#include <unordered_set>
+#include <tuple>
 #include <utility>
 #include <vector>
 
 #include "debug.h"	// Enable debug macros with -d flag
+#include "flatmap.h"
+#include "generate.h"
 #include "log.h"	// Enable with -l flag
+#include "registry.h"
 #include "utils.h"
 
+namespace day21
+{
+
 using monkeynum_t = long;
+using monkeyid_t = std::uint32_t;
+
+// Names are always 4 letters, so they fit in a uint32 - cheaper to hash and compare than strings
+monkeyid_t monkeyId(const char *name)
+{
+	return static_cast<monkeyid_t>(static_cast<unsigned char>(name[0])) |
+		static_cast<monkeyid_t>(static_cast<unsigned char>(name[1])) << 8 |
+		static_cast<monkeyid_t>(static_cast<unsigned char>(name[2])) << 16 |
+		static_cast<monkeyid_t>(static_cast<unsigned char>(name[3])) << 24;
+}
+
+// And back again for printing
+std::string monkeyName(monkeyid_t id)
+{
+	return { static_cast<char>(id), static_cast<char>(id >> 8), static_cast<char>(id >> 16), static_cast<char>(id >> 24) };
+}
 
 monkeynum_t operationResult(monkeynum_t l, monkeynum_t r, char op)
 {
@@ -124,14 +148,15 @@ namespace Puzzle1
 	{
 		auto inlines{ utils::bufferLines(infile) }; 
 
-		std::unordered_map<std::string, monkeynum_t> monkeyMap;
+		flat::Map<monkeyid_t, monkeynum_t> monkeyMap;
+		monkeyMap.reserve(inlines.size());
 
 		// Get all the monkeys which don't depend on other monkeys (just numbers)
 		for (size_t i{ 0 }; i < inlines.size(); ++i)
 		{
 			if (inlines[i][6] <= '9')
 			{
-				monkeyMap[inlines[i].substr(0, 4)] = std::atoi(inlines[i].data() + 6);
+				monkeyMap[monkeyId(inlines[i].data())] = std::atoi(inlines[i].data() + 6);
 			}
 		}
 
@@ -142,20 +167,18 @@ namespace Puzzle1
 			bAllDone = true;
 			for (size_t i{ 0 }; i < inlines.size(); ++i)
 			{
-				std::string id{ inlines[i].substr(0, 4) };
+				const monkeyid_t id{ monkeyId(inlines[i].data()) };
 
 				if (inlines[i][6] >= 'A')
 				{
 					if (monkeyMap.contains(id)) continue;
 
-					const std::string left{ inlines[i].substr(6, 4) };
-					if (monkeyMap.contains(left))
+					if (const auto left{ monkeyMap.find(monkeyId(inlines[i].data() + 6)) }; left != monkeyMap.end())
 					{
-						const std::string right{ inlines[i].substr(13, 4) };
-						if (monkeyMap.contains(right))
+						if (const auto right{ monkeyMap.find(monkeyId(inlines[i].data() + 13)) }; right != monkeyMap.end())
 						{
 							char op{ inlines[i][11] };
-							monkeyMap[id] = operationResult(monkeyMap[left], monkeyMap[right], op);
+							monkeyMap[id] = operationResult(left->second, right->second, op);
 							continue;
 						}
 					}
@@ -167,11 +190,11 @@ namespace Puzzle1
 		Logger log{};
 		for (auto &&nm : monkeyMap)
 		{
-			DL(nm.first << " = " << nm.second);
-			log << nm.first << " = " << nm.second << '\n';
+			DL(monkeyName(nm.first) << " = " << nm.second);
+			log << monkeyName(nm.first) << " = " << nm.second << '\n';
 		}
 
-		utils::printAnswer("monkey named root: \"", monkeyMap["root"], "\"");
+		utils::printAnswer("monkey named root: \"", monkeyMap[monkeyId("root")], "\"");
 	}
 };
 
@@ -181,11 +204,14 @@ namespace Puzzle2
 	{
 		auto inlines{ utils::bufferLines(infile) }; 
 
-		std::unordered_map<std::string_view, Monkey*> constMonkeys;
+		const monkeyid_t humn{ monkeyId("humn") };
+		const monkeyid_t root{ monkeyId("root") };
+
+		flat::Map<monkeyid_t, Monkey*> constMonkeys;
+		constMonkeys.reserve(inlines.size());
 		// std::unordered_map<std::string, size_t> humnDependentMonkeys{  };
-		std::unordered_set<std::string_view> humnDependentMonkeyIds{}; // For quick id checks
-		// Can get rid of the string here? this fetches the whole input line anwyay
-		std::list<std::pair<std::string_view, size_t>> humnDependentIndices{ { "humn", 0 }}; // This gets popped later so the index doesn't matter
+		flat::Set<monkeyid_t> humnDependentMonkeyIds{}; // For quick id checks
+		std::list<std::pair<monkeyid_t, size_t>> humnDependentIndices{ { humn, 0 }}; // This gets popped later so the index doesn't matter
 
 		// Make list of monkeys which are affected by humn's value (in order)
 		bool bAllHumnAffectedFound{ true };
@@ -194,14 +220,14 @@ namespace Puzzle2
 			bAllHumnAffectedFound = true;
 			for (size_t i{ 0 }; i < inlines.size(); ++i)
 			{
-				std::string_view id{ inlines[i].data(), 4 };
+				const monkeyid_t id{ monkeyId(inlines[i].data()) };
 
 				if (inlines[i][6] >= 'A')
 				{
 					if (humnDependentMonkeyIds.contains(id)) continue;
 
-					std::string_view left{ inlines[i].data() + 6 , 4 };
-					std::string_view right{ inlines[i].data() + 13, 4 };
+					const monkeyid_t left{ monkeyId(inlines[i].data() + 6) };
+					const monkeyid_t right{ monkeyId(inlines[i].data() + 13) };
 					if (humnDependentIndices.back().first == left || humnDependentIndices.back().first == right)
 					{
 						humnDependentMonkeyIds.insert(id);
@@ -228,41 +254,40 @@ namespace Puzzle2
 			{
 				if (inlines[i][6] >= 'A')
 				{
-					std::string_view id{ inlines[i].data(), 4 };
+					const monkeyid_t id{ monkeyId(inlines[i].data()) };
 
 					if (constMonkeys.contains(id) || humnDependentMonkeyIds.contains(id))
 					{
 						continue;
 					}
-					
-					std::string_view left{ inlines[i].data() + 6, 4 };
-					std::string_view right{ inlines[i].data() + 13, 4 };
 
 					bMathsMonkeysResolved = false;
 
-					if (constMonkeys.contains(left) && constMonkeys.contains(right))
+					const auto left{ constMonkeys.find(monkeyId(inlines[i].data() + 6)) };
+					const auto right{ constMonkeys.find(monkeyId(inlines[i].data() + 13)) };
+
+					if (left != constMonkeys.end() && right != constMonkeys.end())
 					{
 						char op{ inlines[i][11] };
-						constMonkeys.insert({ id, new Monkey{ operationResult(constMonkeys.at(left)->get(), constMonkeys.at(right)->get(), op) } });
+						constMonkeys.insert({ id, new Monkey{ operationResult(left->second->get(), right->second->get(), op) } });
 					}
 				}
 			}
 		} while (!bMathsMonkeysResolved);
 
-		constMonkeys.erase("humn"); 
+		constMonkeys.erase(humn); 
 
 		// Work backwards from root's equality check to find humn's value
 		Solver solver;
 		for (auto i{ humnDependentIndices.rbegin() }; i != --humnDependentIndices.rend(); ++i )
 		{
-			auto &line{ inlines[i->second] };
-			char op{ i->first == "root" ? '=' : line[11] };
+			const auto line{ inlines[i->second] };
+			char op{ i->first == root ? '=' : line[11] };
 
-			std::string_view left{ line.data() + 6, 4 };
-			std::string_view right{ line.data() + 13, 4 };
+			const auto left{ constMonkeys.find(monkeyId(line.data() + 6)) };
 
-			bool bLeftConst{ constMonkeys.contains(left) };
-			monkeynum_t constMonkeyVal{ bLeftConst ? constMonkeys[left]->get() : constMonkeys[right]->get() };
+			bool bLeftConst{ left != constMonkeys.end() };
+			monkeynum_t constMonkeyVal{ bLeftConst ? left->second->get() : constMonkeys.at(monkeyId(line.data() + 13))->get() };
 
 			solver.next(op, constMonkeyVal, bLeftConst);
 		}
@@ -278,22 +303,116 @@ namespace Puzzle2
 	}
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
+	// The only monkeys that depend on humn are a chain from humn to root, each combining the one before it with a
+	// tree of monkeys that don't. Every step on the chain has to come out exactly for humn's answer so it can be worked backwards
+	// (no dividing unless it divides, nothing divided by the chain), numbers are kept small enough that shouting them fits in an int
+	struct Builder
+	{
+		generate::Random &random;
+		std::vector<std::string> lines;
+		std::set<std::string> names{ "root", "humn" };
 
-	const std::string input{ utils::inputFile(__FILE__) };
+		std::string name()
+		{
+			std::string newName(4, 'a');
+			do
+			{
+				for (char &ch : newName) ch = static_cast<char>('a' + random.index(26));
+			} while (!names.insert(newName).second);
+			return newName;
+		}
 
-	try
-	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
+		// A tree of size monkeys not depending on humn, returns its top monkey and what it shouts
+		std::pair<std::string, long> constant(size_t size)
+		{
+			const std::string top{ name() };
+			if (size < 3)
+			{
+				const long number{ random.range(1L, 20L) };
+				lines.push_back(top + ": " + std::to_string(number));
+				return { top, number };
+			}
+
+			const size_t leftSize{ 1 + random.index(size - 2) };
+			const auto [left, a]{ constant(leftSize) };
+			const auto [right, b]{ constant(size - 1 - leftSize) };
+
+			char op{ random.pick("+-*/") };
+			if ((op == '-' && a <= b) || (op == '/' && a % b) || (op == '*' && a * b > 1000000))
+			{
+				op = '+';
+			}
+			lines.push_back(top + ": " + left + ' ' + op + ' ' + right);
+			return { top, operationResult(a, b, op) };
+		}
+
+		// Adds one step to the chain from humn
+		std::pair<std::string, long> step(const std::string &chain, long value, size_t constantSize)
+		{
+			const auto [other, c]{ constant(constantSize) };
+			const long limit{ 1000000000 };
+
+			std::string allowed;
+			if (value + c < limit) allowed += '+';
+			if (value > c || c > value) allowed += '-';
+			if (value * c < limit) allowed += '*';
+			if (value % c == 0) allowed += '/';
+
+			const char op{ random.pick(allowed) };
+			// Any of them can have the chain on the right except taking it away from or dividing by a constant
+			bool bChainLeft{ op == '/' || random.chance(0.5) };
+			if (op == '-')
+			{
+				bChainLeft = value > c;
+			}
+
+			const std::string top{ name() };
+			lines.push_back(top + ": " + (bChainLeft ? chain : other) + ' ' + op + ' ' + (bChainLeft ? other : chain));
+			return { top, bChainLeft ? operationResult(value, c, op) : operationResult(c, value, op) };
+		}
+	};
+
+	void input(std::ostream &out, double scale, generate::Random &random)
 	{
-		std::cerr << "exception: " << e.what() << '\n';
+		// All the 4 letter names would be 456976, leave room for the random ones to not take forever to find
+		const size_t monkeys{ std::min<size_t>(generate::count(2401, scale, 20), 200000) };
+		const size_t chainLength{ std::min(generate::count(70, std::sqrt(scale), 2), monkeys / 4) };
+
+		Builder builder{ random, {} };
+		const long answer{ random.range(1000L, 5000L) };
+		builder.lines.push_back("humn: " + std::to_string(random.range(1L, 5000L))); // Not the answer, part 1 uses this
+
+		// Constant trees share what's left after the chain, root, and the 2 monkeys making its other side
+		size_t left{ monkeys - chainLength - 4 };
+		std::string chain{ "humn" };
+		long value{ answer };
+		for (size_t i{ 0 }; i < chainLength; ++i)
+		{
+			const size_t share{ left / (chainLength - i) };
+			std::tie(chain, value) = builder.step(chain, value, share);
+			left -= share;
+		}
+
+		// The other side of root is a constant tree plus whatever makes it match
+		const auto [other, c]{ builder.constant(std::max<size_t>(left, 1)) };
+		const std::string matchName{ builder.name() };
+		const std::string sideName{ builder.name() };
+		builder.lines.push_back(matchName + ": " + std::to_string(value > c ? value - c : c - value));
+		builder.lines.push_back(sideName + ": " + other + (value > c ? " + " : " - ") + matchName);
+
+		const bool bChainLeft{ random.chance(0.5) };
+		builder.lines.push_back("root: " + (bChainLeft ? chain : sideName) + " + " + (bChainLeft ? sideName : chain));
+
+		random.shuffle(builder.lines);
+		for (const auto &line : builder.lines)
+		{
+			out << line << '\n';
+		}
 	}
+};
 
-	return 0;
+} // namespace day21
 
-}
+AOC_MAIN(day21)
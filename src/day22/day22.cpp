@@ -1,20 +1,30 @@
 // --- Day 22: Monkey Map ---
 
+#include <algorithm>
+#include <array>
 #include <exception>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
-#include <map>
 #include <string>
 #include <string_view>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 #include "debug.h"	// Enable debug macros with -d flag
+#include "generate.h"
+#include "grid.h"
+#include "image.h"
 #include "log.h"	// Enable with -l flag
+#include "registry.h"
+#include "scan.h"
 #include "utils.h"
 #include "vector2d.h"
 
+namespace day22
+{
+
 int intlogarithm(int x, int base = 10, int logx = 0)
 {
 	if (x < base) return logx;
@@ -118,9 +128,7 @@ namespace Puzzle1
 	void solve(const std::string& infile)
 	{
 		// Could just use ints or size_t or something really
-		using data_t = std::uint16_t;
-		using row_t = std::vector<data_t>; // let's try 16 bits
-		using jungle_t = std::vector<row_t>;
+		using data_t = std::uint16_t; // let's try 16 bits
 		const int yshift{ 8 };
 		const int xmask{ 0b1111'1111 };
 
@@ -131,123 +139,67 @@ namespace Puzzle1
 			throw std::runtime_error("could not open " + infile);
 		}
 
+		// The map stops at the blank line before the instructions
+		const auto lines{ utils::bufferLinesWhile(inf, [](const std::string &line) -> bool { return line.length(); }) };
+
+		size_t longestRow{ 0 }; // Only for saving the layout to a file 
+		for (auto &&line : lines)
+		{
+			longestRow = std::max(longestRow, line.length());
+		}
+
 		// Our map contains the index of each coord within themselves
 		// 8 bits represent the x index, the other 8 the y index (x right, y left bits)
 		// x of y and 0 are reserved for wrapping, so 0 can be used for its falsiness, if x = 0, don't move there, get it?
-		jungle_t jungleMap2;
-		
-		// Push extra line for top->bottom wrapping values - row[0] will contain y indices for jumps to wrap back to the bottom
-		{
-			std::string tempStr;
-			std::getline(inf, tempStr);
-			// Initialise to the correct size, and as 0s to start
-			jungleMap2.push_back( row_t(tempStr.size() + 2, 0) );
-			inf.seekg(0, std::ios::beg); // back to start of file
-		}
-		
-		jungleMap2.reserve(201); // rows
-		size_t strReserveSize{ 153 }; // columns
-		size_t longestRow{ 0 }; // Only for saving the layout to a file 
-		size_t prevRowLength{ 0 }; // For wrapping bottom->top when current line is shorter than previous line
+		// There's an extra row and column all the way round so every row and column has somewhere for its wrapping values
+		// (not padding as such, since they hold where to wrap to), which makes the coords 1 based like the puzzle's
+		Grid2D<data_t> jungleMap2{ static_cast<int>(longestRow) + 2, static_cast<int>(lines.size()) + 2, 0 };
 
-		// Seg-faults with uint_16 which is interesting!
-		// It might even only seg fault on destruction...
-		std::map<unsigned int, unsigned int> tops; // y row per x col for wrapping top-bottom & bottom-top
-		std::map<unsigned int, unsigned int> bottoms;
+		// Top and bottom row of each column for wrapping top-bottom & bottom-top, 0 for none
+		// Is it not possible that a cube net could stick out twice in a column though? At least this works for my input.
+		std::vector<int> tops(longestRow + 2, 0);
+		std::vector<int> bottoms(longestRow + 2, 0);
 
-		data_t row{ 0 };
-		while (inf)
+		for (int row{ 1 }; row <= static_cast<int>(lines.size()); ++row)
 		{
-			++row;
-			char ch;
-			data_t col{ 1 };
-			inf.get(ch);
-
-			// First char is a newline after the map and before the instructions so we break there
-			if (ch == '\n')
-			{
-				break;
-			}
+			const std::string &line{ lines[static_cast<size_t>(row - 1)] };
 
-			// Start each row with a 0 - this will be replaced by the index of the right-wrap
-			jungleMap2.push_back(row_t(1, 0)); 
-			jungleMap2.back().reserve(strReserveSize);
+			// Leading spaces stay 0s in the map so we can just check for falsiness later
+			const int first{ static_cast<int>(line.find_first_not_of(' ')) + 1 };
+			const int last{ static_cast<int>(line.length()) };
 
-			// Leading spaces - 0s in the map so we can just check for falsiness later
-			while (ch == ' ')
+			for (int col{ first }; col <= last; ++col)
 			{
-				jungleMap2.back().push_back(0);
-				inf.get(ch);
-				++col;
-			}
+				const char ch{ line[static_cast<size_t>(col - 1)] };
 
-			// Value for right->left wrap
-			auto rightToLeftWrap{ ch == '#' ? 0 : col }; 
-			// Ref to first left->right wrap for when we have that value
-			size_t leftJumpI{ static_cast<size_t>(col - 1) };
+				// right bits = col = x coord, left bits = row = y coord, bitwise or to fit them into one number
+				jungleMap2.at(col, row) = ch == '#' ? 0 : static_cast<data_t>(col | (row << yshift));
 
-			// Go through line char by char
-			while (ch != '\n')
-			{
-				// tops map has the x (col) location as the key, y (row) as the value
-				// Is it not possible that a cube net could stick out twice in a column though? At least this works for my input.
-				if (!tops.contains(col))
+				if (!tops[static_cast<size_t>(col)])
 				{
-					tops.insert({ col, row });
+					tops[static_cast<size_t>(col)] = row;
 				}
-				bottoms[col] = row; // Unlike tops, bottoms is updated every row as we go further into the file
-
-				// right bits = col = x coord, left bits = row = y coord, bitwise or to fit them into one number
-				jungleMap2.back().push_back(ch == '#' ? 0 : (col | (row << yshift)));
-				inf.get(ch);
-				++col;
+				bottoms[static_cast<size_t>(col)] = row; // Unlike tops, bottoms is updated every row as we go further into the file
 			}
 
-			// End lines with the x coord of the left wrap index (which is 0 if it's blocked by a #)
-			jungleMap2.back().push_back(rightToLeftWrap);
-
-			// And the left-right wrap index can now be assigned as we've finished the row and found the right index
-			jungleMap2.back()[leftJumpI] = (static_cast<int>((jungleMap2.back().size()) - 2));
-
-			// Want the length of the row before potentially fiddling with it
-			auto prevRowLengthTmp{ prevRowLength }; 
-			prevRowLength = jungleMap2.back().size();
-
-			// Where current line is shorter than previous, we need to add wrapping from bottom to top
-			if (jungleMap2.back().size() < prevRowLengthTmp)
-			{
-				jungleMap2.back().insert(jungleMap2.back().end(), prevRowLengthTmp - jungleMap2.back().size(), 0);
-			}
-
-			// Extend previous lines for edges - doesn't actually happen for my input file
-			// By edge, I mean rows which stick out further than previous ones, meaning we need to add top-bottom wrapping
-			if (auto &prevLine{ jungleMap2[jungleMap2.size() - 2] }; prevLine.size() < jungleMap2.back().size())
-			{
-				prevLine.insert(prevLine.end(), jungleMap2.back().size() - prevLine.size(), 0);	
-			}
-
-			// It's a good bet that the next row will be the same size as the current one
-			strReserveSize = jungleMap2.back().size();
-
-			longestRow = std::max(longestRow, jungleMap2.back().size());
-
-			jungleMap2.back().shrink_to_fit(); // As if it matters here hehe
+			// Either end of the row has the x coord of the other end to wrap to (which is 0 if it's blocked by a #)
+			jungleMap2.at(first - 1, row) = line[static_cast<size_t>(last - 1)] == '#' ? 0 : static_cast<data_t>(last);
+			jungleMap2.at(last + 1, row) = line[static_cast<size_t>(first - 1)] == '#' ? 0 : static_cast<data_t>(first);
 		}
 
-		jungleMap2.push_back(row_t( prevRowLength, 0 ) );
-
-		// Add vertical wrapping in using bottoms and tops maps
-		for (auto &&pair : tops)
+		// Add vertical wrapping in using bottoms and tops
+		// Corners can hold a horizontal and vertical wrap, only the x or y bits are used depending on which way we're moving
+		for (int col{ 1 }; col <= static_cast<int>(longestRow); ++col)
 		{
-			// pair.first = x coord, pair.second = y coord for bottom to wrap back up to
-			// bottoms[pair.first] = y coord for top to wrap down to
-			bool bInaccessible{ jungleMap2[pair.second][pair.first] == 0 || jungleMap2[bottoms[pair.first]][pair.first] == 0 };
-
-			auto bottom{ bInaccessible ? 0 : bottoms[pair.first] << yshift };
-			auto top{ bInaccessible ? 0 : pair.second << yshift };
+			const int top{ tops[static_cast<size_t>(col)] };
+			const int bottom{ bottoms[static_cast<size_t>(col)] };
+			if (!top || !jungleMap2.at(col, top) || !jungleMap2.at(col, bottom))
+			{
+				continue;
+			}
 
-			jungleMap2[pair.second - 1][pair.first] |= bottom;
-			jungleMap2[bottoms[pair.first] + 1][pair.first] |= top;
+			jungleMap2.at(col, top - 1) |= static_cast<data_t>(bottom << yshift);
+			jungleMap2.at(col, bottom + 1) |= static_cast<data_t>(top << yshift);
 		}
 
 		// I only made this block to save the map layouts to a file to make sure it was working properly
@@ -255,7 +207,7 @@ namespace Puzzle1
 		{
 			Logger saveParsedMap{ Logger::defaultDirectoryFile(utils::inputFileName() + "_pt1_parsed"), true, true };
 			// auto &saveParsedMap{ std::cout };
-			auto yMax{ jungleMap2.size() };
+			auto yMax{ static_cast<size_t>(jungleMap2.height()) };
 			auto xMax{ longestRow - 1 };
 			auto maxInd{ std::max(xMax, yMax) };
 			auto charsPerCoord{ (1 + intlogarithm(maxInd)) * 2 + 1 };
@@ -274,7 +226,7 @@ namespace Puzzle1
 				}
 			}
 			saveParsedMap << '\n';
-			for (size_t y{ 0 }; y < jungleMap2.size(); ++y)
+			for (int y{ 0 }; y < jungleMap2.height(); ++y)
 			{
 				auto numChars{ intlogarithm(y) + 1 };
 				while (numChars++ <= charsPerCoord)
@@ -282,9 +234,9 @@ namespace Puzzle1
 					saveParsedMap << ' ';
 				}
 				saveParsedMap << y << '|';
-				for (size_t x{ 0 }; x < jungleMap2[y].size(); ++x)
+				for (int x{ 0 }; x < jungleMap2.width(); ++x)
 				{
-					if (!jungleMap2[y][x])
+					if (!jungleMap2.at(x, y))
 					{
 						for (int i{ 0 }; i <= charsPerCoord; ++i)
 						{
@@ -292,8 +244,8 @@ namespace Puzzle1
 						}
 						continue;
 					}
-					auto xDecode{ jungleMap2[y][x] & xmask };
-					auto yDecode{ jungleMap2[y][x] >> 8 };
+					auto xDecode{ jungleMap2.at(x, y) & xmask };
+					auto yDecode{ jungleMap2.at(x, y) >> 8 };
 
 					saveParsedMap << xDecode << ',' << yDecode;
 
@@ -309,12 +261,8 @@ namespace Puzzle1
 			}
 		}
 		
-		// Offsets of 1 to account for extra col and row we use for jumps
-		size_t xStart{ 1 };
-		while (jungleMap2[1][xStart - 1] == 0)
-		{
-			++xStart;
-		}
+		// Offsets of 1 to account for extra col and row we use for jumps, starting on the leftmost open tile
+		const size_t xStart{ lines[0].find('.') + 1 };
 
 		std::string instructions;
 		std::getline(inf, instructions);
@@ -327,7 +275,7 @@ namespace Puzzle1
 		while (instructionIndex < instructions.size())
 		{
 			// Number of moves in current direction
-			auto count{ std::atoi(instruction.data() + instructionIndex) };
+			auto count{ scan::toInt(instruction.substr(instructionIndex)) };
 
 			while (--count >= 0)
 			{
@@ -336,8 +284,8 @@ namespace Puzzle1
 				// we want to make sure we only take the x or y part depending on which direction we're moving
 				// That is to say, if we're moving horizontally, keep the current y value and vice versa
 				auto coord{ dir.x ?
-					jungleMap2[static_cast<size_t>(loc.y)][static_cast<size_t>(loc.x + dir.x)] :
-					jungleMap2[static_cast<size_t>(loc.y + dir.y)][static_cast<size_t>(loc.x)] };
+					jungleMap2.at(loc.x + dir.x, loc.y) :
+					jungleMap2.at(loc.x, loc.y + dir.y) };
 
 				if (dir.x)
 				{
@@ -692,6 +640,37 @@ namespace Puzzle2
 	int Face::maxInd = 0;
 	int Face::edgesLeftToFind = 24;
 
+	// With --render, the map with the route taken in red
+	void renderRoute(const std::vector<std::string> &route)
+	{
+		size_t longest{ 0 };
+		for (auto &&line : route)
+		{
+			longest = std::max(longest, line.length());
+		}
+
+		const int cell{ 4 };
+		const int height{ static_cast<int>(route.size()) };
+		Image image{ static_cast<int>(longest) * cell, height * cell };
+		image.render([&route, height](int x, int y)
+			{
+				// Image row 0 is the bottom
+				const auto &line{ route[static_cast<size_t>(height - 1 - y / cell)] };
+				const auto col{ static_cast<size_t>(x / cell) };
+				const char ch{ col < line.length() ? line[col] : ' ' };
+
+				switch (ch)
+				{
+				case ' ': return Color{};
+				case '.': return Color{ 0.2f, 0.5f, 0.2f };
+				case '#': return Color{ 0.5f, 0.5f, 0.5f };
+				default:  return Color{ 0.9f, 0.1f, 0.1f };
+				}
+			}, run::current().options.threads);
+
+		image.save(utils::imagePath("route").concat(".bmp").string().c_str(), run::current().options.threads);
+	}
+
 	void solve(const std::string& infile)
 	{
 		std::ifstream inf{ infile };
@@ -727,6 +706,7 @@ namespace Puzzle2
 
 		Face::edgeLength = edgeLength;
 		Face::maxInd = edgeLength - 1; // More useful than edgeLength really
+		Face::edgesLeftToFind = 24; // Static, so reset for running again
 
 		std::vector<Face> faces;
 
@@ -795,7 +775,7 @@ namespace Puzzle2
 		while (instructionIndex < instructions.size())
 		{
 			// Number of moves in current direction
-			auto count{ std::atoi(instruction.data() + instructionIndex) };
+			auto count{ scan::toInt(instruction.substr(instructionIndex)) };
 
 			DL("new moves: " << count << " * " << dir);
 
@@ -954,38 +934,46 @@ namespace Puzzle2
 
 		utils::printAnswer("password on a cube: ", sum);
 
-		// int linenumber{ 0 };
-		// for (auto &&line : route)
-		// {
-		// 	// if (line[0] == 'v')
-		// 	// {
-		// 	// 	DL("error at " << linenumber);
-		// 	// 	break;
-		// 	// }
-		// 	// ++linenumber;
-		// 	DL(line);
-		// }
-
-		
+		if (flags::isSet(flags::Flag::render))
+		{
+			renderRoute(route);
+		}
 	}
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
+	// Same cube net as the puzzle input (the map's limited to 255 across anyway), only the path scales
+	void input(std::ostream &out, double scale, generate::Random &random)
+	{
+		const int face{ 50 };
+		// Where each row of faces starts and how many faces across it is
+		const std::array<std::pair<int, int>, 4> faceRows{ { { 1, 2 }, { 1, 1 }, { 0, 2 }, { 0, 1 } } };
 
-	const std::string input{ utils::inputFile(__FILE__) };
+		for (size_t faceRow{ 0 }; faceRow < faceRows.size(); ++faceRow)
+		{
+			const auto [start, across]{ faceRows[faceRow] };
+			for (int y{ 0 }; y < face; ++y)
+			{
+				std::string line(static_cast<size_t>(start * face), ' ');
+				for (int x{ 0 }; x < across * face; ++x)
+				{
+					// The first open tile on the top row is where we start
+					line += !faceRow && !y && !x ? '.' : random.chance(0.1) ? '#' : '.';
+				}
+				out << line << '\n';
+			}
+		}
 
-	try
-	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
-	{
-		std::cerr << e.what() << '\n';
+		out << '\n' << random.range(1, 50);
+		for (size_t moves{ generate::count(2000, scale) }; moves > 0; --moves)
+		{
+			out << random.pick("LR") << random.range(1, 50);
+		}
+		out << '\n';
 	}
+};
 
-	return 0;
+} // namespace day22
 
-}
+AOC_MAIN(day22)
@@ -7,9 +7,15 @@
 #include <string>
 
 #include "debug.h"	// Enable debug macros with -d flag
+#include "generate.h"
 #include "log.h"	// Enable with -l flag
+#include "registry.h"
 #include "utils.h"
 
+// Rename to the day (day23 etc) - keeps the names apart when all the days are linked into the runner
+namespace dayxx
+{
+
 namespace Puzzle1
 {
 	void solve(const std::string& infile)
@@ -43,22 +49,17 @@ namespace Puzzle2
 	}
 };
 
-int main(int argc, char* argv[])
+namespace Generate
 {
-	flags::set(argc, argv);
-
-	const std::string input{ utils::inputFile(__FILE__) };
-
-	try
+	// Write a made up input in the same format as the puzzle's, scale 1 being about as big (for -x and --sweep)
+	void input(std::ostream &out, double scale, generate::Random &random)
 	{
-		if (utils::doP1()) Puzzle1::solve(input); 
-		if (utils::doP2()) Puzzle2::solve(input);
-	}
-	catch(const std::exception& e)
-	{
-		std::cerr << e.what() << '\n';
+		(void)out;
+		(void)scale;
+		(void)random;
 	}
+};
 
-	return 0;
+} // namespace dayxx
 
-}
+AOC_MAIN(dayxx)
@@ -0,0 +1,560 @@
+// Runs any set of days in one process and times them, e.g. runner 5 11 17-22 -t
+// No day numbers runs everything, the flags are the same as for the single days (-1, -2, -t etc)
+// -j runs the days in parallel on all cores, slowest first (going by timings/ from the previous run), -j4 on 4 threads
+// -b N times each part N more times after the normal run, stats go in timings/benchmark_input.json
+//      and each median is checked against solutions/dayxx/input_baseline_ptx (saved with -s / -o)
+// -r P with -b fails (exit code 1) parts more than P% slower than their baseline, 25% by default
+// -p prints hardware counters for each part, split into the days' PROFILE() phases (-p1 for the parts only)
+// -f json prints the timings table at the end as json instead
+// -x S runs every day on a generated input S times the size of the real one (see include/generate.h), --seed N for another
+// --sweep 1,10,100 runs each day at each scale, prints how the times grow and writes them to timings/sweep_sN.csv
+// Long versions work too: --threads=4 --benchmark 20 --format json etc, see include/options.h
+// Build with all the days linked in:
+// g++ -std=c++20 -O2 -Iinclude -DAOC_RUNNER src/runner.cpp src/day*/day*.cpp -o runner -pthread
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "benchmark.h"
+#include "generate.h"
+#include "profile.h"
+#include "registry.h"
+#include "threadpool.h"
+#include "timer.h"
+#include "utils.h"
+
+namespace runner
+{
+	struct DayTimes
+	{
+		int day;
+		double scale{ 0.0 }; // Of the generated input, 0 for the real one
+		double part[2]{ -1.0, -1.0 }; // -1 if not run, or it threw
+		bool bSuccess{ true };
+
+		// Only with -b
+		benchmark::Stats stats[2];
+		std::uintmax_t inputBytes{ 0 };
+	};
+
+	int benchmarkRepetitions()
+	{
+		return flags::isSet(flags::Flag::benchmark) ? run::current().options.repetitions : 0;
+	}
+
+	// "17-22" -> 17, 18, 19, 20, 21, 22
+	void addDays(std::string_view arg, std::set<int> &days)
+	{
+		const auto dash{ arg.find('-') };
+		const int first{ std::stoi(std::string{ arg.substr(0, dash) }) };
+		const int last{ dash == std::string_view::npos ? first : std::stoi(std::string{ arg.substr(dash + 1) }) };
+
+		for (int day{ first }; day <= last; ++day)
+		{
+			days.insert(day);
+		}
+	}
+
+	// Whatever flags::set didn't take as an option or its value
+	std::set<int> parseDays(const std::vector<std::string> &positional)
+	{
+		std::set<int> days;
+
+		for (const auto &arg : positional)
+		{
+			addDays(arg, days);
+		}
+
+		if (days.empty())
+		{
+			for (const auto &[number, day] : registry::days())
+			{
+				days.insert(number);
+			}
+		}
+		return days;
+	}
+
+	// timings/dayxx/input_timing_pt1 etc, laid out like solutions/
+	std::filesystem::path timingFile(const registry::Day &day, int part)
+	{
+		const std::string dayName{ day.cppFile.stem().string() };
+		return utils::allTimingsDir().append(dayName).append(utils::defaultInputFile() + "_timing_pt" + std::to_string(part));
+	}
+
+	// Days that have never been timed count as the slowest, so they get started early
+	double previousTime(const registry::Day &day)
+	{
+		double total{ 0.0 };
+		for (int part{ 1 }; part <= 2; ++part)
+		{
+			std::ifstream inf{ timingFile(day, part) };
+			double seconds;
+			if (!(inf >> seconds))
+			{
+				return std::numeric_limits<double>::max();
+			}
+			total += seconds;
+		}
+		return total;
+	}
+
+	void saveTimes(const registry::Day &day, const DayTimes &times)
+	{
+		for (int part{ 1 }; part <= 2; ++part)
+		{
+			if (times.part[part - 1] < 0.0)
+				continue;
+
+			const auto file{ timingFile(day, part) };
+			std::filesystem::create_directories(file.parent_path());
+			std::ofstream{ file } << times.part[part - 1] << '\n';
+		}
+	}
+
+	// The normal run has already checked the answer, so the repeats' output is thrown away
+	// Benchmarks run on one thread, which lets us silence days printing straight to std::cout / cerr too
+	bool benchmarkPart(const registry::Day &day, int part, const std::string &input, int repetitions, DayTimes &times)
+	{
+		std::ostream discard{ nullptr };
+		std::ostream* const answersOut{ run::current().out };
+		std::streambuf* const coutBuffer{ std::cout.rdbuf(nullptr) };
+		std::streambuf* const cerrBuffer{ std::cerr.rdbuf(nullptr) };
+		run::current().out = &discard;
+
+		try
+		{
+			times.stats[part - 1] = benchmark::Stats::from(benchmark::repeat([&]() { day.solver(part)(input); }, repetitions, 0));
+			profile::takePhases(); // Only the normal run's are printed
+		}
+		catch(const std::exception& e)
+		{
+			profile::takePhases();
+			std::cout.rdbuf(coutBuffer);
+			std::cout.clear();
+			std::cerr.rdbuf(cerrBuffer);
+			std::cerr.clear();
+			run::current().out = answersOut;
+			run::out() << style::red << utils::DayInfo::day() << " pt" << part << " benchmark: " << e.what() << style::reset << '\n';
+			return false;
+		}
+
+		std::cout.rdbuf(coutBuffer);
+		std::cout.clear();
+		std::cerr.rdbuf(cerrBuffer);
+		std::cerr.clear();
+		run::current().out = answersOut;
+
+		const auto &stats{ times.stats[part - 1] };
+		run::out() << style::cyan << "pt" << part << " x" << stats.count << ": median " << stats.median << "s, min " << stats.min << "s" << style::reset << '\n';
+
+		return utils::DayInfo::tryBaseline(stats.median, part == 2);
+	}
+
+	bool runPart(const registry::Day &day, int part, const std::string &input, DayTimes &times)
+	{
+		utils::bPuzzle2() = part == 2;
+
+		try
+		{
+			Timer timer;
+			{
+				profile::Scope partScope{ part == 1 ? "pt1" : "pt2", 1 };
+				day.solver(part)(input);
+			}
+			times.part[part - 1] = timer.elapsed();
+		}
+		catch(const std::exception& e)
+		{
+			profile::takePhases();
+			run::out() << style::red << utils::DayInfo::day() << " pt" << part << ": " << e.what() << style::reset << '\n';
+			return false;
+		}
+
+		run::out() << style::cyan << "pt" << part << ": " << times.part[part - 1] << "s" << style::reset << '\n';
+		profile::print(run::out(), profile::takePhases());
+
+		if (const int repetitions{ benchmarkRepetitions() })
+		{
+			return benchmarkPart(day, part, input, repetitions, times);
+		}
+		return true;
+	}
+
+	// Uses the thread's active run::Context, sets times.bSuccess false if either part threw
+	void runDay(const registry::Day &day, DayTimes &times)
+	{
+		utils::DayInfo::reset();
+
+		if (times.scale > 0.0)
+		{
+			run::current().options.scale = times.scale;
+			flags::set(flags::Flag::scale);
+			try
+			{
+				day.useGenerated();
+			}
+			catch(const std::exception& e)
+			{
+				run::out() << style::red << "day " << day.number << " x" << times.scale << ": " << e.what() << style::reset << '\n';
+				times.bSuccess = false;
+				return;
+			}
+		}
+		const std::string input{ utils::inputFile(day.cppFile) };
+
+		run::out() << style::bold << "--- " << utils::DayInfo::day();
+		if (times.scale > 0.0)
+		{
+			run::out() << " x" << times.scale;
+		}
+		run::out() << " ---" << style::reset << '\n';
+
+		std::error_code error;
+		times.inputBytes = std::filesystem::file_size(input, error);
+
+		if (utils::doP1()) times.bSuccess &= runPart(day, 1, input, times);
+		if (utils::doP2()) times.bSuccess &= runPart(day, 2, input, times);
+	}
+
+	// Each day gets its own context, so its output is kept together when running in parallel
+	// A day's scales (one after another in days) run in the same job, one at a time, because some days keep state in statics
+	void runAll(const std::vector<const registry::Day*> &days, std::vector<DayTimes> &allTimes, unsigned threads)
+	{
+		// [first, last) of days for each day
+		std::vector<std::pair<size_t, size_t>> jobs;
+		for (size_t i{ 0 }; i < days.size(); ++i)
+		{
+			if (jobs.empty() || days[jobs.back().first] != days[i])
+			{
+				jobs.push_back({ i, i });
+			}
+			jobs.back().second = i + 1;
+		}
+
+		// Slowest first
+		std::vector<double> expected(jobs.size());
+		for (size_t job{ 0 }; job < jobs.size(); ++job)
+		{
+			for (size_t i{ jobs[job].first }; i < jobs[job].second; ++i)
+			{
+				expected[job] += previousTime(*days[i]) * std::max(allTimes[i].scale, 1.0);
+			}
+		}
+		std::vector<size_t> order(jobs.size());
+		for (size_t job{ 0 }; job < jobs.size(); ++job)
+		{
+			order[job] = job;
+		}
+		std::stable_sort(order.begin(), order.end(), [&expected](size_t lhs, size_t rhs) { return expected[lhs] > expected[rhs]; });
+
+		const bool bBuffered{ threads > 1 };
+		const run::Context &base{ run::current() };
+		std::mutex printMutex;
+
+		ThreadPool pool{ threads };
+		for (size_t job : order)
+		{
+			pool.push([&, job]()
+			{
+				for (size_t i{ jobs[job].first }; i < jobs[job].second; ++i)
+				{
+					run::Context context{ base.flags, base.options };
+					std::ostringstream output;
+					if (bBuffered)
+					{
+						context.out = &output;
+						context.options.threads = 1; // The cores are already busy with other days, -j isn't also each day's thread count
+					}
+					run::Scope scope{ context };
+
+					runDay(*days[i], allTimes[i]);
+
+					if (bBuffered)
+					{
+						std::lock_guard lock{ printMutex };
+						std::cout << output.str();
+					}
+				}
+			});
+		}
+		pool.wait();
+	}
+
+	void printTime(double seconds)
+	{
+		if (seconds < 0.0)
+			std::cout << std::setw(12) << "-";
+		else
+			std::cout << std::setw(12) << seconds;
+	}
+
+	void printTimes(const std::vector<DayTimes> &allTimes, double totalSeconds)
+	{
+		std::cout << std::fixed << std::setprecision(6);
+		std::cout << style::bold << '\n' << std::setw(6) << "day" << std::setw(12) << "pt1" << std::setw(12) << "pt2" << std::setw(12) << "total" << style::reset << '\n';
+
+		for (const auto &times : allTimes)
+		{
+			std::cout << std::setw(6) << times.day;
+			printTime(times.part[0]);
+			printTime(times.part[1]);
+			printTime(std::max(times.part[0], 0.0) + std::max(times.part[1], 0.0));
+			std::cout << '\n';
+		}
+
+		std::cout << style::bold << "total wall time: " << totalSeconds << "s" << style::reset << '\n';
+	}
+
+	// -1 for parts that didn't run, like the table's "-"
+	void printTimesJson(const std::vector<DayTimes> &allTimes, double totalSeconds)
+	{
+		std::cout << std::setprecision(9);
+		std::cout << "{\n  \"input\": \"" << utils::defaultInputFile() << "\",\n  \"total_seconds\": " << totalSeconds << ",\n  \"days\": [";
+
+		bool bFirst{ true };
+		for (const auto &times : allTimes)
+		{
+			std::cout << (bFirst ? "\n" : ",\n");
+			std::cout << "    { \"day\": " << times.day << ", \"pt1\": " << times.part[0] << ", \"pt2\": " << times.part[1]
+				<< ", \"success\": " << (times.bSuccess ? "true" : "false") << " }";
+			bFirst = false;
+		}
+		std::cout << "\n  ]\n}\n";
+	}
+
+	double totalTime(const DayTimes &times)
+	{
+		return std::max(times.part[0], 0.0) + std::max(times.part[1], 0.0);
+	}
+
+	// Each day's times against input size, growth is how the time scales with the size since the row before
+	// (log time / log size, so 1 is linear, 2 quadratic), the bar is the total on a log scale
+	void printSweep(const std::vector<DayTimes> &allTimes)
+	{
+		std::cout << std::fixed << std::setprecision(6);
+		std::cout << style::bold << '\n' << std::setw(6) << "day" << std::setw(10) << "scale" << std::setw(14) << "input bytes"
+			<< std::setw(12) << "pt1" << std::setw(12) << "pt2" << std::setw(8) << "growth" << style::reset << '\n';
+
+		for (size_t first{ 0 }; first < allTimes.size();)
+		{
+			size_t last{ first };
+			double fastest{ std::numeric_limits<double>::max() };
+			double slowest{ 0.0 };
+			for (; last < allTimes.size() && allTimes[last].day == allTimes[first].day; ++last)
+			{
+				if (totalTime(allTimes[last]) > 0.0)
+				{
+					fastest = std::min(fastest, totalTime(allTimes[last]));
+					slowest = std::max(slowest, totalTime(allTimes[last]));
+				}
+			}
+
+			for (size_t i{ first }; i < last; ++i)
+			{
+				const auto &times{ allTimes[i] };
+				std::cout << std::setw(6) << times.day << std::setw(10) << std::setprecision(2) << times.scale
+					<< std::setw(14) << times.inputBytes << std::setprecision(6);
+				printTime(times.part[0]);
+				printTime(times.part[1]);
+
+				const auto &previous{ allTimes[i - (i > first)] };
+				if (i > first && totalTime(previous) > 0.0 && totalTime(times) > 0.0 && times.inputBytes > previous.inputBytes && previous.inputBytes)
+				{
+					const double growth{ std::log(totalTime(times) / totalTime(previous))
+						/ std::log(static_cast<double>(times.inputBytes) / static_cast<double>(previous.inputBytes)) };
+					std::cout << std::setw(8) << std::setprecision(2) << growth << std::setprecision(6);
+				}
+				else
+				{
+					std::cout << std::setw(8) << "-";
+				}
+
+				const int width{ 30 };
+				int bar{ 1 };
+				if (slowest > fastest && totalTime(times) > 0.0)
+				{
+					bar += static_cast<int>(width * std::log(totalTime(times) / fastest) / std::log(slowest / fastest));
+				}
+				std::cout << "  " << style::cyan << std::string(ST(bar), '#') << style::reset << '\n';
+			}
+			first = last;
+		}
+	}
+
+	// timings/sweep_s2022.csv, for plotting
+	void saveSweep(const std::vector<DayTimes> &allTimes)
+	{
+		const auto file{ utils::allTimingsDir().append("sweep_s" + std::to_string(run::current().options.seed) + ".csv") };
+		std::filesystem::create_directories(file.parent_path());
+
+		std::ofstream csv{ file };
+		if (!csv)
+		{
+			std::cerr << "could not write to file " << file << '\n';
+			return;
+		}
+
+		csv << std::setprecision(9) << "day,scale,input_bytes,pt1_seconds,pt2_seconds\n";
+		for (const auto &times : allTimes)
+		{
+			csv << times.day << ',' << times.scale << ',' << times.inputBytes << ',' << times.part[0] << ',' << times.part[1] << '\n';
+		}
+
+		std::cout << "sweep results written to " << file.string() << '\n';
+	}
+
+	// Generated inputs get a file of their own so they never overwrite the real input's results
+	std::string benchmarkName()
+	{
+		const auto &options{ run::current().options };
+		if (!options.sweep.empty())
+			return "sweep_s" + std::to_string(options.seed);
+		if (flags::isSet(flags::Flag::scale))
+			return std::filesystem::path{ generate::inputName(options.scale, options.seed) }.filename().string();
+		return utils::defaultInputFile();
+	}
+
+	// timings/benchmark_input.json, one result per part run
+	void saveBenchmark(const std::vector<DayTimes> &allTimes, int repetitions)
+	{
+		const auto file{ utils::allTimingsDir().append("benchmark_" + benchmarkName() + ".json") };
+		std::filesystem::create_directories(file.parent_path());
+
+		std::ofstream json{ file };
+		if (!json)
+		{
+			std::cerr << "could not write to file " << file << '\n';
+			return;
+		}
+
+		json << std::setprecision(9);
+		json << "{\n  \"input\": \"" << benchmarkName() << "\",\n  \"repetitions\": " << repetitions << ",\n  \"results\": [";
+
+		bool bFirst{ true };
+		for (const auto &times : allTimes)
+		{
+			for (int part{ 1 }; part <= 2; ++part)
+			{
+				const auto &stats{ times.stats[part - 1] };
+				if (!stats.count)
+					continue;
+
+				const double throughput{ stats.median > 0.0 ? static_cast<double>(times.inputBytes) / stats.median : 0.0 };
+
+				json << (bFirst ? "\n" : ",\n");
+				json << "    { \"day\": " << times.day;
+				if (times.scale > 0.0)
+				{
+					json << ", \"scale\": " << times.scale;
+				}
+				json << ", \"part\": " << part
+					<< ", \"min\": " << stats.min << ", \"median\": " << stats.median << ", \"p95\": " << stats.p95
+					<< ", \"mean\": " << stats.mean << ", \"stddev\": " << stats.stddev
+					<< ", \"input_bytes\": " << times.inputBytes << ", \"bytes_per_second\": " << throughput << " }";
+				bFirst = false;
+			}
+		}
+		json << "\n  ]\n}\n";
+
+		std::cout << "benchmark results written to " << file.string() << '\n';
+	}
+};
+
+int main(int argc, char* argv[])
+{
+	const auto positional{ flags::set(argc, argv) };
+
+	std::set<int> numbers;
+	try
+	{
+		numbers = runner::parseDays(positional);
+	}
+	catch(const std::exception& e)
+	{
+		std::cerr << "could not read day numbers: " << e.what() << '\n';
+		return 1;
+	}
+
+	// An entry per day and scale, the real input is scale 0
+	const auto &options{ run::current().options };
+	std::vector<double> scales{ options.sweep };
+	if (scales.empty())
+	{
+		scales.push_back(flags::isSet(flags::Flag::scale) ? options.scale : 0.0);
+	}
+
+	std::vector<const registry::Day*> days;
+	std::vector<runner::DayTimes> allTimes;
+	for (int number : numbers)
+	{
+		const auto found{ registry::days().find(number) };
+		if (found == registry::days().end())
+		{
+			std::cerr << style::yellow << "no solutions registered for day " << number << style::reset << '\n';
+			continue;
+		}
+		for (double scale : scales)
+		{
+			runner::DayTimes times{};
+			times.day = number;
+			times.scale = scale;
+			days.push_back(&found->second);
+			allTimes.push_back(times);
+		}
+	}
+
+	const int repetitions{ runner::benchmarkRepetitions() };
+	if (repetitions && flags::isSet(flags::Flag::parallel))
+	{
+		std::cerr << style::yellow << "benchmarking runs one day at a time, ignoring -j" << style::reset << '\n';
+	}
+	unsigned threads{ 1 };
+	if (flags::isSet(flags::Flag::parallel) && !repetitions)
+	{
+		threads = run::current().options.threads ? run::current().options.threads : std::thread::hardware_concurrency();
+	}
+
+	Timer total;
+	runner::runAll(days, allTimes, threads);
+	const double totalSeconds{ total.elapsed() };
+
+	bool bSuccess{ true };
+	for (size_t i{ 0 }; i < days.size(); ++i)
+	{
+		if (allTimes[i].scale == 0.0)
+		{
+			runner::saveTimes(*days[i], allTimes[i]); // Only the real inputs' times are worth keeping
+		}
+		bSuccess &= allTimes[i].bSuccess;
+	}
+
+	if (!options.sweep.empty())
+	{
+		runner::printSweep(allTimes);
+		runner::saveSweep(allTimes);
+	}
+	else if (options.format == options::Format::json)
+		runner::printTimesJson(allTimes, totalSeconds);
+	else
+		runner::printTimes(allTimes, totalSeconds);
+	if (repetitions)
+	{
+		runner::saveBenchmark(allTimes, repetitions);
+	}
+
+	return bSuccess ? 0 : 1;
+}